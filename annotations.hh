@@ -0,0 +1,107 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/file/standard/error.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+
+namespace snn::app::annotations
+{
+    // Annotations for running an application, in a comment (or after an `#include`) at the top of
+    // its source file, e.g.:
+    // // [#test:timeout=60] [#test:threads=4] [#test:memory=2G]
+    // Or `[#test:serial]` for an application that must run alone (e.g. it uses a fixed port or
+    // measures time).
+    struct test final
+    {
+        u64 timeout_ns = 0;    // Zero if not set.
+        u64 memory     = 0;    // Peak memory in bytes, zero if not set.
+        usize threads  = 1;    // CPUs the application keeps busy.
+        bool serial    = false;
+    };
+
+    namespace detail
+    {
+        [[nodiscard]] inline bool parse_test_item(const cstrview item, test& t)
+        {
+            if (item == "serial")
+            {
+                t.serial = true;
+                return true;
+            }
+
+            const usize eq = item.find('=').value_or_npos();
+            if (eq == constant::npos)
+            {
+                return false;
+            }
+
+            const cstrview name  = item.view(0, eq);
+            const cstrview value = item.view(eq + 1);
+            if (name == "timeout")
+            {
+                // Seconds (at most a day).
+                const auto seconds = number::parse(value);
+                if (seconds && seconds.value() > 0 && seconds.value() <= 86'400)
+                {
+                    t.timeout_ns = seconds.value() * 1'000'000'000;
+                    return true;
+                }
+            }
+            else if (name == "threads")
+            {
+                const auto threads = number::parse(value);
+                if (threads && threads.value() > 0 && threads.value() <= 4096)
+                {
+                    t.threads = static_cast<usize>(threads.value());
+                    return true;
+                }
+            }
+            else if (name == "memory")
+            {
+                const auto size = number::parse_size(value);
+                if (size)
+                {
+                    t.memory = size.value();
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    // Parse `[#test:name=value]` annotations in a line, returns false (with an error message) if
+    // an annotation is invalid.
+    [[nodiscard]] inline bool parse_test(const cstrview line, test& t)
+    {
+        const usize pos = line.find("[#test:").value_or_npos();
+        if (pos == constant::npos)
+        {
+            return true;
+        }
+
+        for (cstrview word : string::range::split{line.view(pos), ' '})
+        {
+            if (!word.has_front("[#test:") || !word.has_back(']'))
+            {
+                continue;
+            }
+
+            const cstrview annotation = word;
+
+            word.drop_front_n(string_size("[#test:"));
+            word.drop_back_n(string_size("]"));
+
+            if (!detail::parse_test_item(word, t))
+            {
+                fmt::print_error_line("Error: Invalid annotation: {}", annotation);
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
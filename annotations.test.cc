@@ -0,0 +1,52 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/annotations.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            app::annotations::test t;
+            snn_require(app::annotations::parse_test("// Nothing here.", t));
+            snn_require(app::annotations::parse_test("#include \"a.hh\" // [#lib:z]", t));
+            snn_require(t.timeout_ns == 0);
+
+            snn_require(app::annotations::parse_test("// [#test:timeout=60]", t));
+            snn_require(t.timeout_ns == 60'000'000'000);
+
+            snn_require(app::annotations::parse_test("// Slow [#test:timeout=5] (I/O).", t));
+            snn_require(t.timeout_ns == 5'000'000'000);
+        }
+        {
+            app::annotations::test t;
+            snn_require(t.threads == 1);
+            snn_require(t.memory == 0);
+            snn_require(!t.serial);
+
+            snn_require(app::annotations::parse_test(
+                "// [#test:threads=4] [#test:memory=2G] [#test:serial]", t));
+            snn_require(t.threads == 4);
+            snn_require(t.memory == u64{2} << 30);
+            snn_require(t.serial);
+        }
+        {
+            app::annotations::test t;
+            snn_require(!app::annotations::parse_test("// [#test:timeout=0]", t));
+            snn_require(!app::annotations::parse_test("// [#test:timeout=86401]", t));
+            snn_require(!app::annotations::parse_test("// [#test:timeout=1m]", t));
+            snn_require(!app::annotations::parse_test("// [#test:timeout]", t));
+            snn_require(!app::annotations::parse_test("// [#test:unknown=1]", t));
+            snn_require(!app::annotations::parse_test("// [#test:threads=0]", t));
+            snn_require(!app::annotations::parse_test("// [#test:memory=2gb]", t));
+            snn_require(!app::annotations::parse_test("// [#test:serial=1]", t));
+            snn_require(t.timeout_ns == 0);
+            snn_require(t.threads == 1);
+            snn_require(t.memory == 0);
+            snn_require(!t.serial);
+        }
+    }
+}
@@ -0,0 +1,454 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/file/path/split.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/set/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+#include "build-tool/resources.hh"
+#include <sys/types.h> // pid_t
+
+namespace snn::app::bundle
+{
+    // Tests (`*.test.cc`) linked into a single executable. Each test is compiled with its
+    // `unittest` function (and the `main` function it gets from "snn-core/unittest.hh") renamed
+    // by a macro, a generated driver calls the renamed functions one at a time, each in a forked
+    // child. A failing test can't take the others down and still has its own exit status and
+    // resource usage, but there is only one link and one exec per bundle.
+    //
+    // Tests that define symbols with external linkage (outside of an anonymous namespace) with
+    // the same name can't be bundled together, they fail to link.
+    struct group final
+    {
+        str executable; // E.g. "dir/snn-bundle-1"
+        str driver;     // Generated source, e.g. "dir/snn-bundle-1.cc"
+        vec<str> tests; // Sources
+    };
+
+    [[nodiscard]] inline bool is_test(const cstrview source) noexcept
+    {
+        return source.has_back(".test.cc");
+    }
+
+    // Object file of a test compiled for a bundle, e.g. "dir/a.test.bundle.o".
+    [[nodiscard]] inline str object(const cstrview test)
+    {
+        return concat(test.view_offset(0, -3), ".bundle.o");
+    }
+
+    // Renamed `unittest` function of the test at `index` (in the `snn` namespace).
+    [[nodiscard]] inline str unittest_name(const usize index)
+    {
+        str name = "snn_bundle_unittest_";
+        name << as_num(index);
+        return name;
+    }
+
+    // Macro definitions for the test at `index`.
+    [[nodiscard]] inline str macros(const usize index)
+    {
+        str s = "-Dunittest=";
+        s << unittest_name(index) << " -Dmain=snn_bundle_main_" << as_num(index);
+        return s;
+    }
+
+    // Group tests by directory with at most `size` tests per bundle. Applications that aren't
+    // tests are not bundled.
+    [[nodiscard]] inline vec<group> partition(const set::sorted<str>& applications,
+                                              const usize size)
+    {
+        vec<group> groups;
+        map::sorted<str, usize> current; // Directory -> index of its last group.
+        map::sorted<str, usize> numbers; // Directory -> number of groups.
+
+        for (const auto& source : applications)
+        {
+            if (!is_test(source))
+            {
+                continue;
+            }
+
+            const auto [dir, base, ext] = file::path::split<cstrview>(source).value();
+
+            if (const auto index = current.get(dir))
+            {
+                group& g = groups.at(index.value(), promise::within_bounds);
+                if (g.tests.count() < size)
+                {
+                    g.tests.append(source);
+                    continue;
+                }
+            }
+
+            usize& number = numbers.insert_inplace(dir).value();
+            ++number;
+
+            group g;
+            g.executable << dir << "snn-bundle-" << as_num(number);
+            g.driver = concat(g.executable, ".cc");
+            g.tests.append(source);
+
+            current.insert_or_assign(dir, groups.count());
+            groups.append(std::move(g));
+        }
+
+        return groups;
+    }
+
+    // Driver source for a bundle of tests with the given timeouts (nanoseconds, zero for none).
+    // The driver takes a report file as its only argument and writes one line per test (tab
+    // separated):
+    // <index> <exit-status> <signal> <start-ns> <wall-ns> <user-ns> <system-ns> <max-rss-kib>
+    // <minor-faults> <major-faults> <voluntary-switches> <involuntary-switches> <block-input>
+    // <block-output>
+    // And before each test (so that a hung test can be found): start <index> <pid> <start-ns>
+    // Start times are CLOCK_MONOTONIC nanoseconds (see `clock::monotonic`).
+    // A test that runs longer than its timeout is sent SIGABRT (a core dump if enabled,
+    // sanitizers print a stack trace) and SIGKILL if it is still running after a grace period,
+    // before its report line the driver writes: timeout <index>
+    // It stops after the first failing test.
+    [[nodiscard]] inline strbuf driver_source(const vec<u64>& timeouts)
+    {
+        const usize count = timeouts.count();
+
+        strbuf src{container::reserve, 4096 + count * 96};
+
+        src << "// Generated by snn (runall --bundle).\n\n";
+        src << R"src(#include <sys/resource.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <unistd.h>
+
+namespace snn
+{
+)src";
+
+        for (usize i = 0; i < count; ++i)
+        {
+            src << "    void " << unittest_name(i) << "();\n";
+        }
+
+        src << R"src(}
+
+namespace
+{
+    using test_function = void (*)();
+
+    constexpr test_function tests[] = {
+)src";
+
+        for (usize i = 0; i < count; ++i)
+        {
+            src << "        snn::" << unittest_name(i) << ",\n";
+        }
+
+        src << R"src(    };
+
+    // Nanoseconds, zero for none.
+    constexpr unsigned long long timeouts[] = {
+)src";
+
+        for (const u64 timeout : timeouts)
+        {
+            src << "        " << as_num(timeout) << "ULL,\n";
+        }
+
+        src << R"src(    };
+
+    constexpr unsigned long long grace_ns = 2'000'000'000ULL; // After SIGABRT.
+
+    unsigned long long monotonic() noexcept
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<unsigned long long>(ts.tv_sec) * 1'000'000'000ULL +
+               static_cast<unsigned long long>(ts.tv_nsec);
+    }
+
+    unsigned long long nanoseconds(const timeval& tv) noexcept
+    {
+        return static_cast<unsigned long long>(tv.tv_sec) * 1'000'000'000ULL +
+               static_cast<unsigned long long>(tv.tv_usec) * 1'000ULL;
+    }
+
+    timespec duration(const unsigned long long ns) noexcept
+    {
+        timespec ts{};
+        ts.tv_sec  = static_cast<time_t>(ns / 1'000'000'000ULL);
+        ts.tv_nsec = static_cast<long>(ns % 1'000'000'000ULL);
+        return ts;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::fputs("Usage: <bundle> <report-file>\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    std::FILE* const report = std::fopen(argv[1], "w");
+    if (report == nullptr)
+    {
+        std::fputs("Error: Failed to open report file\n", stderr);
+        return EXIT_FAILURE;
+    }
+
+    // SIGCHLD is blocked and waited for with a timeout (`sigtimedwait`), so a test that exits
+    // is reaped at once and one that doesn't is found without polling.
+    std::signal(SIGCHLD, SIG_DFL); // Not ignored (children would be reaped automatically).
+    sigset_t child_exited;
+    sigset_t previous_mask;
+    sigemptyset(&child_exited);
+    sigaddset(&child_exited, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &child_exited, &previous_mask);
+
+    int exit_status    = EXIT_SUCCESS;
+    unsigned int index = 0;
+    for (const test_function test : tests)
+    {
+        std::fflush(nullptr); // Don't duplicate buffered output in the child.
+
+        const unsigned long long start = monotonic();
+        const pid_t pid                = fork();
+        if (pid < 0)
+        {
+            std::fputs("Error: Failed to fork\n", stderr);
+            exit_status = EXIT_FAILURE;
+            break;
+        }
+
+        if (pid == 0)
+        {
+            sigprocmask(SIG_SETMASK, &previous_mask, nullptr);
+            test();
+            std::exit(EXIT_SUCCESS);
+        }
+
+        std::fprintf(report, "start\t%u\t%ld\t%llu\n", index, static_cast<long>(pid), start);
+        std::fflush(report);
+
+        const unsigned long long timeout = timeouts[index];
+
+        int status = 0;
+        rusage usage{};
+        bool aborted = false;
+        bool killed  = false;
+        for (;;)
+        {
+            const pid_t waited = wait4(pid, &status, WNOHANG, &usage);
+            if (waited == pid)
+            {
+                break;
+            }
+            if (waited < 0 && errno != EINTR)
+            {
+                std::fclose(report);
+                return EXIT_FAILURE;
+            }
+
+            // Time until the next deadline (a second if there is none, SIGCHLD ends the wait).
+            const unsigned long long elapsed = monotonic() - start;
+            unsigned long long wait_ns       = 1'000'000'000ULL;
+            if (timeout > 0 && !aborted)
+            {
+                if (elapsed >= timeout)
+                {
+                    std::fprintf(report, "timeout\t%u\n", index);
+                    std::fflush(report);
+                    kill(pid, SIGABRT);
+                    aborted = true;
+                }
+                else
+                {
+                    wait_ns = timeout - elapsed;
+                }
+            }
+            if (aborted && !killed)
+            {
+                if (elapsed >= timeout + grace_ns)
+                {
+                    kill(pid, SIGKILL);
+                    killed = true;
+                }
+                else
+                {
+                    wait_ns = timeout + grace_ns - elapsed;
+                }
+            }
+
+            const timespec ts = duration(wait_ns);
+            sigtimedwait(&child_exited, nullptr, &ts);
+        }
+        const unsigned long long wall_ns = monotonic() - start;
+
+        const int child_status = WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+        const int child_signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+
+        std::fprintf(report,
+                     "%u\t%d\t%d\t%llu\t%llu\t%llu\t%llu\t%ld\t%ld\t%ld\t%ld\t%ld\t%ld\t%ld\n",
+                     index, child_status, child_signal, start, wall_ns, nanoseconds(usage.ru_utime),
+                     nanoseconds(usage.ru_stime), usage.ru_maxrss, usage.ru_minflt,
+                     usage.ru_majflt, usage.ru_nvcsw, usage.ru_nivcsw, usage.ru_inblock,
+                     usage.ru_oublock);
+        std::fflush(report);
+
+        if (child_status != EXIT_SUCCESS)
+        {
+            exit_status = child_status;
+            break;
+        }
+
+        ++index;
+    }
+
+    if (std::fclose(report) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    return exit_status;
+}
+)src";
+
+        return src;
+    }
+
+    // One line of a driver report.
+    struct outcome final
+    {
+        usize index     = 0;
+        int exit_status = 0;
+        int signal      = 0;     // Non-zero if the test was terminated by a signal.
+        bool timed_out  = false; // Killed by the driver (the signal is SIGABRT or SIGKILL).
+        u64 start_ns    = 0;     // CLOCK_MONOTONIC time the test was started.
+        resources::usage usage;
+
+        [[nodiscard]] constexpr bool passed() const noexcept
+        {
+            return exit_status == 0 && signal == 0 && !timed_out;
+        }
+    };
+
+    // Parse a driver report of a bundle with `count` tests, returns `nullopt` if it is invalid.
+    [[nodiscard]] inline optional<vec<outcome>> parse_report(const cstrview contents,
+                                                             const usize count)
+    {
+        vec<outcome> outcomes;
+        vec<cstrview> fields;
+        optional<u64> timed_out; // Index.
+        for (const cstrview line : string::range::split{contents, '\n'})
+        {
+            if (line.is_empty() || line.has_front("start\t"))
+            {
+                continue;
+            }
+
+            if (line.has_front("timeout\t"))
+            {
+                timed_out = number::parse(line.view(8));
+                if (!timed_out || timed_out.value() >= count)
+                {
+                    return nullopt;
+                }
+                continue;
+            }
+
+            fields.clear();
+            for (const cstrview field : string::range::split{line, '\t'})
+            {
+                fields.append(field);
+            }
+
+            constexpr usize field_count = 14;
+            if (fields.count() != field_count)
+            {
+                return nullopt;
+            }
+
+            u64 values[field_count] = {};
+            for (usize i = 0; i < field_count; ++i)
+            {
+                const auto n = number::parse(fields.at(i, promise::within_bounds));
+                if (!n)
+                {
+                    return nullopt;
+                }
+                values[i] = n.value(promise::has_value);
+            }
+
+            if (values[0] >= count || values[1] > 255 || values[2] > 255)
+            {
+                return nullopt;
+            }
+
+            outcome o;
+            o.index           = static_cast<usize>(values[0]);
+            o.exit_status     = static_cast<int>(values[1]);
+            o.signal          = static_cast<int>(values[2]);
+            o.timed_out       = timed_out && timed_out.value() == values[0];
+            o.start_ns        = values[3];
+            o.usage.wall_ns   = values[4];
+            o.usage.user_ns   = values[5];
+            o.usage.system_ns = values[6];
+            o.usage.max_rss   = values[7] * 1024; // `ru_maxrss` is in kilobytes.
+
+            o.usage.minor_faults         = values[8];
+            o.usage.major_faults         = values[9];
+            o.usage.voluntary_switches   = values[10];
+            o.usage.involuntary_switches = values[11];
+            o.usage.block_input          = values[12];
+            o.usage.block_output         = values[13];
+            outcomes.append(o);
+        }
+        return outcomes;
+    }
+
+    struct running_test final
+    {
+        usize index  = 0;
+        pid_t pid    = 0;
+        u64 start_ns = 0; // CLOCK_MONOTONIC time the test was started.
+    };
+
+    // The test that was started last and hasn't finished (e.g. hung), if any.
+    [[nodiscard]] inline optional<running_test> running(const cstrview report)
+    {
+        optional<running_test> current;
+        for (const cstrview line : string::range::split{report, '\n'})
+        {
+            vec<cstrview> fields;
+            for (const cstrview field : string::range::split{line, '\t'})
+            {
+                fields.append(field);
+            }
+
+            if (fields.count() == 4 && fields.at(0, promise::within_bounds) == "start")
+            {
+                const auto index = number::parse(fields.at(1, promise::within_bounds));
+                const auto pid   = number::parse(fields.at(2, promise::within_bounds));
+                const auto start = number::parse(fields.at(3, promise::within_bounds));
+                if (index && pid && start && pid.value() > 0 && pid.value() <= 0x7fff'ffff)
+                {
+                    current = running_test{static_cast<usize>(index.value()),
+                                           static_cast<pid_t>(pid.value()), start.value()};
+                }
+            }
+            else if (fields.count() > 4)
+            {
+                current = nullopt; // Finished.
+            }
+        }
+        return current;
+    }
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/bundle.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            snn_require(app::bundle::is_test("a/b.test.cc"));
+            snn_require(!app::bundle::is_test("a/b.cc"));
+
+            snn_require(app::bundle::object("a/b.test.cc") == "a/b.test.bundle.o");
+            snn_require(app::bundle::unittest_name(3) == "snn_bundle_unittest_3");
+            snn_require(app::bundle::macros(3) ==
+                        "-Dunittest=snn_bundle_unittest_3 -Dmain=snn_bundle_main_3");
+        }
+        {
+            set::sorted<str> applications;
+            applications.insert("a/x.test.cc");
+            applications.insert("a/b/y.test.cc");
+            applications.insert("a/y.test.cc");
+            applications.insert("a/z.test.cc");
+            applications.insert("a/tool.cc");
+            applications.insert("w.test.cc");
+
+            const auto groups = app::bundle::partition(applications, 2);
+            snn_require(groups.count() == 4);
+
+            const auto& b = groups.at(0).value();
+            snn_require(b.executable == "a/b/snn-bundle-1");
+            snn_require(b.driver == "a/b/snn-bundle-1.cc");
+            snn_require(b.tests.count() == 1);
+
+            const auto& a1 = groups.at(1).value();
+            snn_require(a1.executable == "a/snn-bundle-1");
+            snn_require(a1.tests.count() == 2);
+            snn_require(a1.tests.at(0).value() == "a/x.test.cc");
+            snn_require(a1.tests.at(1).value() == "a/y.test.cc");
+
+            const auto& a2 = groups.at(2).value();
+            snn_require(a2.executable == "a/snn-bundle-2");
+            snn_require(a2.tests.count() == 1);
+            snn_require(a2.tests.at(0).value() == "a/z.test.cc");
+
+            const auto& w = groups.at(3).value();
+            snn_require(w.executable == "snn-bundle-1");
+            snn_require(w.tests.count() == 1);
+        }
+        {
+            vec<u64> timeouts;
+            timeouts.append(0);
+            timeouts.append(60'000'000'000);
+
+            const auto src = app::bundle::driver_source(timeouts);
+            snn_require(src.contains("    void snn_bundle_unittest_0();\n"));
+            snn_require(src.contains("    void snn_bundle_unittest_1();\n"));
+            snn_require(src.contains("        snn::snn_bundle_unittest_1,\n"));
+            snn_require(!src.contains("snn_bundle_unittest_2"));
+            snn_require(src.contains("        0ULL,\n        60000000000ULL,\n    };"));
+            snn_require(src.contains("int main(int argc, char** argv)"));
+        }
+        {
+            const auto outcomes = app::bundle::parse_report(
+                "start\t0\t100\t7000\n"
+                "0\t0\t0\t7000\t2000\t1000\t500\t4\t10\t1\t5\t2\t8\t16\n"
+                "start\t1\t101\t9000\n"
+                "1\t1\t6\t9000\t3000\t0\t0\t8\t0\t0\t0\t0\t0\t0\n",
+                2);
+            snn_require(outcomes);
+            snn_require(outcomes.value().count() == 2);
+
+            const auto& first = outcomes.value().at(0).value();
+            snn_require(first.index == 0);
+            snn_require(first.passed());
+            snn_require(first.start_ns == 7000);
+            snn_require(first.usage.wall_ns == 2000);
+            snn_require(first.usage.cpu_ns() == 1500);
+            snn_require(first.usage.max_rss == 4096);
+            snn_require(first.usage.minor_faults == 10);
+            snn_require(first.usage.major_faults == 1);
+            snn_require(first.usage.voluntary_switches == 5);
+            snn_require(first.usage.involuntary_switches == 2);
+            snn_require(first.usage.block_input == 8);
+            snn_require(first.usage.block_output == 16);
+
+            const auto& second = outcomes.value().at(1).value();
+            snn_require(second.index == 1);
+            snn_require(!second.passed());
+            snn_require(second.exit_status == 1);
+            snn_require(second.signal == 6);
+            snn_require(second.start_ns == 9000);
+            snn_require(!second.timed_out);
+
+            const auto timed_out = app::bundle::parse_report(
+                "start\t0\t100\t7000\n"
+                "timeout\t0\n"
+                "0\t1\t6\t7000\t2000\t1000\t500\t4\t0\t0\t0\t0\t0\t0\n",
+                2);
+            snn_require(timed_out);
+            snn_require(timed_out.value().count() == 1);
+            snn_require(timed_out.value().at(0).value().timed_out);
+            snn_require(!timed_out.value().at(0).value().passed());
+
+            snn_require(app::bundle::parse_report("", 2));
+            snn_require(app::bundle::parse_report("", 2).value().is_empty());
+            snn_require(!app::bundle::parse_report("2\t0\t0\t1\t1\t1\t1\t1\t0\t0\t0\t0\t0\t0\n",
+                                                   2)); // Index.
+            snn_require(!app::bundle::parse_report("0\t0\t0\t1\t1\t1\t1\n", 2));
+            snn_require(!app::bundle::parse_report("timeout\t2\n", 2));
+            snn_require(!app::bundle::parse_report("timeout\tx\n", 2));
+            snn_require(!app::bundle::parse_report("0\t0\t0\t1\t1\t1\t-1\t1\t0\t0\t0\t0\t0\t0\n",
+                                                   2));
+            snn_require(!app::bundle::parse_report("0\t256\t0\t1\t1\t1\t1\t1\t0\t0\t0\t0\t0\t0\n",
+                                                   2));
+        }
+        {
+            snn_require(!app::bundle::running(""));
+            snn_require(!app::bundle::running("start\t0\t100\t1\n"
+                                              "0\t0\t0\t1\t1\t1\t1\t1\t0\t0\t0\t0\t0\t0\n"));
+
+            const auto r = app::bundle::running("start\t0\t100\t1\n"
+                                                "0\t0\t0\t1\t1\t1\t1\t1\t0\t0\t0\t0\t0\t0\n"
+                                                "start\t1\t101\t5000\n");
+            snn_require(r);
+            snn_require(r.value().index == 1);
+            snn_require(r.value().pid == 101);
+            snn_require(r.value().start_ns == 5000);
+        }
+    }
+}
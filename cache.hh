@@ -0,0 +1,120 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+
+namespace snn::app::cache
+{
+    // Passing test runs, keyed by a digest of the executable, its arguments and the relevant
+    // environment (see `digest::fnv1a`).
+    class test_results final
+    {
+      public:
+        // Format (tab separated): <digest-hex> <unix-time> <path>
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            vec<cstrview> fields;
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                fields.clear();
+                for (const cstrview field : string::range::split{line, '\t'})
+                {
+                    fields.append(field);
+                }
+
+                if (fields.count() != 3)
+                {
+                    return false;
+                }
+
+                const auto digest = number::parse_hex(fields.at(0, promise::within_bounds));
+                const auto time   = number::parse(fields.at(1, promise::within_bounds));
+                if (!digest || !time)
+                {
+                    return false;
+                }
+
+                entries_.insert_or_assign(digest.value(promise::has_value),
+                                          entry{time.value(promise::has_value),
+                                                str{fields.at(2, promise::within_bounds)}});
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool contains(const u64 digest) const
+        {
+            return entries_.get(digest).has_value();
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return entries_.count();
+        }
+
+        [[nodiscard]] bool is_modified() const noexcept
+        {
+            return modified_;
+        }
+
+        void add(const u64 digest, const u64 time, str path)
+        {
+            entries_.insert_or_assign(digest, entry{time, std::move(path)});
+            modified_ = true;
+        }
+
+        // Only the `max_entries` most recent entries are kept.
+        [[nodiscard]] strbuf serialize(const usize max_entries) const
+        {
+            vec<u64> digests{container::reserve, entries_.count()};
+            for (const auto& p : entries_)
+            {
+                digests.append(p.first);
+            }
+
+            if (digests.count() > max_entries)
+            {
+                algo::sort(digests.range(), [this](const u64 a, const u64 b) {
+                    return time_(a) > time_(b);
+                });
+                digests.drop_back_n(digests.count() - max_entries);
+                algo::sort(digests.range());
+            }
+
+            strbuf out{container::reserve, digests.count() * 64};
+            for (const u64 digest : digests)
+            {
+                const entry& e = entries_.get(digest).value();
+                out.append_integral<math::base::hex>(digest, 16);
+                out << '\t' << as_num(e.time) << '\t' << e.path << '\n';
+            }
+            return out;
+        }
+
+      private:
+        struct entry final
+        {
+            u64 time = 0;
+            str path;
+        };
+
+        map::sorted<u64, entry> entries_;
+        bool modified_ = false;
+
+        u64 time_(const u64 digest) const
+        {
+            return entries_.get(digest).value().time;
+        }
+    };
+}
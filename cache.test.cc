@@ -0,0 +1,41 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/cache.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            app::cache::test_results c;
+            snn_require(c.parse("00000000000000ff\t1000\t./a.test\n"
+                                "0000000000000001\t3000\t./b.test\n"));
+            snn_require(c.count() == 2);
+            snn_require(c.contains(0xff));
+            snn_require(c.contains(1));
+            snn_require(!c.contains(2));
+            snn_require(!c.is_modified());
+
+            c.add(2, 2000, "./c.test");
+            snn_require(c.is_modified());
+            snn_require(c.contains(2));
+
+            snn_require(c.serialize(10) == "0000000000000001\t3000\t./b.test\n"
+                                           "0000000000000002\t2000\t./c.test\n"
+                                           "00000000000000ff\t1000\t./a.test\n");
+
+            // The oldest entry is dropped.
+            snn_require(c.serialize(2) == "0000000000000001\t3000\t./b.test\n"
+                                          "0000000000000002\t2000\t./c.test\n");
+        }
+        {
+            app::cache::test_results c;
+            snn_require(c.parse(""));
+            snn_require(!c.parse("ff\t1000\n"));
+            snn_require(!c.parse("xyz\t1000\t./a.test\n"));
+        }
+    }
+}
@@ -0,0 +1,288 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "build-tool/child.hh"
+#include "build-tool/jobs.hh"
+#include <fcntl.h>  // O_CLOEXEC
+#include <poll.h>   // poll
+#include <unistd.h> // close, pipe2, read
+#include <cerrno>
+#include <utility> // exchange
+
+namespace snn::app
+{
+    // A child process with its standard output and standard error captured through a pipe, read
+    // line by line without blocking (see `poll()`). The child stays in the process group of the
+    // caller, so that it gets the same signals (e.g. SIGINT from the terminal).
+    class captured_child final
+    {
+      public:
+        captured_child() = default;
+
+        ~captured_child()
+        {
+            close_();
+        }
+
+        // Non-copyable
+        captured_child(const captured_child&)            = delete;
+        captured_child& operator=(const captured_child&) = delete;
+
+        // Movable
+        captured_child(captured_child&& other) noexcept
+            : child_{std::move(other.child_)},
+              buffer_{std::move(other.buffer_)},
+              fd_{std::exchange(other.fd_, -1)},
+              error_{other.error_}
+        {
+        }
+
+        captured_child& operator=(captured_child&& other) noexcept
+        {
+            if (this != &other)
+            {
+                close_();
+                child_  = std::move(other.child_);
+                buffer_ = std::move(other.buffer_);
+                fd_     = std::exchange(other.fd_, -1);
+                error_  = other.error_;
+            }
+            return *this;
+        }
+
+        [[nodiscard]] bool spawn(const str& path, const vec<str>& arguments,
+                                 const vec<str>& environment)
+        {
+            snn_should(!is_open());
+
+            int fds[2] = {-1, -1};
+            if (::pipe2(fds, O_CLOEXEC) != 0)
+            {
+                error_ = errno;
+                return false;
+            }
+
+            const bool spawned = child_.spawn(path, arguments, environment, false, fds[1]);
+            ::close(fds[1]);
+
+            if (!spawned)
+            {
+                ::close(fds[0]);
+                error_ = child_.error_number();
+                return false;
+            }
+
+            error_ = 0;
+            fd_    = fds[0];
+            buffer_.clear();
+            return true;
+        }
+
+        [[nodiscard]] int error_number() const noexcept
+        {
+            return error_;
+        }
+
+        // True until the child has closed its output (usually when it exits).
+        [[nodiscard]] bool is_open() const noexcept
+        {
+            return fd_ >= 0;
+        }
+
+        // Read what is available and call `line(cstrview)` for each complete line (without the
+        // newline). At the end of the output the last incomplete line (if any) is passed too and
+        // the pipe is closed.
+        template <typename Line>
+        void read(Line line)
+        {
+            if (fd_ < 0)
+            {
+                return;
+            }
+
+            char buf[4096];
+            const ssize_t n = ::read(fd_, buf, sizeof(buf));
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            {
+                return;
+            }
+
+            if (n <= 0)
+            {
+                if (buffer_)
+                {
+                    line(buffer_.view());
+                    buffer_.clear();
+                }
+                close_();
+                return;
+            }
+
+            buffer_.append(cstrview{buf, static_cast<usize>(n)});
+
+            cstrview rest = buffer_.view();
+            while (true)
+            {
+                const usize pos = rest.find('\n').value_or_npos();
+                if (pos == constant::npos)
+                {
+                    break;
+                }
+                line(rest.view(0, pos));
+                rest.drop_front_n(pos + 1);
+            }
+
+            constexpr usize max_line_size = 64 * 1024;
+            if (rest.size() > max_line_size)
+            {
+                line(rest);
+                rest = cstrview{};
+            }
+
+            str remaining{rest};
+            buffer_ = std::move(remaining);
+        }
+
+        // Wait for the child to exit (after its output has been closed).
+        [[nodiscard]] app::child& process() noexcept
+        {
+            return child_;
+        }
+
+        // Block (at most `timeout_ms`) until any of the open children has output or has closed
+        // it, returns their indexes.
+        [[nodiscard]] static vec<usize> poll(const vec<captured_child>& children,
+                                             const int timeout_ms)
+        {
+            vec<pollfd> fds{container::reserve, children.count()};
+            vec<usize> indexes{container::reserve, children.count()};
+            for (usize i = 0; i < children.count(); ++i)
+            {
+                const auto& c = children.at(i, promise::within_bounds);
+                if (c.is_open())
+                {
+                    fds.append(pollfd{c.fd_, POLLIN, 0});
+                    indexes.append(i);
+                }
+            }
+
+            vec<usize> ready;
+            if (fds.is_empty())
+            {
+                return ready;
+            }
+
+            if (::poll(fds.data().get(), fds.count(), timeout_ms) > 0)
+            {
+                for (usize i = 0; i < fds.count(); ++i)
+                {
+                    if (fds.at(i, promise::within_bounds).revents != 0)
+                    {
+                        ready.append(indexes.at(i, promise::within_bounds));
+                    }
+                }
+            }
+            return ready;
+        }
+
+      private:
+        app::child child_;
+        str buffer_; // Incomplete line.
+        int fd_    = -1;
+        int error_ = 0;
+
+        void close_() noexcept
+        {
+            if (fd_ >= 0)
+            {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+    };
+
+    // Run jobs (`path`, `arguments` and `environment`, started in order) with at most
+    // `concurrency` running at the same time and their output captured: `line(index, cstrview)`
+    // is called for each line of output, `done(index, exit_status, error_number)` when a job has
+    // exited (or failed to start, `error_number` is then not zero) and `tick()` at least every
+    // `tick_ms` milliseconds. No more jobs are started if `done` returns false (the running jobs
+    // are waited for). Returns the number of jobs that were started (or failed to start).
+    template <typename Line, typename Done, typename Tick>
+    usize run_captured(const vec<jobs::job>& jobs, const usize concurrency, const int tick_ms,
+                       Line line, Done done, Tick tick)
+    {
+        const usize slot_count = math::max(usize{1}, math::min(concurrency, jobs.count()));
+
+        vec<captured_child> slots{container::reserve, slot_count};
+        vec<usize> slot_job{container::reserve, slot_count};
+        for (usize i = 0; i < slot_count; ++i)
+        {
+            slots.append(captured_child{});
+            slot_job.append(constant::npos);
+        }
+
+        usize next   = 0;
+        usize active = 0;
+        bool stop    = false;
+
+        while ((next < jobs.count() && !stop) || active > 0)
+        {
+            // Fill free slots.
+            for (usize slot = 0; slot < slot_count && next < jobs.count() && !stop; ++slot)
+            {
+                if (slot_job.at(slot, promise::within_bounds) != constant::npos)
+                {
+                    continue;
+                }
+
+                const jobs::job& j = jobs.at(next, promise::within_bounds);
+                captured_child& c  = slots.at(slot, promise::within_bounds);
+                if (c.spawn(j.path, j.arguments, j.environment))
+                {
+                    slot_job.at(slot, promise::within_bounds) = next;
+                    ++active;
+                }
+                else if (!done(next, constant::exit::failure, c.error_number()))
+                {
+                    stop = true;
+                }
+                ++next;
+            }
+
+            if (active == 0)
+            {
+                continue;
+            }
+
+            for (const usize slot : captured_child::poll(slots, tick_ms))
+            {
+                const usize index = slot_job.at(slot, promise::within_bounds);
+                captured_child& c = slots.at(slot, promise::within_bounds);
+
+                c.read([&](const cstrview l) { line(index, l); });
+
+                if (!c.is_open())
+                {
+                    app::child& process = c.process();
+                    process.wait();
+
+                    slot_job.at(slot, promise::within_bounds) = constant::npos;
+                    --active;
+
+                    if (!done(index, process.exit_status(), process.error_number()))
+                    {
+                        stop = true;
+                    }
+                }
+            }
+
+            tick();
+        }
+
+        return next;
+    }
+}
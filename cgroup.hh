@@ -0,0 +1,442 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+#include "build-tool/resources.hh"
+#include <sys/stat.h> // mkdir
+#include <fcntl.h>    // open
+#include <unistd.h>   // getpid, read, rmdir, write
+#include <cerrno>
+
+namespace snn::app::cgroup
+{
+    // Resource isolation with cgroup v2: every job runs in a cgroup of its own (a child of the
+    // cgroup that snn runs in, which must be delegated, e.g. with
+    // `systemd-run --user --scope -p Delegate=yes snn ...`) with optional limits. The memory peak
+    // and CPU time of a job are read from its cgroup (they include every process of the job,
+    // waited for or not).
+
+    struct limits final
+    {
+        u64 memory_max  = 0; // Bytes, zero for no limit.
+        u64 cpu_percent = 0; // Of one CPU (e.g. 200 for two CPUs), zero for no limit.
+    };
+
+    // Comma separated limits, e.g. "memory=2G,cpu=150" ("max" for no limit).
+    [[nodiscard]] constexpr optional<limits> parse_limits(const cstrview spec) noexcept
+    {
+        limits l;
+        for (const cstrview item : string::range::split{spec, ','})
+        {
+            const usize eq = item.find('=').value_or_npos();
+            if (eq == constant::npos)
+            {
+                return nullopt;
+            }
+
+            const cstrview name  = item.view(0, eq);
+            const cstrview value = item.view(eq + 1);
+            if (name == "memory")
+            {
+                if (value != "max")
+                {
+                    const auto size = number::parse_size(value);
+                    if (!size)
+                    {
+                        return nullopt;
+                    }
+                    l.memory_max = size.value();
+                }
+            }
+            else if (name == "cpu")
+            {
+                if (value != "max")
+                {
+                    const auto percent = number::parse(value);
+                    if (!percent || percent.value() == 0 || percent.value() > 100'000)
+                    {
+                        return nullopt;
+                    }
+                    l.cpu_percent = percent.value();
+                }
+            }
+            else
+            {
+                return nullopt;
+            }
+        }
+        return l;
+    }
+
+    // Value for `memory.max`.
+    [[nodiscard]] inline str memory_max(const limits& l)
+    {
+        if (l.memory_max == 0)
+        {
+            return str{"max"};
+        }
+        str s;
+        s << as_num(l.memory_max);
+        return s;
+    }
+
+    // Value for `cpu.max` ("<quota> <period>" in microseconds).
+    [[nodiscard]] inline str cpu_max(const limits& l)
+    {
+        constexpr u64 period = 100'000;
+        if (l.cpu_percent == 0)
+        {
+            return str{"max"};
+        }
+        str s;
+        s << as_num(l.cpu_percent * period / 100) << ' ' << as_num(period);
+        return s;
+    }
+
+    // The cgroup v2 path (e.g. "/user.slice/.../snn.scope") from `/proc/self/cgroup`.
+    [[nodiscard]] inline optional<cstrview> parse_own(const cstrview proc_self_cgroup) noexcept
+    {
+        for (const cstrview line : string::range::split{proc_self_cgroup, '\n'})
+        {
+            if (line.has_front("0::/"))
+            {
+                return line.view(string_size("0::"));
+            }
+        }
+        return nullopt;
+    }
+
+    // Value of a key in a flat keyed file, e.g. "user_usec" in `cpu.stat`.
+    [[nodiscard]] inline optional<u64> parse_key(const cstrview contents,
+                                                 const cstrview key) noexcept
+    {
+        for (const cstrview line : string::range::split{contents, '\n'})
+        {
+            if (line.has_front(key) && line.view(key.size()).has_front(' '))
+            {
+                return number::parse(line.view(key.size() + 1));
+            }
+        }
+        return nullopt;
+    }
+
+    // A job is started with `/bin/sh` moving itself into the cgroup before it executes the
+    // command, nothing the job does escapes accounting.
+    inline constexpr cstrview wrapper_path = "/bin/sh";
+
+    [[nodiscard]] inline vec<str> wrapper_arguments(const cstrview dir, const cstrview path,
+                                                    const vec<str>& arguments)
+    {
+        vec<str> args{container::reserve, arguments.count() + 5};
+        args.append(str{"-c"});
+        args.append(str{R"(echo 0 > "$1" && shift && exec "$@")"});
+        args.append(str{"sh"});
+        args.append(concat(dir, "/cgroup.procs"));
+        args.append(str{path});
+        for (const auto& a : arguments)
+        {
+            args.append(a);
+        }
+        return args;
+    }
+
+    namespace detail
+    {
+        // Control files must be written with a single `write()`.
+        [[nodiscard]] inline bool write_control(const str& path, const cstrview value) noexcept
+        {
+            const int fd = ::open(path.null_terminated().get(), O_WRONLY | O_CLOEXEC);
+            if (fd == -1)
+            {
+                return false;
+            }
+            const auto written = ::write(fd, value.data().get(), value.size());
+            ::close(fd);
+            return written == static_cast<ssize_t>(value.size());
+        }
+
+        // Control files report a size of zero, read until the end.
+        [[nodiscard]] inline bool read_control(const str& path, strbuf& contents)
+        {
+            const int fd = ::open(path.null_terminated().get(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1)
+            {
+                return false;
+            }
+
+            contents.clear();
+            char buf[1024];
+            while (true)
+            {
+                const auto n = ::read(fd, buf, sizeof(buf));
+                if (n > 0)
+                {
+                    contents << cstrview{buf, static_cast<usize>(n)};
+                }
+                else if (n == 0 || errno != EINTR)
+                {
+                    ::close(fd);
+                    return n == 0;
+                }
+            }
+        }
+    }
+
+    // Read the memory peak and CPU time of a finished job into `u` (the fields that are not
+    // available, e.g. `memory.peak` before Linux 5.19, are left as is).
+    inline void read_usage(const str& dir, resources::usage& u)
+    {
+        strbuf contents;
+        if (detail::read_control(concat(dir, "/memory.peak"), contents))
+        {
+            contents.truncate(contents.size() - (contents.has_back('\n') ? 1 : 0));
+            if (const auto peak = number::parse(contents.view()))
+            {
+                u.max_rss = peak.value();
+            }
+        }
+
+        if (detail::read_control(concat(dir, "/cpu.stat"), contents))
+        {
+            const auto user   = parse_key(contents, "user_usec");
+            const auto system = parse_key(contents, "system_usec");
+            if (user && system)
+            {
+                u.user_ns   = user.value() * 1'000;
+                u.system_ns = system.value() * 1'000;
+            }
+        }
+    }
+
+    // Number of processes of a job that were killed by the OOM killer (`memory.max`).
+    [[nodiscard]] inline u64 oom_kills(const str& dir)
+    {
+        strbuf contents;
+        if (detail::read_control(concat(dir, "/memory.events"), contents))
+        {
+            return parse_key(contents, "oom_kill").value_or(0);
+        }
+        return 0;
+    }
+
+    // Directory of the cgroup of this process, e.g. "/sys/fs/cgroup/user.slice/.../snn.scope".
+    [[nodiscard]] inline optional<str> own_directory()
+    {
+        strbuf contents;
+        if (!detail::read_control(str{"/proc/self/cgroup"}, contents))
+        {
+            return nullopt;
+        }
+
+        const auto own = parse_own(contents);
+        if (!own)
+        {
+            return nullopt;
+        }
+
+        str dir = concat("/sys/fs/cgroup", own.value());
+        if (dir.has_back('/'))
+        {
+            dir.drop_back_n(1);
+        }
+        return dir;
+    }
+
+    // Create a cgroup with limits.
+    [[nodiscard]] inline bool create(const str& dir, const limits& l)
+    {
+        if (::mkdir(dir.null_terminated().get(), 0755) != 0)
+        {
+            return false;
+        }
+
+        if (!detail::write_control(concat(dir, "/memory.max"), memory_max(l)) ||
+            !detail::write_control(concat(dir, "/cpu.max"), cpu_max(l)))
+        {
+            ::rmdir(dir.null_terminated().get());
+            return false;
+        }
+
+        // Swapping would hide the memory limit.
+        if (l.memory_max > 0)
+        {
+            [[maybe_unused]] const bool no_swap =
+                detail::write_control(concat(dir, "/memory.swap.max"), "0");
+        }
+
+        return true;
+    }
+
+    // Kill any remaining processes (`cgroup.kill`, Linux 5.14) and remove a cgroup.
+    inline void remove(const str& dir)
+    {
+        if (::rmdir(dir.null_terminated().get()) == 0 || errno == ENOENT)
+        {
+            return;
+        }
+
+        [[maybe_unused]] const bool killed =
+            detail::write_control(concat(dir, "/cgroup.kill"), "1");
+        for (usize attempt = 0; attempt < 100; ++attempt)
+        {
+            if (::rmdir(dir.null_terminated().get()) == 0 || errno != EBUSY)
+            {
+                return;
+            }
+            ::usleep(1'000);
+        }
+    }
+
+    // The cgroups of the jobs of this process. `setup()` moves this process into a leaf cgroup of
+    // its own (a cgroup with processes can't enable controllers for its children) and enables the
+    // controllers, the destructor undoes it all. Child processes that are started after `setup()`
+    // (e.g. `make` and the compilers) are in the leaf cgroup, unless they create their own (see
+    // `snn cgroup-exec`).
+    class tree final
+    {
+      public:
+        explicit tree() noexcept = default;
+
+        tree(const tree&)            = delete;
+        tree& operator=(const tree&) = delete;
+
+        ~tree()
+        {
+            for (const auto& dir : created_)
+            {
+                remove(dir);
+            }
+            undo_();
+        }
+
+        // Returns an error message if cgroup v2 delegation is not available (nothing is changed).
+        [[nodiscard]] optional<str> setup(const limits& l)
+        {
+            limits_ = l;
+
+            auto own = own_directory();
+            if (!own)
+            {
+                return str{"not a cgroup v2 hierarchy"};
+            }
+            root_ = std::move(own.value());
+
+            strbuf contents;
+            if (!detail::read_control(concat(root_, "/cgroup.controllers"), contents) ||
+                !has_word_(contents, "memory") || !has_word_(contents, "cpu"))
+            {
+                return concat("the memory and cpu controllers are not delegated to: ", root_);
+            }
+
+            str self = root_;
+            self << "/snn-" << as_num(::getpid());
+            if (::mkdir(self.null_terminated().get(), 0755) != 0)
+            {
+                return concat("not allowed to create cgroups in: ", root_);
+            }
+
+            if (!detail::write_control(concat(self, "/cgroup.procs"), "0"))
+            {
+                ::rmdir(self.null_terminated().get());
+                return concat("not allowed to move into: ", self);
+            }
+            self_ = std::move(self);
+
+            if (!detail::read_control(concat(root_, "/cgroup.subtree_control"), contents))
+            {
+                undo_();
+                return concat("failed to read: ", root_, "/cgroup.subtree_control");
+            }
+
+            constexpr cstrview controllers[] = {"memory", "cpu"};
+
+            str enable;
+            str disable;
+            for (const cstrview controller : controllers)
+            {
+                if (!has_word_(contents, controller))
+                {
+                    enable << (enable ? " +" : "+") << controller;
+                    disable << (disable ? " -" : "-") << controller;
+                }
+            }
+
+            if (enable)
+            {
+                if (!detail::write_control(concat(root_, "/cgroup.subtree_control"), enable))
+                {
+                    // E.g. other processes in the same cgroup (not a scope of its own).
+                    undo_();
+                    return concat("failed to enable controllers in: ", root_,
+                                  " (other processes in the cgroup?)");
+                }
+                disable_ = std::move(disable);
+            }
+
+            return nullopt;
+        }
+
+        [[nodiscard]] bool is_active() const noexcept
+        {
+            return !self_.is_empty();
+        }
+
+        // Create the cgroup of a job with the limits, returns an empty string on failure.
+        [[nodiscard]] str create(const cstrview name)
+        {
+            str dir = concat(root_, "/", name);
+            if (!cgroup::create(dir, limits_))
+            {
+                return str{};
+            }
+            created_.append(dir);
+            return dir;
+        }
+
+      private:
+        limits limits_;
+        str root_;
+        str self_;
+        str disable_; // Controllers that were enabled by `setup()`, e.g. "-memory -cpu".
+        vec<str> created_;
+
+        void undo_()
+        {
+            if (disable_)
+            {
+                [[maybe_unused]] const bool disabled =
+                    detail::write_control(concat(root_, "/cgroup.subtree_control"), disable_);
+                disable_.clear();
+            }
+
+            if (self_)
+            {
+                // Back to where we came from, then the leaf can be removed.
+                [[maybe_unused]] const bool moved =
+                    detail::write_control(concat(root_, "/cgroup.procs"), "0");
+                ::rmdir(self_.null_terminated().get());
+                self_.clear();
+            }
+        }
+
+        [[nodiscard]] static bool has_word_(const cstrview contents, const cstrview word)
+        {
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                for (const cstrview w : string::range::split{line, ' '})
+                {
+                    if (w == word)
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+    };
+}
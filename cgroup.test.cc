@@ -0,0 +1,61 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/cgroup.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            const auto l = app::cgroup::parse_limits("memory=2G,cpu=150");
+            snn_require(l);
+            snn_require(l.value().memory_max == u64{2} << 30);
+            snn_require(l.value().cpu_percent == 150);
+            snn_require(app::cgroup::memory_max(l.value()) == "2147483648");
+            snn_require(app::cgroup::cpu_max(l.value()) == "150000 100000");
+
+            const auto unlimited = app::cgroup::parse_limits("memory=max");
+            snn_require(unlimited);
+            snn_require(app::cgroup::memory_max(unlimited.value()) == "max");
+            snn_require(app::cgroup::cpu_max(unlimited.value()) == "max");
+
+            snn_require(!app::cgroup::parse_limits("memory"));
+            snn_require(!app::cgroup::parse_limits("memory=1x"));
+            snn_require(!app::cgroup::parse_limits("cpu=0"));
+            snn_require(!app::cgroup::parse_limits("io=1"));
+        }
+        {
+            snn_require(app::cgroup::parse_own("0::/user.slice/snn.scope\n").value() ==
+                        "/user.slice/snn.scope");
+            snn_require(app::cgroup::parse_own("12:memory:/a\n0::/\n").value() == "/");
+            snn_require(!app::cgroup::parse_own("12:memory:/a\n"));
+            snn_require(!app::cgroup::parse_own(""));
+        }
+        {
+            constexpr cstrview stat = "usage_usec 1500\n"
+                                      "user_usec 1000\n"
+                                      "system_usec 500\n";
+            snn_require(app::cgroup::parse_key(stat, "usage_usec").value() == 1500);
+            snn_require(app::cgroup::parse_key(stat, "user_usec").value() == 1000);
+            snn_require(app::cgroup::parse_key(stat, "system_usec").value() == 500);
+            snn_require(!app::cgroup::parse_key(stat, "user"));
+            snn_require(!app::cgroup::parse_key(stat, "nr_periods"));
+        }
+        {
+            vec<str> arguments;
+            arguments.append(str{"x"});
+
+            const auto args = app::cgroup::wrapper_arguments("/sys/fs/cgroup/a/job-1", "./t",
+                                                             arguments);
+            snn_require(args.count() == 6);
+            snn_require(args.at(0).value() == "-c");
+            snn_require(args.at(2).value() == "sh"); // $0
+            snn_require(args.at(3).value() == "/sys/fs/cgroup/a/job-1/cgroup.procs");
+            snn_require(args.at(4).value() == "./t");
+            snn_require(args.at(5).value() == "x");
+        }
+    }
+}
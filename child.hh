@@ -0,0 +1,316 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include <spawn.h>        // posix_spawnp
+#include <sys/resource.h> // rusage
+#include <sys/wait.h>     // wait4
+#include <unistd.h>       // STDERR_FILENO, STDOUT_FILENO
+#include <cerrno>
+#include <csignal> // kill
+#include <cstring> // strchr, strncmp
+#include <utility> // exchange
+
+extern char** environ;
+
+namespace snn::app
+{
+    // A spawned child process that can be waited on without blocking. Unlike
+    // `process::spawner` this allows additional environment variables and gives access to the
+    // process id.
+    class child final
+    {
+      public:
+        child() = default;
+
+        ~child()
+        {
+            if (is_running())
+            {
+                wait();
+            }
+        }
+
+        // Non-copyable
+        child(const child&)            = delete;
+        child& operator=(const child&) = delete;
+
+        // Movable
+        child(child&& other) noexcept
+            : pid_{std::exchange(other.pid_, -1)},
+              status_{other.status_},
+              error_{other.error_},
+              usage_{other.usage_}
+        {
+        }
+
+        child& operator=(child&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (is_running())
+                {
+                    wait();
+                }
+                pid_    = std::exchange(other.pid_, -1);
+                status_ = other.status_;
+                error_  = other.error_;
+                usage_  = other.usage_;
+            }
+            return *this;
+        }
+
+        // `environment` holds "NAME=value" strings that are added to (or replace variables in)
+        // the current environment. With `new_process_group` the child is the leader of a new
+        // process group (with the same id as the process), so that it and everything it spawns
+        // can be killed together (see `kill_process_group()`). If `output_fd` is not -1 the
+        // standard output and standard error of the child are redirected to it (e.g. the write
+        // end of a pipe, which should be close-on-exec).
+        [[nodiscard]] bool spawn(const str& path, const vec<str>& arguments,
+                                 const vec<str>& environment, const bool new_process_group = false,
+                                 const int output_fd = -1)
+        {
+            snn_should(!is_running());
+
+            vec<char*> argv{container::reserve, arguments.count() + 2};
+            argv.append(const_cast<char*>(path.null_terminated().get()));
+            for (const auto& arg : arguments)
+            {
+                argv.append(const_cast<char*>(arg.null_terminated().get()));
+            }
+            argv.append(nullptr);
+
+            vec<char*> envp{container::reserve, 64 + environment.count()};
+            for (char** e = environ; e != nullptr && *e != nullptr; ++e)
+            {
+                if (!is_overridden_(*e, environment))
+                {
+                    envp.append(*e);
+                }
+            }
+            for (const auto& var : environment)
+            {
+                envp.append(const_cast<char*>(var.null_terminated().get()));
+            }
+            envp.append(nullptr);
+
+            status_ = 0;
+            usage_  = ::rusage{};
+
+            ::posix_spawnattr_t attr;
+            error_ = ::posix_spawnattr_init(&attr);
+            if (error_ != 0)
+            {
+                return false;
+            }
+            if (new_process_group)
+            {
+                error_ = ::posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+                if (error_ == 0)
+                {
+                    error_ = ::posix_spawnattr_setpgroup(&attr, 0);
+                }
+            }
+
+            ::posix_spawn_file_actions_t actions;
+            const bool redirect = error_ == 0 && output_fd != -1;
+            if (redirect)
+            {
+                error_ = ::posix_spawn_file_actions_init(&actions);
+                if (error_ != 0)
+                {
+                    ::posix_spawnattr_destroy(&attr);
+                    return false;
+                }
+                error_ = ::posix_spawn_file_actions_adddup2(&actions, output_fd, STDOUT_FILENO);
+                if (error_ == 0)
+                {
+                    error_ = ::posix_spawn_file_actions_adddup2(&actions, output_fd, STDERR_FILENO);
+                }
+            }
+
+            if (error_ == 0)
+            {
+                error_ = ::posix_spawnp(&pid_, path.null_terminated().get(),
+                                        redirect ? &actions : nullptr, &attr, argv.data().get(),
+                                        envp.data().get());
+            }
+
+            if (redirect)
+            {
+                ::posix_spawn_file_actions_destroy(&actions);
+            }
+            ::posix_spawnattr_destroy(&attr);
+
+            if (error_ != 0)
+            {
+                pid_ = -1;
+                return false;
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] int error_number() const noexcept
+        {
+            return error_;
+        }
+
+        [[nodiscard]] bool exited_normally() const noexcept
+        {
+            return error_ == 0 && WIFEXITED(status_);
+        }
+
+        [[nodiscard]] int exit_status() const noexcept
+        {
+            if (exited_normally())
+            {
+                return WEXITSTATUS(status_);
+            }
+            return constant::exit::failure;
+        }
+
+        // Resource usage of the child (and its waited-for children), valid after it has exited.
+        [[nodiscard]] const ::rusage& usage() const noexcept
+        {
+            return usage_;
+        }
+
+        [[nodiscard]] bool is_running() const noexcept
+        {
+            return pid_ > 0;
+        }
+
+        [[nodiscard]] pid_t pid() const noexcept
+        {
+            return pid_;
+        }
+
+        // Kill (SIGKILL) the process group of a child spawned with `new_process_group`, the
+        // child must still be waited for.
+        void kill_process_group() const noexcept
+        {
+            if (pid_ > 0)
+            {
+                ::kill(-pid_, SIGKILL);
+            }
+        }
+
+        // Returns true if the child has exited (or was never spawned).
+        [[nodiscard]] bool try_wait() noexcept
+        {
+            return wait_(WNOHANG);
+        }
+
+        void wait() noexcept
+        {
+            while (!wait_(0))
+            {
+            }
+        }
+
+        // Block until one of the running children exits, returns its index or `constant::npos`
+        // if none of them is running. Must not be used while other child processes (not in
+        // `children`) are running, they would be reaped.
+        [[nodiscard]] static usize wait_any(vec<child>& children) noexcept
+        {
+            bool any_running = false;
+            for (const auto& c : children)
+            {
+                any_running = any_running || c.is_running();
+            }
+
+            while (any_running)
+            {
+                int status      = 0;
+                ::rusage usage{};
+                const pid_t res = ::wait4(-1, &status, 0, &usage);
+                if (res < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    // No children left to wait for (should not happen).
+                    const int error = errno;
+                    for (auto& c : children)
+                    {
+                        if (c.is_running())
+                        {
+                            c.pid_   = -1;
+                            c.error_ = error;
+                        }
+                    }
+                    return constant::npos;
+                }
+
+                for (usize i = 0; i < children.count(); ++i)
+                {
+                    auto& c = children.at(i, promise::within_bounds);
+                    if (c.pid_ == res)
+                    {
+                        c.pid_    = -1;
+                        c.status_ = status;
+                        c.usage_  = usage;
+                        return i;
+                    }
+                }
+            }
+
+            return constant::npos;
+        }
+
+      private:
+        pid_t pid_  = -1;
+        int status_ = 0;
+        int error_  = 0;
+        ::rusage usage_{};
+
+        static bool is_overridden_(const char* const var, const vec<str>& environment) noexcept
+        {
+            const char* const eq = std::strchr(var, '=');
+            if (eq != nullptr)
+            {
+                const auto name_size = static_cast<usize>(eq - var) + 1; // Including '='.
+                for (const auto& e : environment)
+                {
+                    if (e.size() >= name_size &&
+                        std::strncmp(var, e.null_terminated().get(), name_size) == 0)
+                    {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        bool wait_(const int options) noexcept
+        {
+            if (pid_ <= 0)
+            {
+                return true;
+            }
+
+            const pid_t res = ::wait4(pid_, &status_, options, &usage_);
+            if (res == pid_)
+            {
+                pid_ = -1;
+                return true;
+            }
+
+            if (res < 0 && errno != EINTR)
+            {
+                pid_    = -1;
+                status_ = 0;
+                error_  = errno;
+                return true;
+            }
+
+            return false;
+        }
+    };
+}
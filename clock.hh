@@ -0,0 +1,19 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/core.hh"
+#include <time.h> // clock_gettime
+
+namespace snn::app::clock
+{
+    // Nanoseconds since an unspecified point in time (CLOCK_MONOTONIC), comparable between
+    // processes on the same system.
+    [[nodiscard]] inline u64 monotonic() noexcept
+    {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<u64>(ts.tv_sec) * 1'000'000'000 + static_cast<u64>(ts.tv_nsec);
+    }
+}
@@ -0,0 +1,244 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/set/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/json.hh"
+#include "build-tool/report.hh"
+
+namespace snn::app::coverage
+{
+    namespace detail
+    {
+        inline usize last_slash(const cstrview path) noexcept
+        {
+            for (usize i = path.size(); i > 0; --i)
+            {
+                if (path.at(i - 1, promise::within_bounds) == '/')
+                {
+                    return i - 1;
+                }
+            }
+            return constant::npos;
+        }
+    }
+
+    // Absolute path with "." and ".." components (and repeated slashes) removed, relative paths
+    // are resolved against `cwd` (absolute). Symbolic links are not resolved.
+    [[nodiscard]] inline str absolute_path(const cstrview cwd, const cstrview path)
+    {
+        vec<cstrview> components;
+        const auto add = [&components](const cstrview p) {
+            for (const cstrview c : string::range::split{p, '/'})
+            {
+                if (c.is_empty() || c == ".")
+                {
+                    continue;
+                }
+                if (c == "..")
+                {
+                    if (!components.is_empty())
+                    {
+                        components.drop_back_n(1);
+                    }
+                    continue;
+                }
+                components.append(c);
+            }
+        };
+
+        if (!path.has_front('/'))
+        {
+            add(cwd);
+        }
+        add(path);
+
+        str result{container::reserve, cwd.size() + path.size() + 1};
+        for (const cstrview c : components)
+        {
+            result << '/' << c;
+        }
+        if (result.is_empty())
+        {
+            result << '/';
+        }
+        return result;
+    }
+
+    // LLVM tool matching the compiler version, e.g. "clang++-15" -> "llvm-profdata-15".
+    [[nodiscard]] inline str llvm_tool(const cstrview compiler, const cstrview tool)
+    {
+        cstrview name = compiler;
+        if (const usize pos = detail::last_slash(compiler); pos != constant::npos)
+        {
+            name = compiler.view(pos + 1);
+        }
+
+        if (name.has_front("clang++"))
+        {
+            return concat(tool, name.view(string_size("clang++")));
+        }
+        if (name.has_front("clang"))
+        {
+            return concat(tool, name.view(string_size("clang")));
+        }
+        return str{tool};
+    }
+
+    struct counts final
+    {
+        u64 lines           = 0;
+        u64 covered_lines   = 0;
+        u64 regions         = 0;
+        u64 covered_regions = 0;
+
+        void add(const counts& other) noexcept
+        {
+            lines += other.lines;
+            covered_lines += other.covered_lines;
+            regions += other.regions;
+            covered_regions += other.covered_regions;
+        }
+    };
+
+    // Line and region coverage per file and per directory, for the files in the dependency
+    // graph of the applications.
+    class summary final
+    {
+      public:
+        // Parse `llvm-cov export -summary-only` output. Only files that match a path in `files`
+        // (dependency graph paths, e.g. "../snn-core/vec.hh", relative to `cwd`) are kept, under
+        // that path. Both sides are compared as absolute paths (see `absolute_path()`).
+        [[nodiscard]] bool parse_export(const cstrview contents, const set::sorted<str>& files,
+                                        const cstrview cwd)
+        {
+            map::sorted<str, cstrview> resolved; // Absolute path -> path in `files`.
+            for (const auto& path : files)
+            {
+                resolved.insert_or_assign(absolute_path(cwd, path), path.view());
+            }
+
+            json::reader r{contents};
+            r.object([&](const cstrview key, json::reader& data) {
+                if (key != "data")
+                {
+                    return;
+                }
+
+                data.array([&](json::reader& export_object) {
+                    export_object.object([&](const cstrview k, json::reader& file_array) {
+                        if (k != "files")
+                        {
+                            return;
+                        }
+
+                        file_array.array([&](json::reader& file_object) {
+                            str filename;
+                            counts c;
+                            file_object.object([&](const cstrview fk, json::reader& v) {
+                                if (fk == "filename")
+                                {
+                                    filename = v.string().value_or_default();
+                                }
+                                else if (fk == "summary")
+                                {
+                                    parse_summary_(v, c);
+                                }
+                            });
+
+                            if (const auto path = resolved.get(absolute_path(cwd, filename)))
+                            {
+                                files_.insert_or_assign(path.value(), c);
+                            }
+                        });
+                    });
+                });
+            });
+            return r.is_valid();
+        }
+
+        [[nodiscard]] const map::sorted<str, counts>& files() const noexcept
+        {
+            return files_;
+        }
+
+        [[nodiscard]] strbuf format() const
+        {
+            strbuf out{container::reserve, files_.count() * 100 + 512};
+
+            map::sorted<str, counts> directories;
+            counts total;
+
+            report::table files;
+            files.add_row("Lines", "Cover", "Regions", "Cover", "File");
+            for (const auto& p : files_)
+            {
+                add_row_(files, p.second, p.first);
+
+                const usize slash  = detail::last_slash(p.first);
+                const cstrview dir = slash != constant::npos ? p.first.view(0, slash) : ".";
+                directories.insert_inplace(dir).value().add(p.second);
+                total.add(p.second);
+            }
+
+            report::table dirs;
+            dirs.add_row("Lines", "Cover", "Regions", "Cover", "Directory");
+            for (const auto& p : directories)
+            {
+                add_row_(dirs, p.second, p.first);
+            }
+            add_row_(dirs, total, "total");
+
+            out << files.format();
+            out << '\n';
+            out << dirs.format();
+            return out;
+        }
+
+      private:
+        map::sorted<str, counts> files_;
+
+        static void add_row_(report::table& t, const counts& c, const cstrview name)
+        {
+            str lines;
+            lines << as_num(c.covered_lines) << '/' << as_num(c.lines);
+            str regions;
+            regions << as_num(c.covered_regions) << '/' << as_num(c.regions);
+            t.add_row(std::move(lines), report::percent(c.covered_lines, c.lines),
+                      std::move(regions), report::percent(c.covered_regions, c.regions), name);
+        }
+
+        static void parse_summary_(json::reader& r, counts& c)
+        {
+            r.object([&](const cstrview key, json::reader& v) {
+                if (key == "lines")
+                {
+                    parse_counts_(v, c.lines, c.covered_lines);
+                }
+                else if (key == "regions")
+                {
+                    parse_counts_(v, c.regions, c.covered_regions);
+                }
+            });
+        }
+
+        static void parse_counts_(json::reader& r, u64& count, u64& covered)
+        {
+            r.object([&](const cstrview key, json::reader& v) {
+                if (key == "count")
+                {
+                    count = v.integer().value_or(0);
+                }
+                else if (key == "covered")
+                {
+                    covered = v.integer().value_or(0);
+                }
+            });
+        }
+    };
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/coverage.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            using app::coverage::llvm_tool;
+
+            snn_require(llvm_tool("clang++", "llvm-profdata") == "llvm-profdata");
+            snn_require(llvm_tool("clang++-15", "llvm-cov") == "llvm-cov-15");
+            snn_require(llvm_tool("/usr/local/bin/clang++15", "llvm-cov") == "llvm-cov15");
+            snn_require(llvm_tool("clang-14", "llvm-cov") == "llvm-cov-14");
+            snn_require(llvm_tool("g++", "llvm-cov") == "llvm-cov");
+        }
+        {
+            set::sorted<str> files;
+            files.insert("pair/core.test.cc");
+            files.insert("snn-core/vec.hh");
+
+            app::coverage::summary s;
+            snn_require(s.parse_export(
+                R"({"data":[{"files":[
+                    {"filename":"/home/u/snn-core/vec.hh","summary":{
+                        "lines":{"count":100,"covered":80,"percent":80},
+                        "regions":{"count":50,"covered":25,"notcovered":25,"percent":50}}},
+                    {"filename":"/home/u/pair/core.test.cc","summary":{
+                        "lines":{"count":20,"covered":20,"percent":100},
+                        "regions":{"count":10,"covered":10,"percent":100}}},
+                    {"filename":"/usr/include/c++/v1/vector","summary":{
+                        "lines":{"count":5,"covered":1,"percent":20}}}],
+                    "totals":{"lines":{"count":125,"covered":101,"percent":80.8}}}],
+                    "type":"llvm.coverage.json.export","version":"2.0.1"})",
+                files, "/home/u"));
+
+            snn_require(s.files().count() == 2);
+            snn_require(s.format() == " Lines   Cover  Regions   Cover  File\n"
+                                      " 20/20  100.0%    10/10  100.0%  pair/core.test.cc\n"
+                                      "80/100   80.0%    25/50   50.0%  snn-core/vec.hh\n"
+                                      "\n"
+                                      "  Lines   Cover  Regions   Cover  Directory\n"
+                                      "  20/20  100.0%    10/10  100.0%  pair\n"
+                                      " 80/100   80.0%    25/50   50.0%  snn-core\n"
+                                      "100/120   83.3%    35/60   58.3%  total\n");
+        }
+        {
+            // Graph paths with the include path prefix, run from a subdirectory.
+            set::sorted<str> files;
+            files.insert("./pair/core.test.cc");
+            files.insert("../snn-core/vec.hh");
+
+            app::coverage::summary s;
+            snn_require(s.parse_export(
+                R"({"data":[{"files":[
+                    {"filename":"/home/u/snn-core/vec.hh","summary":{
+                        "lines":{"count":100,"covered":80,"percent":80}}},
+                    {"filename":"/home/u/app/pair/core.test.cc","summary":{
+                        "lines":{"count":20,"covered":20,"percent":100}}},
+                    {"filename":"/home/u/app/snn-core/vec.hh","summary":{
+                        "lines":{"count":5,"covered":1,"percent":20}}}]}]})",
+                files, "/home/u/app/"));
+
+            snn_require(s.files().count() == 2);
+            snn_require(s.files().get("../snn-core/vec.hh").value().covered_lines == 80);
+            snn_require(s.files().get("./pair/core.test.cc").value().covered_lines == 20);
+        }
+        {
+            using app::coverage::absolute_path;
+
+            snn_require(absolute_path("/home/u", "a.hh") == "/home/u/a.hh");
+            snn_require(absolute_path("/home/u", "./a/./b.hh") == "/home/u/a/b.hh");
+            snn_require(absolute_path("/home/u/app", "../snn-core//vec.hh") ==
+                        "/home/u/snn-core/vec.hh");
+            snn_require(absolute_path("/home/u", "/usr/include/../lib/x.h") == "/usr/lib/x.h");
+            snn_require(absolute_path("/", "../..") == "/");
+        }
+        {
+            app::coverage::summary s;
+            snn_require(!s.parse_export("{\"data\": [", {}, "/"));
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+
+namespace snn::app::digest
+{
+    // 64-bit FNV-1a, fast but not cryptographic. Used to detect changes (cache keys), not to
+    // protect against tampering.
+    class fnv1a final
+    {
+      public:
+        constexpr fnv1a& update(const transient<cstrview> data) noexcept
+        {
+            for (const char c : data.get())
+            {
+                hash_ ^= static_cast<u8>(c);
+                hash_ *= 0x100000001b3;
+            }
+            return *this;
+        }
+
+        // Include a separator so that e.g. ("ab", "c") and ("a", "bc") differ.
+        constexpr fnv1a& update_field(const transient<cstrview> data) noexcept
+        {
+            update(data);
+            return update(cstrview{"\0", 1});
+        }
+
+        [[nodiscard]] constexpr u64 value() const noexcept
+        {
+            return hash_;
+        }
+
+        // Zero padded lowercase hex (16 characters).
+        [[nodiscard]] str hex() const
+        {
+            str s;
+            s.append_integral<math::base::hex>(hash_, 16);
+            return s;
+        }
+
+      private:
+        u64 hash_ = 0xcbf29ce484222325;
+    };
+}
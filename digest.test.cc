@@ -0,0 +1,25 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/digest.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        using app::digest::fnv1a;
+
+        static_assert(fnv1a{}.value() == 0xcbf29ce484222325);
+        static_assert(fnv1a{}.update("a").value() == 0xaf63dc4c8601ec8c);
+        static_assert(fnv1a{}.update("foobar").value() == 0x85944171f73967e8);
+        static_assert(fnv1a{}.update("foo").update("bar").value() == 0x85944171f73967e8);
+
+        static_assert(fnv1a{}.update_field("ab").update_field("c").value() !=
+                      fnv1a{}.update_field("a").update_field("bc").value());
+
+        snn_require(fnv1a{}.hex() == "cbf29ce484222325");
+        snn_require(fnv1a{}.update("a").hex() == "af63dc4c8601ec8c");
+    }
+}
@@ -0,0 +1,360 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/file/read.hh"
+#include "snn-core/map/unsorted.hh"
+#include "snn-core/range/step.hh"
+#include <cxxabi.h> // abi::__cxa_demangle
+#include <elf.h>
+#include <cstdlib> // free
+#include <cstring> // memcpy, strlen
+
+namespace snn::app::elf
+{
+    // Demangle a C++ symbol name, on failure the name is returned as is.
+    [[nodiscard]] inline str demangle(const str& name)
+    {
+        int status      = 0;
+        char* demangled = abi::__cxa_demangle(name.null_terminated().get(), nullptr, nullptr,
+                                              &status);
+        if (demangled != nullptr)
+        {
+            str s{cstrview{demangled, std::strlen(demangled)}};
+            std::free(demangled);
+            return s;
+        }
+        return name;
+    }
+
+    struct section final
+    {
+        str name;
+        u64 address = 0;
+        u64 offset  = 0;
+        u64 size    = 0;
+        u32 type    = 0;
+        u64 flags   = 0;
+    };
+
+    struct symbol final
+    {
+        str name;
+        u64 address = 0;
+        u64 size    = 0;
+        u16 section = 0;
+        u8 type     = 0;
+        u8 binding  = 0;
+        str file; // Source file of a local symbol (from the preceding `STT_FILE` symbol).
+    };
+
+    struct segment final
+    {
+        u64 address = 0;
+        u64 offset  = 0;
+        u64 size    = 0;
+    };
+
+    // Minimal 64-bit little/native endian ELF reader, only what is needed to list sections and
+    // to map addresses to function (and object) symbols.
+    class file final
+    {
+      public:
+        file() = default;
+
+        // Non-copyable
+        file(const file&)            = delete;
+        file& operator=(const file&) = delete;
+
+        // Movable
+        file(file&&)            = default;
+        file& operator=(file&&) = default;
+
+        [[nodiscard]] bool load(const str& path)
+        {
+            contents_.clear();
+            sections_.clear();
+            segments_.clear();
+            symbols_.clear();
+
+            if (!snn::file::read(path, contents_))
+            {
+                return false;
+            }
+
+            Elf64_Ehdr header;
+            if (!load_(0, header))
+            {
+                return false;
+            }
+
+            if (header.e_ident[EI_MAG0] != ELFMAG0 || header.e_ident[EI_MAG1] != ELFMAG1 ||
+                header.e_ident[EI_MAG2] != ELFMAG2 || header.e_ident[EI_MAG3] != ELFMAG3 ||
+                header.e_ident[EI_CLASS] != ELFCLASS64 || header.e_shentsize != sizeof(Elf64_Shdr))
+            {
+                return false;
+            }
+
+            type_ = header.e_type;
+
+            // Segments (not present in object files).
+
+            for (const auto i : range::step<usize>{0, header.e_phnum})
+            {
+                Elf64_Phdr ph;
+                if (!load_(header.e_phoff + i * sizeof(Elf64_Phdr), ph))
+                {
+                    return false;
+                }
+
+                if (ph.p_type == PT_LOAD)
+                {
+                    segments_.append(segment{ph.p_vaddr, ph.p_offset, ph.p_filesz});
+                }
+            }
+
+            // Sections
+
+            vec<Elf64_Shdr> headers{container::reserve, header.e_shnum};
+            for (const auto i : range::step<usize>{0, header.e_shnum})
+            {
+                Elf64_Shdr sh;
+                if (!load_(header.e_shoff + i * sizeof(Elf64_Shdr), sh))
+                {
+                    return false;
+                }
+                headers.append(sh);
+            }
+
+            if (header.e_shstrndx >= headers.count())
+            {
+                return false;
+            }
+            const Elf64_Shdr& names = headers.at(header.e_shstrndx, promise::within_bounds);
+
+            for (const Elf64_Shdr& sh : headers)
+            {
+                section s;
+                s.name    = string_(names, sh.sh_name);
+                s.address = sh.sh_addr;
+                s.offset  = sh.sh_offset;
+                s.size    = sh.sh_size;
+                s.type    = sh.sh_type;
+                s.flags   = sh.sh_flags;
+                sections_.append(std::move(s));
+            }
+
+            // Symbols, prefer the full symbol table but fall back on the dynamic one (stripped
+            // shared libraries).
+
+            bool has_symtab = false;
+            for (const Elf64_Shdr& sh : headers)
+            {
+                if (sh.sh_type == SHT_SYMTAB)
+                {
+                    has_symtab = true;
+                }
+            }
+
+            const u32 symbol_table_type = has_symtab ? SHT_SYMTAB : SHT_DYNSYM;
+            for (const Elf64_Shdr& sh : headers)
+            {
+                if (sh.sh_type == symbol_table_type && sh.sh_link < headers.count())
+                {
+                    const Elf64_Shdr& strings = headers.at(sh.sh_link, promise::within_bounds);
+                    if (!load_symbols_(sh, strings))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            algo::sort(symbols_.range(), [](const symbol& a, const symbol& b) {
+                return a.address < b.address;
+            });
+
+            return true;
+        }
+
+        [[nodiscard]] bool is_object_file() const noexcept
+        {
+            return type_ == ET_REL;
+        }
+
+        [[nodiscard]] bool is_position_independent() const noexcept
+        {
+            return type_ == ET_DYN;
+        }
+
+        [[nodiscard]] const vec<section>& sections() const noexcept
+        {
+            return sections_;
+        }
+
+        [[nodiscard]] const vec<symbol>& symbols() const noexcept
+        {
+            return symbols_;
+        }
+
+        // Lowest virtual address of the loadable segments (zero for shared libraries and position
+        // independent executables).
+        [[nodiscard]] u64 base_address() const noexcept
+        {
+            u64 base = constant::limit<u64>::max;
+            for (const auto& seg : segments_)
+            {
+                base = math::min(base, seg.address);
+            }
+            return segments_ ? base & ~u64{0xfff} : 0;
+        }
+
+        // Map a file offset (e.g. from a memory mapping) to a virtual address.
+        [[nodiscard]] optional<u64> address_from_offset(const u64 offset) const noexcept
+        {
+            for (const auto& seg : segments_)
+            {
+                if (offset >= seg.offset && offset < seg.offset + seg.size)
+                {
+                    return offset - seg.offset + seg.address;
+                }
+            }
+            return nullopt;
+        }
+
+        // Find the function (or object) symbol containing the address (binary search).
+        [[nodiscard]] const symbol* find(const u64 address) const noexcept
+        {
+            usize first = 0;
+            usize last  = symbols_.count();
+            while (first < last)
+            {
+                const usize mid = first + (last - first) / 2;
+                if (symbols_.at(mid, promise::within_bounds).address <= address)
+                {
+                    first = mid + 1;
+                }
+                else
+                {
+                    last = mid;
+                }
+            }
+
+            if (first > 0)
+            {
+                const symbol& sym = symbols_.at(first - 1, promise::within_bounds);
+                if (address < sym.address + math::max(sym.size, u64{1}))
+                {
+                    return &sym;
+                }
+            }
+
+            return nullptr;
+        }
+
+      private:
+        strbuf contents_;
+        vec<section> sections_;
+        vec<segment> segments_;
+        vec<symbol> symbols_;
+        u16 type_ = ET_NONE;
+
+        template <typename T>
+        [[nodiscard]] bool load_(const u64 offset, T& out) const noexcept
+        {
+            if (offset <= contents_.size() && sizeof(T) <= contents_.size() - offset)
+            {
+                std::memcpy(&out, contents_.data().get() + offset, sizeof(T));
+                return true;
+            }
+            return false;
+        }
+
+        [[nodiscard]] bool load_symbols_(const Elf64_Shdr& table, const Elf64_Shdr& strings)
+        {
+            if (table.sh_entsize != sizeof(Elf64_Sym))
+            {
+                return false;
+            }
+
+            const u64 count = table.sh_size / sizeof(Elf64_Sym);
+            symbols_.reserve_append(count);
+
+            str file;
+            for (const auto i : range::step<u64>{0, count})
+            {
+                Elf64_Sym sym;
+                if (!load_(table.sh_offset + i * sizeof(Elf64_Sym), sym))
+                {
+                    return false;
+                }
+
+                const u8 type = ELF64_ST_TYPE(sym.st_info);
+                if (type == STT_FILE)
+                {
+                    file = string_(strings, sym.st_name);
+                }
+                else if ((type == STT_FUNC || type == STT_OBJECT) && sym.st_shndx != SHN_UNDEF)
+                {
+                    symbol s;
+                    s.name    = string_(strings, sym.st_name);
+                    s.address = sym.st_value;
+                    s.size    = sym.st_size;
+                    s.section = sym.st_shndx;
+                    s.type    = type;
+                    s.binding = ELF64_ST_BIND(sym.st_info);
+                    if (s.binding == STB_LOCAL)
+                    {
+                        s.file = file;
+                    }
+                    symbols_.append(std::move(s));
+                }
+            }
+
+            return true;
+        }
+
+        [[nodiscard]] str string_(const Elf64_Shdr& strings, const u64 index) const
+        {
+            if (strings.sh_offset <= contents_.size() && index < strings.sh_size &&
+                strings.sh_offset + index < contents_.size())
+            {
+                const cstrview rest = contents_.view(strings.sh_offset + index);
+                return str{rest.view(0, rest.find('\0').value_or(rest.size()))};
+            }
+            return str{};
+        }
+    };
+
+    // Resolves addresses to (demangled) function names, each file is only loaded once.
+    class symbolizer final
+    {
+      public:
+        [[nodiscard]] const file& get(const str& path)
+        {
+            auto res = files_.insert_inplace(path);
+            if (res.was_inserted())
+            {
+                // A file that can't be loaded is kept (empty) so that it's only tried once.
+                static_cast<void>(res.value().load(path));
+            }
+            return res.value();
+        }
+
+        // The address is a virtual address in the file, not a runtime address.
+        [[nodiscard]] str name(const str& path, const u64 address)
+        {
+            if (const symbol* sym = get(path).find(address))
+            {
+                return demangle(sym->name);
+            }
+            return concat("[", path, "]");
+        }
+
+      private:
+        map::unsorted<str, file> files_;
+    };
+}
@@ -0,0 +1,734 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+#include <sys/stat.h> // stat
+#include <dirent.h>   // opendir, readdir
+#include <cmath>      // log, sqrt
+#include <cstring>    // strlen
+
+namespace snn::app::fuzz
+{
+    // Progress of a libFuzzer target, parsed from its status lines, e.g. (tab after the number):
+    // #262144 pulse  cov: 240 ft: 555 corp: 36/1509b lim: 2863 exec/s: 43690 rss: 92Mb
+    // Or with `-fork=N`:
+    // #524288: cov: 240 ft: 555 corp: 36 exec/s 43690 oom/timeout/crash: 0/0/0 time: 12s job: 4
+    struct progress final
+    {
+        u64 executions       = 0;
+        u64 coverage         = 0; // Edges ("cov").
+        u64 features         = 0; // "ft"
+        u64 corpus           = 0; // Units
+        u64 execs_per_second = 0;
+        u64 rss              = 0; // Bytes, zero if not reported.
+    };
+
+    // First and last progress of a target during a run.
+    struct outcome final
+    {
+        progress first;
+        progress last;
+        bool failed = false; // E.g. found a crash.
+    };
+
+    namespace detail
+    {
+        // Leading digits of `s`, e.g. 36 for "36/1509b" and 92 for "92Mb".
+        [[nodiscard]] constexpr optional<u64> parse_leading(const cstrview s) noexcept
+        {
+            usize size = 0;
+            while (size < s.size() && chr::is_digit(s.at(size, promise::within_bounds)))
+            {
+                ++size;
+            }
+            return number::parse(s.view(0, size));
+        }
+    }
+
+    [[nodiscard]] inline optional<progress> parse_progress(cstrview line)
+    {
+        if (!line.has_front('#'))
+        {
+            return nullopt;
+        }
+        line.drop_front_n(1);
+
+        vec<cstrview> words;
+        for (const cstrview word : string::range::split{line, ' '})
+        {
+            if (word)
+            {
+                words.append(word);
+            }
+        }
+
+        if (words.is_empty())
+        {
+            return nullopt;
+        }
+
+        progress p;
+        if (const auto n = detail::parse_leading(words.at(0, promise::within_bounds)))
+        {
+            p.executions = n.value();
+        }
+        else
+        {
+            return nullopt;
+        }
+
+        bool has_coverage = false;
+        for (usize i = 1; i + 1 < words.count(); ++i)
+        {
+            const cstrview key = words.at(i, promise::within_bounds);
+            const auto value   = detail::parse_leading(words.at(i + 1, promise::within_bounds));
+            if (!value)
+            {
+                continue;
+            }
+
+            if (key == "cov:")
+            {
+                p.coverage   = value.value();
+                has_coverage = true;
+            }
+            else if (key == "ft:")
+            {
+                p.features = value.value();
+            }
+            else if (key == "corp:")
+            {
+                p.corpus = value.value();
+            }
+            else if (key == "exec/s:" || key == "exec/s")
+            {
+                p.execs_per_second = value.value();
+            }
+            else if (key == "rss:")
+            {
+                p.rss = value.value() << 20; // Megabytes
+            }
+        }
+
+        if (!has_coverage)
+        {
+            return nullopt; // E.g. "#0\tREAD units: 36"
+        }
+
+        return p;
+    }
+
+    // Split `cores` between `count` targets that run at the same time (at least one each).
+    [[nodiscard]] inline vec<usize> split_cores(const usize cores, const usize count)
+    {
+        vec<usize> workers{container::reserve, count};
+        for (usize i = 0; i < count; ++i)
+        {
+            usize n = 1;
+            if (count < cores)
+            {
+                n = cores / count + (i < cores % count ? 1 : 0);
+            }
+            workers.append(n);
+        }
+        return workers;
+    }
+
+    // libFuzzer arguments for a target with its corpus in `corpus` (with a trailing slash).
+    // Crash reproducers are written to `artifact_prefix` (e.g. the directory of the target). With
+    // more than one worker libFuzzer runs in fork mode (`-fork=N`), which still reports combined
+    // progress on standard error. A `max_total_time` of zero means no time limit.
+    [[nodiscard]] inline vec<str> arguments(const cstrview corpus, const usize workers,
+                                            const u64 max_total_time,
+                                            const cstrview artifact_prefix)
+    {
+        vec<str> args{container::reserve, 6};
+        args.append("-rss_limit_mb=3072");
+        args.append("-timeout=5");
+        if (max_total_time > 0)
+        {
+            str arg = "-max_total_time=";
+            arg << as_num(max_total_time);
+            args.append(std::move(arg));
+        }
+        if (workers > 1)
+        {
+            str arg = "-fork=";
+            arg << as_num(workers);
+            args.append(std::move(arg));
+        }
+        if (artifact_prefix)
+        {
+            args.append(concat("-artifact_prefix=", artifact_prefix));
+        }
+        args.append(str{corpus});
+        return args;
+    }
+
+    // Status of a target for the combined status line, e.g.
+    // "base64 43690 exec/s cov 240 ft 555 corp 36".
+    [[nodiscard]] inline str status(const cstrview name, const progress& p)
+    {
+        str s{name};
+        s << ' ' << as_num(p.execs_per_second) << " exec/s cov " << as_num(p.coverage) << " ft "
+          << as_num(p.features) << " corp " << as_num(p.corpus);
+        return s;
+    }
+
+    // A file in a corpus directory.
+    struct input final
+    {
+        str path;
+        u64 size = 0;
+    };
+
+    // Regular files in a corpus directory (with a trailing slash, not recursive), in directory
+    // order. Returns `nullopt` if the directory can't be read.
+    [[nodiscard]] inline optional<vec<input>> corpus_inputs(const str& dir)
+    {
+        DIR* const d = ::opendir(dir.null_terminated().get());
+        if (d == nullptr)
+        {
+            return nullopt;
+        }
+
+        vec<input> inputs;
+        while (const dirent* const entry = ::readdir(d))
+        {
+            const cstrview name{entry->d_name, std::strlen(entry->d_name)};
+            if (name.has_front('.'))
+            {
+                continue; // ".", ".." and hidden files.
+            }
+
+            input in;
+            in.path = concat(dir, name);
+
+            struct stat st{};
+            if (::stat(in.path.null_terminated().get(), &st) == 0 && S_ISREG(st.st_mode))
+            {
+                in.size = static_cast<u64>(st.st_size);
+                inputs.append(std::move(in));
+            }
+        }
+        ::closedir(d);
+
+        return inputs;
+    }
+
+    // Number of processes to replay `count` inputs with on `cores`: at least 16 inputs per process
+    // (starting a process isn't free) and at most 1000 (command line length).
+    [[nodiscard]] constexpr usize replay_parts(const usize count, const usize cores) noexcept
+    {
+        constexpr usize min_inputs = 16;
+        constexpr usize max_inputs = 1000;
+
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        const usize parts = math::min(cores, (count + min_inputs - 1) / min_inputs);
+        return math::max(math::max(usize{1}, parts), (count + max_inputs - 1) / max_inputs);
+    }
+
+    // Split inputs by `sizes` into `parts` groups of about the same total size (largest first,
+    // each to the smallest group), returns the indexes of each group.
+    [[nodiscard]] inline vec<vec<usize>> partition(const vec<u64>& sizes, const usize parts)
+    {
+        vec<usize> order{container::reserve, sizes.count()};
+        for (usize i = 0; i < sizes.count(); ++i)
+        {
+            order.append(i);
+        }
+        algo::sort(order.range(), [&sizes](const usize a, const usize b) {
+            const u64 size_a = sizes.at(a, promise::within_bounds);
+            const u64 size_b = sizes.at(b, promise::within_bounds);
+            return size_a > size_b || (size_a == size_b && a < b);
+        });
+
+        const usize count = math::max(usize{1}, parts);
+
+        vec<vec<usize>> groups{container::reserve, count};
+        vec<u64> loads{container::reserve, count};
+        for (usize i = 0; i < count; ++i)
+        {
+            groups.append(vec<usize>{});
+            loads.append(0);
+        }
+
+        for (const usize index : order)
+        {
+            usize least = 0;
+            for (usize i = 1; i < count; ++i)
+            {
+                if (loads.at(i, promise::within_bounds) < loads.at(least, promise::within_bounds))
+                {
+                    least = i;
+                }
+            }
+            groups.at(least, promise::within_bounds).append(index);
+            // Count every input as at least one byte, so that empty inputs are spread too.
+            loads.at(least, promise::within_bounds) +=
+                math::max(u64{1}, sizes.at(index, promise::within_bounds));
+        }
+
+        return groups;
+    }
+
+    // An input executed by libFuzzer (when it is given files instead of a corpus directory), parsed
+    // from lines like: "Executed dir/b.corpus/0a1b in 12 ms"
+    struct executed final
+    {
+        cstrview input;
+        u64 ms = 0;
+    };
+
+    [[nodiscard]] constexpr optional<executed> parse_executed(cstrview line) noexcept
+    {
+        if (!line.has_front("Executed ") || !line.has_back(" ms"))
+        {
+            return nullopt;
+        }
+        line.drop_front_n(string_size("Executed "));
+        line.drop_back_n(string_size(" ms"));
+
+        usize pos = line.size();
+        while (pos > 0 && line.at(pos - 1, promise::within_bounds) != ' ')
+        {
+            --pos;
+        }
+
+        const auto ms = number::parse(line.view(pos));
+        line.truncate(pos);
+        if (!ms || !line.has_back(" in "))
+        {
+            return nullopt;
+        }
+        line.drop_back_n(string_size(" in "));
+
+        if (line.is_empty())
+        {
+            return nullopt;
+        }
+        return executed{line, ms.value()};
+    }
+
+    // Duration in seconds with an optional suffix (`s`, `m`, `h` or `d`), e.g. "90", "30m" or
+    // "4h".
+    [[nodiscard]] constexpr optional<u64> parse_duration(cstrview s) noexcept
+    {
+        u64 multiplier = 1;
+        if (s.has_back('m'))
+        {
+            multiplier = 60;
+        }
+        else if (s.has_back('h'))
+        {
+            multiplier = 60 * 60;
+        }
+        else if (s.has_back('d'))
+        {
+            multiplier = 24 * 60 * 60;
+        }
+
+        if (multiplier > 1 || s.has_back('s'))
+        {
+            s.drop_back_n(1);
+        }
+
+        const auto n = number::parse(s);
+        if (!n || n.value() == 0 || n.value() > constant::limit<u64>::max / multiplier)
+        {
+            return nullopt;
+        }
+        return n.value() * multiplier;
+    }
+
+    // Length of a time slice when a budget (seconds) is shared by `count` targets: about four
+    // slices per target, but at least a minute (starting a target and loading its corpus isn't
+    // free) and at most 15 minutes, never longer than the budget.
+    [[nodiscard]] constexpr u64 slice_seconds(const u64 budget, const usize count) noexcept
+    {
+        constexpr u64 min_slice = 60;
+        constexpr u64 max_slice = 900;
+        const u64 slice         = budget / (math::max(usize{1}, count) * 4);
+        return math::min(budget, math::min(max_slice, math::max(min_slice, slice)));
+    }
+
+    // Per-target results of earlier time slices (keys, see `timings::keys`), used to give more
+    // slices to targets whose coverage is still growing. Each target is an arm of a multi-armed
+    // bandit: the reward of a slice is the growth of the features ("ft") per minute mapped to
+    // 0-1000, older slices are discounted (by 10% per slice), and the targets are picked by UCB1
+    // (mean reward plus an exploration bonus for targets with few slices).
+    class history final
+    {
+      public:
+        struct entry final
+        {
+            u64 slices   = 0; // Discounted, in thousandths.
+            u64 reward   = 0; // Discounted sum, 0-1000 per slice.
+            u64 features = 0; // At the end of the last slice.
+            u64 seconds  = 0; // Fuzzed in total.
+        };
+
+        // Format (tab separated): <slices> <reward> <features> <seconds> <key>
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            vec<cstrview> fields;
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                fields.clear();
+                for (const cstrview field : string::range::split{line, '\t'})
+                {
+                    fields.append(field);
+                }
+
+                if (fields.count() != 5 || fields.at(4, promise::within_bounds).is_empty())
+                {
+                    return false;
+                }
+
+                entry e;
+                u64* const values[] = {&e.slices, &e.reward, &e.features, &e.seconds};
+                for (usize i = 0; i < 4; ++i)
+                {
+                    const auto n = number::parse(fields.at(i, promise::within_bounds));
+                    if (!n)
+                    {
+                        return false;
+                    }
+                    *values[i] = n.value(promise::has_value);
+                }
+
+                entries_.insert_or_assign(fields.at(4, promise::within_bounds), e);
+            }
+            return true;
+        }
+
+        [[nodiscard]] optional<entry> get(const cstrview key) const
+        {
+            if (const auto e = entries_.get(key))
+            {
+                return e.value();
+            }
+            return nullopt;
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return entries_.count();
+        }
+
+        [[nodiscard]] bool is_modified() const noexcept
+        {
+            return modified_;
+        }
+
+        // Reward (0-1000) of a slice that grew the features from `before` to `after`.
+        [[nodiscard]] static constexpr u64 reward(const u64 before, const u64 after,
+                                                  const u64 seconds) noexcept
+        {
+            constexpr u64 half = 10; // New features per minute that give half the reward.
+            if (after <= before)
+            {
+                return 0;
+            }
+            const u64 per_minute = (after - before) * 60 / math::max(u64{1}, seconds);
+            return per_minute * 1000 / (per_minute + half);
+        }
+
+        void add_slice(const cstrview key, const u64 before, const u64 after, const u64 seconds)
+        {
+            auto& e    = entries_.insert_inplace(key).value();
+            e.slices   = e.slices * 9 / 10 + 1000;
+            e.reward   = e.reward * 9 / 10 + reward(before, after, seconds);
+            e.features = after;
+            e.seconds  = e.seconds + seconds;
+            modified_  = true;
+        }
+
+        // Indexes of the (at most) `count` targets to run next, best first. Targets without
+        // history are picked first (in order).
+        [[nodiscard]] vec<usize> schedule(const vec<str>& keys, const usize count) const
+        {
+            double total = 0;
+            for (const auto& key : keys)
+            {
+                total += static_cast<double>(get(key).value_or_default().slices) / 1000;
+            }
+
+            vec<double> scores{container::reserve, keys.count()};
+            for (const auto& key : keys)
+            {
+                const entry e = get(key).value_or_default();
+                if (e.slices == 0)
+                {
+                    scores.append(1e9); // Unexplored.
+                    continue;
+                }
+
+                const double n    = static_cast<double>(e.slices) / 1000;
+                const double mean = static_cast<double>(e.reward) / 1000 / n;
+                scores.append(mean + std::sqrt(2 * std::log(math::max(1.0, total)) / n));
+            }
+
+            vec<bool> picked{container::reserve, keys.count()};
+            for (usize i = 0; i < keys.count(); ++i)
+            {
+                picked.append(false);
+            }
+
+            vec<usize> order{container::reserve, math::min(count, keys.count())};
+            while (order.count() < count && order.count() < keys.count())
+            {
+                usize best = constant::npos;
+                for (usize i = 0; i < keys.count(); ++i)
+                {
+                    if (!picked.at(i, promise::within_bounds) &&
+                        (best == constant::npos || scores.at(i, promise::within_bounds) >
+                                                       scores.at(best, promise::within_bounds)))
+                    {
+                        best = i;
+                    }
+                }
+                picked.at(best, promise::within_bounds) = true;
+                order.append(best);
+            }
+            return order;
+        }
+
+        [[nodiscard]] strbuf serialize() const
+        {
+            strbuf out{container::reserve, entries_.count() * 100};
+            for (const auto& p : entries_)
+            {
+                const entry& e = p.second;
+                out << as_num(e.slices) << '\t' << as_num(e.reward) << '\t' << as_num(e.features)
+                    << '\t' << as_num(e.seconds) << '\t' << p.first << '\n';
+            }
+            return out;
+        }
+
+      private:
+        map::sorted<str, entry> entries_;
+        bool modified_ = false;
+    };
+
+    // Throughput of the targets over time (keys, see `timings::keys`), one sample per run with the
+    // commit that was fuzzed. A drop in executions per second (per worker) between commits often
+    // means that the code under test got slower. Samples are kept in the order they were added.
+    class throughput final
+    {
+      public:
+        struct sample final
+        {
+            u64 time = 0; // Unix time.
+            str commit;   // Abbreviated hash, "-" if unknown.
+            u64 workers          = 1;
+            u64 execs_per_second = 0; // All workers.
+            u64 coverage         = 0;
+            u64 features         = 0;
+            u64 rss              = 0; // Bytes, zero if not reported.
+
+            [[nodiscard]] u64 execs_per_worker() const noexcept
+            {
+                return execs_per_second / math::max(u64{1}, workers);
+            }
+        };
+
+        // Samples kept per target (oldest are dropped when serialized).
+        static constexpr usize max_samples = 200;
+
+        // Format (tab separated): <time> <commit> <workers> <exec/s> <cov> <ft> <rss> <key>
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            vec<cstrview> fields;
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                fields.clear();
+                for (const cstrview field : string::range::split{line, '\t'})
+                {
+                    fields.append(field);
+                }
+
+                if (fields.count() != 8 || fields.at(1, promise::within_bounds).is_empty() ||
+                    fields.at(7, promise::within_bounds).is_empty())
+                {
+                    return false;
+                }
+
+                sample s;
+                s.commit = str{fields.at(1, promise::within_bounds)};
+
+                u64* const values[]         = {&s.time,     &s.workers,  &s.execs_per_second,
+                                               &s.coverage, &s.features, &s.rss};
+                constexpr usize positions[] = {0, 2, 3, 4, 5, 6};
+                for (usize i = 0; i < 6; ++i)
+                {
+                    const auto n = number::parse(fields.at(positions[i], promise::within_bounds));
+                    if (!n)
+                    {
+                        return false;
+                    }
+                    *values[i] = n.value(promise::has_value);
+                }
+
+                targets_.insert_inplace(fields.at(7, promise::within_bounds))
+                    .value()
+                    .append(std::move(s));
+            }
+            return true;
+        }
+
+        [[nodiscard]] const map::sorted<str, vec<sample>>& targets() const noexcept
+        {
+            return targets_;
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return targets_.count();
+        }
+
+        [[nodiscard]] bool is_modified() const noexcept
+        {
+            return modified_;
+        }
+
+        void add(const cstrview key, sample s)
+        {
+            targets_.insert_inplace(key).value().append(std::move(s));
+            modified_ = true;
+        }
+
+        [[nodiscard]] strbuf serialize() const
+        {
+            strbuf out{container::reserve, targets_.count() * max_samples * 60};
+            for (const auto& p : targets_)
+            {
+                const vec<sample>& samples = p.second;
+                const usize skip =
+                    samples.count() > max_samples ? samples.count() - max_samples : 0;
+                for (usize i = skip; i < samples.count(); ++i)
+                {
+                    const sample& s = samples.at(i, promise::within_bounds);
+                    out << as_num(s.time) << '\t' << s.commit << '\t' << as_num(s.workers) << '\t'
+                        << as_num(s.execs_per_second) << '\t' << as_num(s.coverage) << '\t'
+                        << as_num(s.features) << '\t' << as_num(s.rss) << '\t' << p.first << '\n';
+                }
+            }
+            return out;
+        }
+
+      private:
+        map::sorted<str, vec<sample>> targets_;
+        bool modified_ = false;
+    };
+
+    // Throughput (executions per second per worker) of the latest commit compared to the runs
+    // of earlier commits.
+    struct trend final
+    {
+        u64 latest     = 0; // Median of the runs of the latest commit.
+        u64 baseline   = 0; // Median of the last runs of earlier commits.
+        usize runs     = 0; // Runs that make up the baseline.
+        bool regressed = false;
+    };
+
+    namespace detail
+    {
+        [[nodiscard]] inline u64 median(vec<u64> values)
+        {
+            if (values.is_empty())
+            {
+                return 0;
+            }
+            algo::sort(values.range());
+            const usize mid = values.count() / 2;
+            if (values.count() % 2 == 0)
+            {
+                return (values.at(mid - 1, promise::within_bounds) +
+                        values.at(mid, promise::within_bounds)) /
+                       2;
+            }
+            return values.at(mid, promise::within_bounds);
+        }
+    }
+
+    // Compare the latest commit with (at most) the last 10 runs of earlier commits. It has
+    // regressed if it is `percent` slower, with at least 3 earlier runs (exec/s is noisy).
+    [[nodiscard]] inline trend analyze(const vec<throughput::sample>& samples, const u64 percent)
+    {
+        trend t;
+        if (samples.is_empty())
+        {
+            return t;
+        }
+
+        constexpr usize max_runs = 10;
+        constexpr usize min_runs = 3;
+
+        const str& commit = samples.back().value().commit;
+
+        vec<u64> latest;
+        vec<u64> earlier;
+        for (usize i = samples.count(); i > 0; --i)
+        {
+            const throughput::sample& s = samples.at(i - 1, promise::within_bounds);
+            if (s.commit == commit)
+            {
+                latest.append(s.execs_per_worker());
+            }
+            else if (earlier.count() < max_runs)
+            {
+                earlier.append(s.execs_per_worker());
+            }
+        }
+
+        t.latest    = detail::median(std::move(latest));
+        t.baseline  = detail::median(earlier);
+        t.runs      = earlier.count();
+        t.regressed = t.runs >= min_runs && t.latest * 100 < t.baseline * (100 - percent);
+        return t;
+    }
+
+    // Unicode bar per value, scaled between the smallest and the largest, e.g. "▁▄█".
+    [[nodiscard]] inline str sparkline(const vec<u64>& values)
+    {
+        constexpr cstrview bars[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+
+        u64 lowest  = constant::limit<u64>::max;
+        u64 highest = 0;
+        for (const u64 v : values)
+        {
+            lowest  = math::min(lowest, v);
+            highest = math::max(highest, v);
+        }
+
+        str s;
+        for (const u64 v : values)
+        {
+            const u64 level = highest > lowest ? (v - lowest) * 7 / (highest - lowest) : 3;
+            s << bars[level];
+        }
+        return s;
+    }
+}
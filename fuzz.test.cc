@@ -0,0 +1,237 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/fuzz.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            const auto p = app::fuzz::parse_progress("#262144\tpulse  cov: 240 ft: 555 corp: "
+                                                     "36/1509b lim: 2863 exec/s: 43690 rss: 92Mb");
+            snn_require(p);
+            snn_require(p.value().executions == 262144);
+            snn_require(p.value().coverage == 240);
+            snn_require(p.value().features == 555);
+            snn_require(p.value().corpus == 36);
+            snn_require(p.value().execs_per_second == 43690);
+            snn_require(p.value().rss == u64{92} << 20);
+        }
+        {
+            const auto p = app::fuzz::parse_progress(
+                "#524288: cov: 241 ft: 560 corp: 37 exec/s 40000 oom/timeout/crash: 0/0/0 time: "
+                "12s job: 4 dft_time: 0");
+            snn_require(p);
+            snn_require(p.value().executions == 524288);
+            snn_require(p.value().coverage == 241);
+            snn_require(p.value().features == 560);
+            snn_require(p.value().corpus == 37);
+            snn_require(p.value().execs_per_second == 40000);
+            snn_require(p.value().rss == 0);
+        }
+        {
+            snn_require(!app::fuzz::parse_progress(""));
+            snn_require(!app::fuzz::parse_progress("#"));
+            snn_require(!app::fuzz::parse_progress("#0\tREAD units: 36"));
+            snn_require(!app::fuzz::parse_progress("INFO: Seed: 1234"));
+            snn_require(!app::fuzz::parse_progress("#x cov: 1"));
+            snn_require(app::fuzz::parse_progress("#37\tINITED cov: 240 ft: 555 corp: 36/1509b "
+                                                  "exec/s: 0 rss: 32Mb"));
+        }
+        {
+            const auto w = app::fuzz::split_cores(32, 3);
+            snn_require(w.count() == 3);
+            snn_require(w.at(0).value() == 11);
+            snn_require(w.at(1).value() == 11);
+            snn_require(w.at(2).value() == 10);
+
+            const auto one_each = app::fuzz::split_cores(2, 5);
+            snn_require(one_each.count() == 5);
+            snn_require(one_each.at(4).value() == 1);
+        }
+        {
+            const auto args = app::fuzz::arguments("a/b.corpus/", 4, 900, "a/");
+            snn_require(args.count() == 6);
+            snn_require(args.at(2).value() == "-max_total_time=900");
+            snn_require(args.at(3).value() == "-fork=4");
+            snn_require(args.at(4).value() == "-artifact_prefix=a/");
+            snn_require(args.at(5).value() == "a/b.corpus/");
+
+            const auto single = app::fuzz::arguments("b.corpus/", 1, 0, "");
+            snn_require(single.count() == 3);
+            snn_require(single.at(2).value() == "b.corpus/");
+        }
+        {
+            app::fuzz::progress p;
+            p.execs_per_second = 43690;
+            p.coverage         = 240;
+            p.features         = 555;
+            p.corpus           = 36;
+            snn_require(app::fuzz::status("base64", p) ==
+                        "base64 43690 exec/s cov 240 ft 555 corp 36");
+        }
+        {
+            static_assert(app::fuzz::replay_parts(0, 8) == 0);
+            static_assert(app::fuzz::replay_parts(1, 8) == 1);
+            static_assert(app::fuzz::replay_parts(40, 8) == 3);
+            static_assert(app::fuzz::replay_parts(10'000, 8) == 10);
+            static_assert(app::fuzz::replay_parts(10'000, 32) == 32);
+
+            vec<u64> sizes;
+            sizes.append(10);
+            sizes.append(50);
+            sizes.append(0);
+            sizes.append(30);
+            sizes.append(20);
+
+            const auto groups = app::fuzz::partition(sizes, 2);
+            snn_require(groups.count() == 2);
+            snn_require(groups.at(0).value().count() == 2); // 50, 10
+            snn_require(groups.at(0).value().at(0).value() == 1);
+            snn_require(groups.at(0).value().at(1).value() == 0);
+            snn_require(groups.at(1).value().count() == 3); // 30, 20, 0
+            snn_require(groups.at(1).value().at(0).value() == 3);
+            snn_require(groups.at(1).value().at(2).value() == 2);
+
+            snn_require(app::fuzz::partition(sizes, 0).count() == 1);
+        }
+        {
+            constexpr auto e = app::fuzz::parse_executed("Executed a/b.corpus/0a1b in 12 ms");
+            static_assert(e);
+            static_assert(e.value().input == "a/b.corpus/0a1b");
+            static_assert(e.value().ms == 12);
+
+            static_assert(app::fuzz::parse_executed("Executed x in y in 0 ms").value().input ==
+                          "x in y");
+            static_assert(!app::fuzz::parse_executed("Executed  in 12 ms"));
+            static_assert(!app::fuzz::parse_executed("Executed x in ms"));
+            static_assert(!app::fuzz::parse_executed("Running: a/b.corpus/0a1b"));
+        }
+        {
+            static_assert(app::fuzz::parse_duration("90").value() == 90);
+            static_assert(app::fuzz::parse_duration("90s").value() == 90);
+            static_assert(app::fuzz::parse_duration("30m").value() == 1800);
+            static_assert(app::fuzz::parse_duration("4h").value() == 14400);
+            static_assert(app::fuzz::parse_duration("2d").value() == 172800);
+            static_assert(!app::fuzz::parse_duration(""));
+            static_assert(!app::fuzz::parse_duration("h"));
+            static_assert(!app::fuzz::parse_duration("0h"));
+            static_assert(!app::fuzz::parse_duration("4w"));
+            static_assert(!app::fuzz::parse_duration("-4h"));
+
+            static_assert(app::fuzz::slice_seconds(14400, 4) == 900);
+            static_assert(app::fuzz::slice_seconds(3600, 3) == 300);
+            static_assert(app::fuzz::slice_seconds(600, 10) == 60);
+            static_assert(app::fuzz::slice_seconds(30, 1) == 30);
+        }
+        {
+            static_assert(app::fuzz::history::reward(100, 100, 60) == 0);
+            static_assert(app::fuzz::history::reward(100, 90, 60) == 0);
+            static_assert(app::fuzz::history::reward(100, 110, 60) == 500);
+            static_assert(app::fuzz::history::reward(0, 1000, 60) >= 990);
+
+            app::fuzz::history h;
+            snn_require(h.parse("1900\t1500\t555\t1800\ta/decode.fuzz\n"
+                                "1000\t0\t201\t900\ta/encode.fuzz\n"));
+            snn_require(h.count() == 2);
+            snn_require(!h.is_modified());
+            snn_require(h.get("a/decode.fuzz").value().features == 555);
+            snn_require(!h.get("a/other.fuzz"));
+
+            vec<str> keys;
+            keys.append("a/decode.fuzz");
+            keys.append("a/encode.fuzz");
+            keys.append("a/new.fuzz");
+
+            // Unexplored first, then growing coverage before plateaued.
+            const auto order = h.schedule(keys, 3);
+            snn_require(order.count() == 3);
+            snn_require(order.at(0).value() == 2);
+            snn_require(order.at(1).value() == 0);
+            snn_require(order.at(2).value() == 1);
+            snn_require(h.schedule(keys, 1).count() == 1);
+
+            h.add_slice("a/encode.fuzz", 201, 211, 60);
+            snn_require(h.is_modified());
+            const auto e = h.get("a/encode.fuzz").value();
+            snn_require(e.slices == 1900);
+            snn_require(e.reward == 500);
+            snn_require(e.features == 211);
+            snn_require(e.seconds == 960);
+
+            snn_require(h.serialize() == "1900\t1500\t555\t1800\ta/decode.fuzz\n"
+                                         "1900\t500\t211\t960\ta/encode.fuzz\n");
+
+            snn_require(!h.parse("1\t2\t3\ta\n"));
+            snn_require(!h.parse("1\t2\t3\tx\ta\n"));
+        }
+        {
+            app::fuzz::throughput t;
+            snn_require(t.parse("1700000000\tabc1\t4\t40000\t240\t555\t96468992\ta/decode.fuzz\n"
+                                "1700000100\tabc2\t2\t20000\t240\t555\t0\ta/decode.fuzz\n"
+                                "1700000200\tabc3\t1\t11000\t241\t560\t0\ta/decode.fuzz\n"));
+            snn_require(t.count() == 1);
+            snn_require(!t.is_modified());
+
+            const auto& samples = t.targets().get("a/decode.fuzz").value();
+            snn_require(samples.count() == 3);
+            snn_require(samples.at(0).value().commit == "abc1");
+            snn_require(samples.at(0).value().execs_per_worker() == 10000);
+            snn_require(samples.at(0).value().rss == 96468992);
+
+            // Only two earlier runs, not enough to flag a regression.
+            const auto few = app::fuzz::analyze(samples, 20);
+            snn_require(few.latest == 11000);
+            snn_require(few.runs == 2);
+            snn_require(!few.regressed);
+
+            app::fuzz::throughput::sample s;
+            s.time             = 1700000300;
+            s.commit           = "abc4";
+            s.workers          = 1;
+            s.execs_per_second = 6000;
+            t.add("a/decode.fuzz", s);
+            snn_require(t.is_modified());
+
+            const auto trend = app::fuzz::analyze(t.targets().get("a/decode.fuzz").value(), 20);
+            snn_require(trend.latest == 6000);
+            snn_require(trend.baseline == 10000);
+            snn_require(trend.runs == 3);
+            snn_require(trend.regressed);
+
+            s.execs_per_second = 9000;
+            t.add("a/decode.fuzz", s);
+            const auto same_commit =
+                app::fuzz::analyze(t.targets().get("a/decode.fuzz").value(), 20);
+            snn_require(same_commit.latest == 7500);
+            snn_require(same_commit.regressed);
+
+            snn_require(app::fuzz::analyze({}, 20).runs == 0);
+
+            snn_require(t.serialize().view().has_front(
+                "1700000000\tabc1\t4\t40000\t240\t555\t96468992\ta/decode.fuzz\n"));
+
+            snn_require(!t.parse("1\tabc\t1\t2\t3\t4\t5\n"));
+            snn_require(!t.parse("1\t\t1\t2\t3\t4\t5\ta\n"));
+            snn_require(!t.parse("1\tabc\tx\t2\t3\t4\t5\ta\n"));
+        }
+        {
+            vec<u64> values;
+            values.append(1);
+            values.append(2);
+            values.append(3);
+            snn_require(app::fuzz::sparkline(values) == "▁▄█");
+            values.append(3);
+            snn_require(app::fuzz::sparkline(values) == "▁▄██");
+
+            vec<u64> flat;
+            flat.append(5);
+            flat.append(5);
+            snn_require(app::fuzz::sparkline(flat) == "▄▄");
+            snn_require(app::fuzz::sparkline(vec<u64>{}).is_empty());
+        }
+    }
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/chr/common.hh"
+#include "snn-core/process/execute.hh"
+#include "build-tool/clock.hh"
+#include <sys/wait.h> // waitid
+#include <time.h>     // nanosleep
+#include <cerrno>
+#include <csignal> // kill
+
+namespace snn::app::hang
+{
+    // Stack traces of all threads of a (hung) process from `eu-stack` (elfutils) or `gdb`,
+    // whichever is installed and allowed to attach first. Empty if neither worked, e.g. if
+    // `/proc/sys/kernel/yama/ptrace_scope` only allows debuggers to attach to their descendants.
+    [[nodiscard]] inline strbuf stack_dump(const pid_t pid)
+    {
+        constexpr cstrview commands[] = {
+            "eu-stack -p ",
+            "gdb -batch -nx -ex 'thread apply all bt' -p ",
+        };
+
+        strbuf dump{container::reserve, 4 * constant::size::kibibyte<usize>};
+        for (const cstrview command : commands)
+        {
+            str command_line;
+            command_line << command << as_num(pid) << " 2>&1";
+
+            process::command cmd;
+            cmd << command_line;
+
+            dump.clear();
+            auto output = process::execute_and_consume_output(cmd);
+            if (output)
+            {
+                while (const auto line = output.read_line<cstrview>())
+                {
+                    auto rng = line.value(promise::has_value).range();
+                    rng.pop_back_while(chr::is_ascii_control_or_space);
+                    dump << cstrview{rng} << '\n';
+                }
+
+                if (output.exit_status() == constant::exit::success && dump)
+                {
+                    return dump;
+                }
+            }
+        }
+
+        dump.clear();
+        return dump;
+    }
+
+    // Fallback if there is no stack dump: abort the process (a core dump if enabled, sanitizers
+    // print a stack trace with `handle_abort=1`) and give it up to `grace_ns` to exit. The
+    // process is not reaped.
+    inline void abort_and_wait(const pid_t pid, const u64 grace_ns) noexcept
+    {
+        if (::kill(pid, SIGABRT) != 0)
+        {
+            return;
+        }
+
+        const u64 end = clock::monotonic() + grace_ns;
+        while (clock::monotonic() < end)
+        {
+            ::siginfo_t info{};
+            if (::waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOHANG | WNOWAIT) == 0)
+            {
+                if (info.si_pid == pid)
+                {
+                    return; // Exited (still waitable).
+                }
+            }
+            else if (errno != ECHILD || ::kill(pid, 0) != 0)
+            {
+                // Failed, or not our child (e.g. a test in a bundle) and gone.
+                return;
+            }
+
+            timespec ts{};
+            ts.tv_nsec = 10'000'000;
+            ::nanosleep(&ts, nullptr);
+        }
+    }
+}
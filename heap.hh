@@ -0,0 +1,227 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/array.hh"
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/range/step.hh"
+#include "snn-core/range/view/enumerate.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/elf.hh"
+#include "build-tool/number.hh"
+#include "build-tool/report.hh"
+
+namespace snn::app::heap
+{
+    // Report written by the heap interposer (see `preload::heap_source`).
+    class report final
+    {
+      public:
+        enum call : u8
+        {
+            call_malloc,
+            call_calloc,
+            call_realloc,
+            call_aligned,
+            call_new,
+            call_free,
+            call_delete,
+        };
+
+        struct frame final
+        {
+            u64 offset = 0; // From the module load address.
+            str module;
+        };
+
+        struct site final
+        {
+            u64 count = 0;
+            u64 bytes = 0;
+            vec<frame> frames;
+        };
+
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            vec<cstrview> fields;
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                fields.clear();
+                for (const cstrview field : string::range::split{line, '\t'})
+                {
+                    fields.append(field);
+                }
+
+                const cstrview type = fields.front(promise::not_empty);
+                if (type == "calls" && fields.count() == calls_.count() + 1)
+                {
+                    for (const auto i : range::step<usize>{0, calls_.count()})
+                    {
+                        calls_.at(i, promise::within_bounds) = number_(fields, i + 1);
+                    }
+                }
+                else if (type == "bytes" && fields.count() == 3)
+                {
+                    allocated_ = number_(fields, 1);
+                    peak_live_ = number_(fields, 2);
+                }
+                else if (type == "dropped" && fields.count() == 2)
+                {
+                    dropped_ = number_(fields, 1);
+                }
+                else if (type == "site" && fields.count() >= 3 && fields.count() % 2 == 1)
+                {
+                    site s;
+                    s.count = number_(fields, 1);
+                    s.bytes = number_(fields, 2);
+                    for (usize i = 3; i + 1 < fields.count(); i += 2)
+                    {
+                        frame f;
+                        f.offset = number::parse_hex(fields.at(i, promise::within_bounds))
+                                       .value_or(0);
+                        f.module = fields.at(i + 1, promise::within_bounds);
+                        s.frames.append(std::move(f));
+                    }
+                    sites_.append(std::move(s));
+                }
+                else
+                {
+                    return false;
+                }
+            }
+
+            algo::sort(sites_.range(), [](const site& a, const site& b) {
+                if (a.bytes != b.bytes)
+                {
+                    return a.bytes > b.bytes;
+                }
+                return a.count > b.count;
+            });
+
+            return true;
+        }
+
+        [[nodiscard]] u64 allocations() const noexcept
+        {
+            return calls(call_malloc) + calls(call_calloc) + calls(call_realloc) +
+                   calls(call_aligned) + calls(call_new);
+        }
+
+        [[nodiscard]] u64 allocated_bytes() const noexcept
+        {
+            return allocated_;
+        }
+
+        [[nodiscard]] u64 calls(const call c) const noexcept
+        {
+            return calls_.at(c, promise::within_bounds);
+        }
+
+        [[nodiscard]] u64 frees() const noexcept
+        {
+            return calls(call_free) + calls(call_delete);
+        }
+
+        [[nodiscard]] u64 peak_live_bytes() const noexcept
+        {
+            return peak_live_;
+        }
+
+        [[nodiscard]] const vec<site>& sites() const noexcept
+        {
+            return sites_;
+        }
+
+        [[nodiscard]] strbuf format(elf::symbolizer& symbolizer, const usize top) const
+        {
+            strbuf out{container::reserve, 2 * constant::size::kibibyte<usize>};
+
+            fmt::format_append("Allocations: {} (malloc {}, calloc {}, realloc {}, aligned {},"
+                               " new {})\n",
+                               out, promise::no_overlap, allocations(), calls(call_malloc),
+                               calls(call_calloc), calls(call_realloc), calls(call_aligned),
+                               calls(call_new));
+            fmt::format_append("Frees: {} (free {}, delete {})\n", out, promise::no_overlap,
+                               frees(), calls(call_free), calls(call_delete));
+            fmt::format_append("Allocated: {}, peak live: {}\n", out, promise::no_overlap,
+                               report::bytes(allocated_), report::bytes(peak_live_));
+
+            if (sites_)
+            {
+                report::table t;
+                t.add_row("Count", "Bytes", "Site (caller <- caller's caller ...)");
+                for (const auto& s : sites_)
+                {
+                    if (t.count() > top)
+                    {
+                        break;
+                    }
+
+                    str count;
+                    count << as_num(s.count);
+                    t.add_row(std::move(count), report::bytes(s.bytes), site_(symbolizer, s));
+                }
+                out << t.format();
+            }
+
+            if (dropped_ > 0)
+            {
+                fmt::format_append("Warning: {} samples not recorded (site table full)\n", out,
+                                   promise::no_overlap, dropped_);
+            }
+
+            return out;
+        }
+
+      private:
+        array<u64, 7> calls_{};
+        vec<site> sites_;
+        u64 allocated_ = 0;
+        u64 peak_live_ = 0;
+        u64 dropped_   = 0;
+
+        static u64 number_(const vec<cstrview>& fields, const usize index) noexcept
+        {
+            return number::parse(fields.at(index, promise::within_bounds)).value_or(0);
+        }
+
+        static str site_(elf::symbolizer& symbolizer, const site& s)
+        {
+            constexpr usize max_frames = 3;
+
+            str out;
+            for (const auto [i, f] : s.frames.range() | range::v::enumerate{})
+            {
+                if (i == max_frames)
+                {
+                    break;
+                }
+
+                if (i > 0)
+                {
+                    out << " <- ";
+                }
+
+                if (f.module == "?")
+                {
+                    out << "0x";
+                    out.append_integral<math::base::hex>(f.offset);
+                }
+                else
+                {
+                    const u64 address = f.offset + symbolizer.get(f.module).base_address();
+                    out << symbolizer.name(f.module, address);
+                }
+            }
+            return out;
+        }
+    };
+}
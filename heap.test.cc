@@ -0,0 +1,50 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/heap.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            app::heap::report r;
+            snn_require(r.parse("calls\t10\t1\t2\t0\t20\t9\t19\n"
+                                "bytes\t4096\t1536\n"
+                                "dropped\t0\n"
+                                "site\t3\t96\t1a\t?\n"
+                                "site\t20\t2048\tff\t?\t10\t?\n"));
+
+            snn_require(r.allocations() == 33);
+            snn_require(r.frees() == 28);
+            snn_require(r.calls(app::heap::report::call_realloc) == 2);
+            snn_require(r.allocated_bytes() == 4096);
+            snn_require(r.peak_live_bytes() == 1536);
+
+            // Sorted by bytes.
+            snn_require(r.sites().count() == 2);
+            snn_require(r.sites().at(0).value().count == 20);
+            snn_require(r.sites().at(0).value().frames.count() == 2);
+            snn_require(r.sites().at(0).value().frames.at(0).value().offset == 0xff);
+            snn_require(r.sites().at(1).value().bytes == 96);
+
+            app::elf::symbolizer symbolizer;
+            snn_require(r.format(symbolizer, 10) ==
+                        "Allocations: 33 (malloc 10, calloc 1, realloc 2, aligned 0, new 20)\n"
+                        "Frees: 28 (free 9, delete 19)\n"
+                        "Allocated: 4.0 KiB, peak live: 1.5 KiB\n"
+                        "Count    Bytes  Site (caller <- caller's caller ...)\n"
+                        "   20  2.0 KiB  0xff <- 0x10\n"
+                        "    3     96 B  0x1a\n");
+        }
+        {
+            app::heap::report r;
+            snn_require(r.parse(""));
+            snn_require(r.allocations() == 0);
+            snn_require(!r.parse("calls\t1\n"));
+            snn_require(!r.parse("unknown\t1\n"));
+        }
+    }
+}
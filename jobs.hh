@@ -0,0 +1,518 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/array.hh"
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "build-tool/cgroup.hh"
+#include "build-tool/child.hh"
+#include "build-tool/clock.hh"
+#include "build-tool/resources.hh"
+#include <time.h>   // nanosleep
+#include <unistd.h> // sysconf
+#include <cerrno>   // ECANCELED
+#include <csignal>  // raise, sigaction
+
+namespace snn::app::jobs
+{
+    struct job final
+    {
+        str path;
+        vec<str> arguments;
+        vec<str> environment; // "NAME=value"
+        u64 timeout_ns = 0;   // Zero for no timeout.
+        str cgroup;           // Directory of a cgroup to run in (see `cgroup::tree`), optional.
+
+        // Scheduling hints (see `capacity`).
+        usize threads = 1;     // CPUs the job keeps busy.
+        u64 memory    = 0;     // Peak memory in bytes, zero if unknown.
+        bool serial   = false; // Run alone.
+    };
+
+    struct result final
+    {
+        int exit_status      = constant::exit::failure;
+        bool exited_normally = false;
+        bool timed_out       = false;
+        bool out_of_memory   = false; // Killed by the OOM killer in its cgroup.
+        int error_number     = 0;     // Not zero if the job could not be started.
+        resources::usage usage;
+    };
+
+    // Number of online processors (at least one).
+    [[nodiscard]] inline usize processors() noexcept
+    {
+        const long n = ::sysconf(_SC_NPROCESSORS_ONLN);
+        return n > 0 ? static_cast<usize>(n) : 1;
+    }
+
+    // Physical memory in bytes (zero if unknown).
+    [[nodiscard]] inline u64 physical_memory() noexcept
+    {
+        const long pages     = ::sysconf(_SC_PHYS_PAGES);
+        const long page_size = ::sysconf(_SC_PAGESIZE);
+        if (pages > 0 && page_size > 0)
+        {
+            return static_cast<u64>(pages) * static_cast<u64>(page_size);
+        }
+        return 0;
+    }
+
+    // CPUs and memory used by the running jobs. A job is started when it fits: its `threads` on
+    // the free CPUs and its `memory` (if known) in the free memory. A `serial` job only starts
+    // when nothing is running and nothing else starts until it has finished. A job that needs
+    // more than there is starts when nothing else is running (see `needs_all()`).
+    class capacity final
+    {
+      public:
+        explicit capacity(const usize cpus, const u64 memory) noexcept
+            : cpus_{math::max(usize{1}, cpus)},
+              memory_{memory}
+        {
+        }
+
+        [[nodiscard]] bool fits(const job& j) const noexcept
+        {
+            if (running_ == 0)
+            {
+                return true;
+            }
+
+            if (serial_ || j.serial)
+            {
+                return false;
+            }
+
+            if (cpus_used_ + threads_(j) > cpus_)
+            {
+                return false;
+            }
+
+            return memory_ == 0 || j.memory == 0 || memory_used_ + j.memory <= memory_;
+        }
+
+        // True if the job only starts when nothing else is running.
+        [[nodiscard]] bool needs_all(const job& j) const noexcept
+        {
+            return j.serial || (memory_ > 0 && j.memory > memory_);
+        }
+
+        void start(const job& j) noexcept
+        {
+            ++running_;
+            cpus_used_ += threads_(j);
+            memory_used_ += j.memory;
+            serial_ = serial_ || j.serial;
+        }
+
+        void finish(const job& j) noexcept
+        {
+            snn_should(running_ > 0);
+            --running_;
+            cpus_used_ -= threads_(j);
+            memory_used_ -= j.memory;
+            if (j.serial)
+            {
+                serial_ = false;
+            }
+        }
+
+      private:
+        usize cpus_;
+        u64 memory_;
+        usize cpus_used_ = 0;
+        u64 memory_used_ = 0;
+        usize running_   = 0;
+        bool serial_     = false;
+
+        [[nodiscard]] usize threads_(const job& j) const noexcept
+        {
+            return math::min(math::max(usize{1}, j.threads), cpus_);
+        }
+    };
+
+    namespace detail
+    {
+        // Terminal signal received while jobs ran in process groups of their own, zero if none.
+        inline volatile std::sig_atomic_t interrupt_signal = 0;
+
+        inline void on_interrupt(const int sig) noexcept
+        {
+            interrupt_signal = sig;
+        }
+
+        // Children in process groups of their own don't get the signals from the terminal (e.g.
+        // SIGINT on Ctrl-C), so catch them while the children run and kill the children first
+        // (see `wait_polling()`). The signal is raised again (with the previous disposition) on
+        // destruction.
+        class interrupt_guard final
+        {
+          public:
+            explicit interrupt_guard(const bool enabled) noexcept
+                : enabled_{enabled}
+            {
+                interrupt_signal = 0;
+                if (!enabled_)
+                {
+                    return;
+                }
+
+                struct sigaction action{};
+                action.sa_handler = on_interrupt;
+                sigemptyset(&action.sa_mask);
+                for (usize i = 0; i < signals_.count(); ++i)
+                {
+                    ::sigaction(signals_.at(i, promise::within_bounds), &action,
+                                &previous_.at(i, promise::within_bounds));
+                }
+            }
+
+            ~interrupt_guard()
+            {
+                if (!enabled_)
+                {
+                    return;
+                }
+
+                for (usize i = 0; i < signals_.count(); ++i)
+                {
+                    ::sigaction(signals_.at(i, promise::within_bounds),
+                                &previous_.at(i, promise::within_bounds), nullptr);
+                }
+
+                if (const int sig = interrupt_signal; sig != 0)
+                {
+                    interrupt_signal = 0;
+                    ::raise(sig);
+                }
+            }
+
+            // Non-copyable
+            interrupt_guard(const interrupt_guard&)            = delete;
+            interrupt_guard& operator=(const interrupt_guard&) = delete;
+
+            // Non-movable
+            interrupt_guard(interrupt_guard&&)            = delete;
+            interrupt_guard& operator=(interrupt_guard&&) = delete;
+
+          private:
+            array<int, 3> signals_{SIGINT, SIGTERM, SIGHUP};
+            array<struct sigaction, 3> previous_{};
+            bool enabled_;
+        };
+
+        // Poll the running children until one of them exits (returns its slot), times out jobs
+        // that have been running too long (sets `stop` at the deadline).
+        template <typename TimedOut>
+        usize wait_polling(vec<child>& slots, const vec<usize>& slot_job,
+                           const vec<u64>& slot_start, vec<bool>& slot_timed_out,
+                           const vec<job>& jobs, const u64 deadline_ns, bool& stop,
+                           TimedOut& timed_out)
+        {
+            constexpr u64 max_sleep_ns = 20'000'000;
+            u64 sleep_ns               = 500'000;
+
+            while (true)
+            {
+                bool any_running = false;
+                for (usize slot = 0; slot < slots.count(); ++slot)
+                {
+                    if (slot_job.at(slot, promise::within_bounds) == constant::npos)
+                    {
+                        continue;
+                    }
+
+                    child& c = slots.at(slot, promise::within_bounds);
+                    if (c.try_wait())
+                    {
+                        return slot;
+                    }
+                    any_running = true;
+                }
+
+                if (!any_running)
+                {
+                    return constant::npos;
+                }
+
+                if (interrupt_signal != 0)
+                {
+                    // Kill all children (they are waited for as usual) before snn is terminated.
+                    stop = true;
+                    for (usize slot = 0; slot < slots.count(); ++slot)
+                    {
+                        if (slot_job.at(slot, promise::within_bounds) != constant::npos)
+                        {
+                            slots.at(slot, promise::within_bounds).kill_process_group();
+                        }
+                    }
+                }
+
+                const u64 now = clock::monotonic();
+                if (deadline_ns > 0 && now >= deadline_ns)
+                {
+                    stop = true;
+                }
+
+                for (usize slot = 0; slot < slots.count(); ++slot)
+                {
+                    const usize index = slot_job.at(slot, promise::within_bounds);
+                    if (index == constant::npos || slot_timed_out.at(slot, promise::within_bounds))
+                    {
+                        continue;
+                    }
+
+                    const u64 timeout = jobs.at(index, promise::within_bounds).timeout_ns;
+                    const u64 start   = slot_start.at(slot, promise::within_bounds);
+                    if ((timeout > 0 && now - start >= timeout) ||
+                        (deadline_ns > 0 && now >= deadline_ns))
+                    {
+                        child& c = slots.at(slot, promise::within_bounds);
+                        slot_timed_out.at(slot, promise::within_bounds) = true;
+                        timed_out(index, c.pid(), now - start);
+                        c.kill_process_group();
+                    }
+                }
+
+                timespec ts{};
+                ts.tv_nsec = static_cast<long>(sleep_ns);
+                ::nanosleep(&ts, nullptr);
+                sleep_ns = math::min(sleep_ns * 2, max_sleep_ns);
+            }
+        }
+    }
+
+    // Run jobs (started in order) with at most `concurrency` running at the same time. The
+    // `done(index, result)` callback is called as each job finishes (in completion order), no more
+    // jobs are started if it returns false (the running jobs are waited for). Returns the results
+    // in job order, jobs that were never started have `error_number` set to `ECANCELED`.
+    //
+    // A job that runs longer than its `timeout_ns`, or is still running at `deadline_ns` (a
+    // `clock::monotonic()` time, zero for none), is timed out: `timed_out(index, pid, elapsed_ns)`
+    // is called (e.g. to get a stack dump) and then its process group is killed. No more jobs are
+    // started after the deadline. If a job has a timeout (or there is a deadline) all jobs are
+    // spawned in process groups of their own and are polled instead of waited for. SIGINT,
+    // SIGTERM and SIGHUP then kill all running jobs before they terminate snn.
+    //
+    // A job with a `cgroup` moves itself into it before it is executed, its memory peak and CPU
+    // time are then read from the cgroup (all its processes, not only the waited for ones).
+    //
+    // With scheduling hints (`threads`, `memory` or `serial`) the jobs are packed onto the CPUs
+    // (`concurrency`) and the physical memory (see `capacity`): the first job (in order) that fits
+    // is started next, unless the first job that hasn't started needs the whole machine.
+    template <typename Done, typename TimedOut>
+    vec<result> run(const vec<job>& jobs, const usize concurrency, const u64 deadline_ns,
+                    Done done, TimedOut timed_out)
+    {
+        vec<result> results{container::reserve, jobs.count()};
+        for (usize i = 0; i < jobs.count(); ++i)
+        {
+            results.append(result{});
+        }
+
+        const usize slot_count = math::max(usize{1}, math::min(concurrency, jobs.count()));
+
+        vec<child> slots{container::reserve, slot_count};
+        vec<usize> slot_job{container::reserve, slot_count};
+        vec<u64> slot_start{container::reserve, slot_count};
+        vec<bool> slot_timed_out{container::reserve, slot_count};
+        for (usize i = 0; i < slot_count; ++i)
+        {
+            slots.append(child{});
+            slot_job.append(constant::npos);
+            slot_start.append(0);
+            slot_timed_out.append(false);
+        }
+
+        bool poll        = deadline_ns > 0;
+        bool uses_memory = false;
+        for (const auto& j : jobs)
+        {
+            poll        = poll || j.timeout_ns > 0;
+            uses_memory = uses_memory || j.memory > 0;
+        }
+
+        const detail::interrupt_guard interrupts{poll};
+
+        capacity cap{concurrency, uses_memory ? physical_memory() : 0};
+
+        vec<bool> started{container::reserve, jobs.count()};
+        for (usize i = 0; i < jobs.count(); ++i)
+        {
+            started.append(false);
+        }
+
+        usize first_pending = 0; // All jobs before it have been started.
+        usize start_count   = 0;
+        usize active        = 0;
+        bool stop           = false;
+
+        // The first job (in order) that fits, `constant::npos` if none. If the first pending job
+        // needs the whole machine (e.g. `serial`), nothing else is started until the running jobs
+        // have finished and it has started (otherwise the jobs after it would keep starting
+        // around it and push it to the end).
+        const auto next_job = [&] {
+            while (first_pending < jobs.count() &&
+                   started.at(first_pending, promise::within_bounds))
+            {
+                ++first_pending;
+            }
+
+            if (first_pending < jobs.count())
+            {
+                const job& first = jobs.at(first_pending, promise::within_bounds);
+                if (cap.needs_all(first))
+                {
+                    return cap.fits(first) ? first_pending : constant::npos;
+                }
+            }
+
+            for (usize i = first_pending; i < jobs.count(); ++i)
+            {
+                if (!started.at(i, promise::within_bounds) &&
+                    cap.fits(jobs.at(i, promise::within_bounds)))
+                {
+                    return i;
+                }
+            }
+            return constant::npos;
+        };
+
+        const auto finish = [&](const usize slot) {
+            const usize index = slot_job.at(slot, promise::within_bounds);
+            const child& c    = slots.at(slot, promise::within_bounds);
+
+            result& r         = results.at(index, promise::within_bounds);
+            r.exit_status     = c.exit_status();
+            r.exited_normally = c.exited_normally();
+            r.timed_out       = slot_timed_out.at(slot, promise::within_bounds);
+            r.error_number    = c.error_number();
+            r.usage           = resources::from_rusage(
+                c.usage(), clock::monotonic() - slot_start.at(slot, promise::within_bounds));
+
+            const job& j = jobs.at(index, promise::within_bounds);
+            if (j.cgroup)
+            {
+                cgroup::read_usage(j.cgroup, r.usage);
+                r.out_of_memory = cgroup::oom_kills(j.cgroup) > 0;
+            }
+
+            slot_job.at(slot, promise::within_bounds)       = constant::npos;
+            slot_timed_out.at(slot, promise::within_bounds) = false;
+            cap.finish(j);
+            --active;
+
+            if (r.timed_out)
+            {
+                r.exit_status     = constant::exit::failure;
+                r.exited_normally = false;
+            }
+
+            if (!done(index, static_cast<const result&>(r)))
+            {
+                stop = true;
+            }
+        };
+
+        while ((start_count < jobs.count() && !stop) || active > 0)
+        {
+            if (deadline_ns > 0 && clock::monotonic() >= deadline_ns)
+            {
+                stop = true;
+            }
+
+            // Fill free slots.
+            for (usize slot = 0; slot < slot_count && !stop; ++slot)
+            {
+                while (slot_job.at(slot, promise::within_bounds) == constant::npos && !stop)
+                {
+                    const usize index = next_job();
+                    if (index == constant::npos)
+                    {
+                        break;
+                    }
+                    started.at(index, promise::within_bounds) = true;
+                    ++start_count;
+
+                    const job& j = jobs.at(index, promise::within_bounds);
+
+                    child& c = slots.at(slot, promise::within_bounds);
+
+                    slot_start.at(slot, promise::within_bounds) = clock::monotonic();
+
+                    bool spawned = false;
+                    if (j.cgroup)
+                    {
+                        spawned = c.spawn(str{cgroup::wrapper_path},
+                                          cgroup::wrapper_arguments(j.cgroup, j.path, j.arguments),
+                                          j.environment, poll);
+                    }
+                    else
+                    {
+                        spawned = c.spawn(j.path, j.arguments, j.environment, poll);
+                    }
+
+                    if (spawned)
+                    {
+                        slot_job.at(slot, promise::within_bounds) = index;
+                        cap.start(j);
+                        ++active;
+                    }
+                    else
+                    {
+                        result& r      = results.at(index, promise::within_bounds);
+                        r.error_number = c.error_number();
+                        if (!done(index, static_cast<const result&>(r)))
+                        {
+                            stop = true;
+                        }
+                    }
+                }
+            }
+
+            if (active == 0)
+            {
+                continue;
+            }
+
+            const usize slot = poll ? detail::wait_polling(slots, slot_job, slot_start,
+                                                           slot_timed_out, jobs, deadline_ns, stop,
+                                                           timed_out)
+                                    : child::wait_any(slots);
+            if (slot != constant::npos)
+            {
+                finish(slot);
+            }
+            else
+            {
+                // Children were lost (should not happen), report them as failed.
+                for (usize s = 0; s < slot_count; ++s)
+                {
+                    if (slot_job.at(s, promise::within_bounds) != constant::npos)
+                    {
+                        finish(s);
+                    }
+                }
+            }
+        }
+
+        for (usize i = 0; i < jobs.count(); ++i)
+        {
+            if (!started.at(i, promise::within_bounds))
+            {
+                results.at(i, promise::within_bounds).error_number = ECANCELED;
+            }
+        }
+
+        return results;
+    }
+
+    template <typename Done>
+    vec<result> run(const vec<job>& jobs, const usize concurrency, Done done)
+    {
+        return run(jobs, concurrency, 0, std::move(done),
+                   [](const usize, const pid_t, const u64) {});
+    }
+}
@@ -0,0 +1,358 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/chr/common.hh"
+#include "build-tool/number.hh"
+
+namespace snn::app::json
+{
+    // Append a quoted and escaped JSON string, control characters are escaped as "\uXXXX".
+    inline void append_string(const cstrview s, strbuf& out)
+    {
+        out << '"';
+        for (const char c : s)
+        {
+            switch (c)
+            {
+                case '"':
+                    out << "\\\"";
+                    break;
+                case '\\':
+                    out << "\\\\";
+                    break;
+                case '\n':
+                    out << "\\n";
+                    break;
+                case '\t':
+                    out << "\\t";
+                    break;
+                default:
+                    if (static_cast<u8>(c) < 0x20)
+                    {
+                        out << "\\u00";
+                        out.append_integral<math::base::hex>(static_cast<u8>(c), 2);
+                    }
+                    else
+                    {
+                        out << c;
+                    }
+            }
+        }
+        out << '"';
+    }
+
+    // Minimal forward-only JSON reader for tool output (e.g. `llvm-cov export`), no tree is
+    // built. Object members and array elements are visited with callbacks, values that a callback
+    // doesn't read are skipped. "\uXXXX" escapes are decoded as UTF-8 (surrogate pairs are not
+    // combined).
+    class reader final
+    {
+      public:
+        explicit reader(const cstrview json) noexcept
+            : json_{json}
+        {
+        }
+
+        [[nodiscard]] bool is_valid() const noexcept
+        {
+            return valid_;
+        }
+
+        // Calls `fn(key, reader&)` for each member.
+        template <typename Fn>
+        bool object(Fn fn)
+        {
+            skip_space_();
+            if (!consume_('{'))
+            {
+                return fail_();
+            }
+
+            skip_space_();
+            if (consume_('}'))
+            {
+                return true;
+            }
+
+            str key;
+            while (valid_)
+            {
+                if (!string_(key))
+                {
+                    return fail_();
+                }
+
+                skip_space_();
+                if (!consume_(':'))
+                {
+                    return fail_();
+                }
+
+                value_(fn, key.view());
+
+                skip_space_();
+                if (consume_('}'))
+                {
+                    return valid_;
+                }
+                if (!consume_(','))
+                {
+                    return fail_();
+                }
+                skip_space_();
+            }
+
+            return false;
+        }
+
+        // Calls `fn(reader&)` for each element.
+        template <typename Fn>
+        bool array(Fn fn)
+        {
+            skip_space_();
+            if (!consume_('['))
+            {
+                return fail_();
+            }
+
+            skip_space_();
+            if (consume_(']'))
+            {
+                return true;
+            }
+
+            while (valid_)
+            {
+                value_(fn);
+
+                skip_space_();
+                if (consume_(']'))
+                {
+                    return valid_;
+                }
+                if (!consume_(','))
+                {
+                    return fail_();
+                }
+            }
+
+            return false;
+        }
+
+        // Non-negative integer, a fraction is dropped (e.g. 12.7 -> 12).
+        [[nodiscard]] optional<u64> integer()
+        {
+            skip_space_();
+            const usize start = pos_;
+            while (pos_ < json_.size() && chr::is_digit(peek_()))
+            {
+                ++pos_;
+            }
+            const auto n = number::parse(json_.view(start, pos_ - start));
+            skip_number_();
+            if (!n)
+            {
+                fail_();
+            }
+            return n;
+        }
+
+        [[nodiscard]] optional<str> string()
+        {
+            skip_space_();
+            str s;
+            if (string_(s))
+            {
+                return s;
+            }
+            fail_();
+            return nullopt;
+        }
+
+        bool skip()
+        {
+            skip_space_();
+            switch (peek_())
+            {
+                case '{':
+                    return object([](const cstrview, reader&) {});
+                case '[':
+                    return array([](reader&) {});
+                case '"':
+                {
+                    str ignored;
+                    return string_(ignored) || fail_();
+                }
+                case 't':
+                    return literal_("true");
+                case 'f':
+                    return literal_("false");
+                case 'n':
+                    return literal_("null");
+                default:
+                    if (peek_() == '-' || chr::is_digit(peek_()))
+                    {
+                        skip_number_();
+                        return true;
+                    }
+                    return fail_();
+            }
+        }
+
+      private:
+        cstrview json_;
+        usize pos_  = 0;
+        bool valid_ = true;
+
+        bool fail_() noexcept
+        {
+            valid_ = false;
+            pos_   = json_.size();
+            return false;
+        }
+
+        char peek_() const noexcept
+        {
+            return pos_ < json_.size() ? json_.at(pos_, promise::within_bounds) : '\0';
+        }
+
+        bool consume_(const char c) noexcept
+        {
+            if (peek_() == c && pos_ < json_.size())
+            {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        void skip_space_() noexcept
+        {
+            while (pos_ < json_.size() && chr::is_ascii_control_or_space(peek_()))
+            {
+                ++pos_;
+            }
+        }
+
+        void skip_number_() noexcept
+        {
+            while (pos_ < json_.size() && (chr::is_digit(peek_()) || peek_() == '-' ||
+                                           peek_() == '+' || peek_() == '.' || peek_() == 'e' ||
+                                           peek_() == 'E'))
+            {
+                ++pos_;
+            }
+        }
+
+        bool literal_(const cstrview word) noexcept
+        {
+            if (json_.view(pos_).has_front(word))
+            {
+                pos_ += word.size();
+                return true;
+            }
+            return fail_();
+        }
+
+        // Calls `fn(args..., *this)` and skips the value if `fn` didn't read it.
+        template <typename Fn, typename... Args>
+        void value_(Fn& fn, const Args... args)
+        {
+            skip_space_();
+            const usize start = pos_;
+            fn(args..., *this);
+            if (valid_ && pos_ == start)
+            {
+                skip();
+            }
+        }
+
+        bool string_(str& out)
+        {
+            out.clear();
+            if (!consume_('"'))
+            {
+                return false;
+            }
+
+            while (pos_ < json_.size())
+            {
+                const char c = json_.at(pos_++, promise::within_bounds);
+                if (c == '"')
+                {
+                    return true;
+                }
+
+                if (c != '\\')
+                {
+                    out << c;
+                    continue;
+                }
+
+                const char e = peek_();
+                ++pos_;
+                switch (e)
+                {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        out << e;
+                        break;
+                    case 'b':
+                        out << '\b';
+                        break;
+                    case 'f':
+                        out << '\f';
+                        break;
+                    case 'n':
+                        out << '\n';
+                        break;
+                    case 'r':
+                        out << '\r';
+                        break;
+                    case 't':
+                        out << '\t';
+                        break;
+                    case 'u':
+                    {
+                        const auto cp = number::parse_hex(json_.view(pos_, 4));
+                        if (!cp || json_.view(pos_, 4).size() != 4 ||
+                            json_.view(pos_).has_front("0x"))
+                        {
+                            return false;
+                        }
+                        pos_ += 4;
+                        append_utf8_(out, cp.value(promise::has_value));
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+            }
+
+            return false; // Unterminated.
+        }
+
+        static void append_utf8_(str& out, const u64 cp)
+        {
+            if (cp < 0x80)
+            {
+                out << static_cast<char>(cp);
+            }
+            else if (cp < 0x800)
+            {
+                out << static_cast<char>(0xc0 | (cp >> 6));
+                out << static_cast<char>(0x80 | (cp & 0x3f));
+            }
+            else
+            {
+                out << static_cast<char>(0xe0 | (cp >> 12));
+                out << static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                out << static_cast<char>(0x80 | (cp & 0x3f));
+            }
+        }
+    };
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/json.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            app::json::reader r{R"({"name": "a\"b\\c\u00e5", "skipped": {"x": [1, 2.5, -3e2, true,
+                                    false, null, {}], "y": "}"}, "values": [10, 20, 30.9]})"};
+
+            str name;
+            u64 sum      = 0;
+            usize values = 0;
+            snn_require(r.object([&](const cstrview key, app::json::reader& v) {
+                if (key == "name")
+                {
+                    name = v.string().value_or_default();
+                }
+                else if (key == "values")
+                {
+                    v.array([&](app::json::reader& e) {
+                        sum += e.integer().value_or(0);
+                        ++values;
+                    });
+                }
+            }));
+            snn_require(r.is_valid());
+            snn_require(name == "a\"b\\c\xc3\xa5");
+            snn_require(values == 3);
+            snn_require(sum == 60);
+        }
+        {
+            app::json::reader r{"[]"};
+            snn_require(r.array([](app::json::reader&) {}));
+        }
+        {
+            app::json::reader r{R"({"a": 1,})"};
+            snn_require(!r.skip());
+            snn_require(!r.is_valid());
+        }
+        {
+            app::json::reader r{R"({"a": -1})"};
+            snn_require(!r.object([](const cstrview, app::json::reader& v) {
+                static_cast<void>(v.integer());
+            }));
+            snn_require(!r.is_valid());
+        }
+        {
+            app::json::reader r{R"(["unterminated)"};
+            snn_require(!r.skip());
+        }
+        {
+            app::json::reader r{R"({"a": tru})"};
+            snn_require(!r.skip());
+        }
+        {
+            strbuf out;
+            app::json::append_string("a\"b\\c\n\t\x01/", out);
+            snn_require(out == R"("a\"b\\c\n\t\u0001/")");
+
+            app::json::reader r{out};
+            snn_require(r.string().value_or_default() == "a\"b\\c\n\t\x01/");
+            snn_require(r.is_valid());
+        }
+    }
+}
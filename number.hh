@@ -0,0 +1,103 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/chr/common.hh"
+
+namespace snn::app::number
+{
+    // Strict parsing, the whole string must be a number (no sign, no whitespace) that fits.
+
+    [[nodiscard]] constexpr optional<u64> parse(const transient<cstrview> s) noexcept
+    {
+        const cstrview v = s.get();
+        if (v.is_empty() || v.size() > 19) // 19 digits always fit in an u64.
+        {
+            return nullopt;
+        }
+
+        u64 n = 0;
+        for (const char c : v)
+        {
+            if (!chr::is_digit(c))
+            {
+                return nullopt;
+            }
+            n = n * 10 + static_cast<u64>(c - '0');
+        }
+        return n;
+    }
+
+    [[nodiscard]] constexpr optional<u64> parse_hex(const transient<cstrview> s) noexcept
+    {
+        cstrview v = s.get();
+        if (v.has_front("0x"))
+        {
+            v.drop_front_n(2);
+        }
+
+        if (v.is_empty() || v.size() > 16)
+        {
+            return nullopt;
+        }
+
+        u64 n = 0;
+        for (const char c : v)
+        {
+            u64 digit = 0;
+            if (chr::is_digit(c))
+            {
+                digit = static_cast<u64>(c - '0');
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                digit = static_cast<u64>(c - 'a' + 10);
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                digit = static_cast<u64>(c - 'A' + 10);
+            }
+            else
+            {
+                return nullopt;
+            }
+            n = n * 16 + digit;
+        }
+        return n;
+    }
+
+    // Size with an optional binary suffix, e.g. "512M" or "2G".
+    [[nodiscard]] constexpr optional<u64> parse_size(cstrview s) noexcept
+    {
+        u64 multiplier = 1;
+        if (s.has_back('K'))
+        {
+            multiplier = u64{1} << 10;
+        }
+        else if (s.has_back('M'))
+        {
+            multiplier = u64{1} << 20;
+        }
+        else if (s.has_back('G'))
+        {
+            multiplier = u64{1} << 30;
+        }
+        else if (s.has_back('T'))
+        {
+            multiplier = u64{1} << 40;
+        }
+
+        if (multiplier > 1)
+        {
+            s.drop_back_n(1);
+        }
+
+        const auto n = parse(s);
+        if (!n || n.value() == 0 || n.value() > constant::limit<u64>::max / multiplier)
+        {
+            return nullopt;
+        }
+        return n.value() * multiplier;
+    }
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/number.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        static_assert(app::number::parse("0").value() == 0);
+        static_assert(app::number::parse("7").value() == 7);
+        static_assert(app::number::parse("123").value() == 123);
+        static_assert(app::number::parse("0123").value() == 123);
+        static_assert(app::number::parse("9999999999999999999").value() == 9999999999999999999u);
+
+        static_assert(!app::number::parse(""));
+        static_assert(!app::number::parse(" 1"));
+        static_assert(!app::number::parse("1 "));
+        static_assert(!app::number::parse("-1"));
+        static_assert(!app::number::parse("+1"));
+        static_assert(!app::number::parse("1.5"));
+        static_assert(!app::number::parse("12a"));
+        static_assert(!app::number::parse("12345678901234567890"));
+
+        static_assert(app::number::parse_hex("0").value() == 0);
+        static_assert(app::number::parse_hex("ff").value() == 255);
+        static_assert(app::number::parse_hex("FF").value() == 255);
+        static_assert(app::number::parse_hex("0x1a2B").value() == 0x1a2b);
+        static_assert(app::number::parse_hex("ffffffffffffffff").value() == 0xffffffffffffffff);
+
+        static_assert(!app::number::parse_hex(""));
+        static_assert(!app::number::parse_hex("0x"));
+        static_assert(!app::number::parse_hex("g"));
+        static_assert(!app::number::parse_hex("0x-1"));
+        static_assert(!app::number::parse_hex("1ffffffffffffffff"));
+
+        static_assert(app::number::parse_size("4096").value() == 4096);
+        static_assert(app::number::parse_size("512K").value() == 512 * 1024);
+        static_assert(app::number::parse_size("512M").value() == 512 * 1024 * 1024);
+        static_assert(app::number::parse_size("2G").value() == u64{2} << 30);
+        static_assert(app::number::parse_size("1T").value() == u64{1} << 40);
+
+        static_assert(!app::number::parse_size(""));
+        static_assert(!app::number::parse_size("G"));
+        static_assert(!app::number::parse_size("0"));
+        static_assert(!app::number::parse_size("2g"));
+        static_assert(!app::number::parse_size("2GB"));
+        static_assert(!app::number::parse_size("99999999999T"));
+    }
+}
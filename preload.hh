@@ -0,0 +1,783 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/chr/common.hh"
+#include "snn-core/file/remove.hh"
+#include "snn-core/file/write.hh"
+#include "snn-core/file/standard/error.hh"
+#include "snn-core/process/execute.hh"
+
+namespace snn::app::preload
+{
+    // Libraries that are preloaded (`LD_PRELOAD`) into applications. The source is embedded so
+    // that the `snn` binary can be copied anywhere. It is compiled on demand with the same
+    // compiler as the applications, without the compiler config (e.g. `-Werror`) and without
+    // linking the C++ standard library.
+
+    // Heap interposer, counts allocation calls and bytes, tracks peak live bytes and records
+    // allocation sites (frame pointer call stacks, every Nth allocation if sampled).
+    //
+    // Environment:
+    // SNN_HEAP_REPORT  Report file (required, nothing is reported if not set).
+    // SNN_HEAP_SAMPLE  Record the call stack of every Nth allocation (default: 1).
+    //
+    // Report format (tab separated):
+    // calls <malloc> <calloc> <realloc> <memalign> <new> <free> <delete>
+    // bytes <allocated> <peak-live>
+    // dropped <sites-not-recorded>
+    // site <count> <bytes> <offset-hex> <module> [<offset-hex> <module> ...]
+    constexpr cstrview heap_source = R"src(
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__FreeBSD__)
+#include <malloc_np.h>
+#else
+#include <malloc.h>
+#endif
+
+namespace
+{
+    using malloc_fn         = void* (*)(size_t);
+    using calloc_fn         = void* (*)(size_t, size_t);
+    using realloc_fn        = void* (*)(void*, size_t);
+    using free_fn           = void (*)(void*);
+    using posix_memalign_fn = int (*)(void**, size_t, size_t);
+
+    malloc_fn real_malloc                 = nullptr;
+    calloc_fn real_calloc                 = nullptr;
+    realloc_fn real_realloc               = nullptr;
+    free_fn real_free                     = nullptr;
+    posix_memalign_fn real_posix_memalign = nullptr;
+
+    // Used while resolving the real functions (dlsym can allocate).
+    alignas(16) char bootstrap[16384];
+    size_t bootstrap_used = 0;
+    bool resolving        = false;
+
+    enum kind : int
+    {
+        k_malloc,
+        k_calloc,
+        k_realloc,
+        k_memalign,
+        k_new,
+        k_free,
+        k_delete,
+        kind_count,
+    };
+
+    uint64_t calls[kind_count];
+    uint64_t allocated_bytes = 0;
+    int64_t live_bytes       = 0;
+    int64_t peak_live_bytes  = 0;
+    uint64_t sample_period   = 1;
+    uint64_t sample_counter  = 0;
+    uint64_t dropped         = 0;
+    bool reporting           = false;
+    char report_path[4096];
+
+    constexpr int max_frames    = 6;
+    constexpr size_t site_count = 4096; // Power of two.
+
+    struct site
+    {
+        uint64_t hash;
+        uint64_t count;
+        uint64_t bytes;
+        uintptr_t frames[max_frames];
+        int frame_count;
+    };
+
+    site sites[site_count];
+
+    bool is_bootstrap(const void* p)
+    {
+        const char* c = static_cast<const char*>(p);
+        return c >= bootstrap && c < bootstrap + sizeof(bootstrap);
+    }
+
+    void* bootstrap_alloc(size_t size)
+    {
+        size = (size + 15) & ~size_t{15};
+        if (bootstrap_used + size > sizeof(bootstrap))
+        {
+            return nullptr;
+        }
+        void* p = bootstrap + bootstrap_used;
+        bootstrap_used += size;
+        return p;
+    }
+
+    void resolve()
+    {
+        if (real_malloc != nullptr)
+        {
+            return;
+        }
+
+        resolving           = true;
+        real_calloc         = reinterpret_cast<calloc_fn>(dlsym(RTLD_NEXT, "calloc"));
+        real_realloc        = reinterpret_cast<realloc_fn>(dlsym(RTLD_NEXT, "realloc"));
+        real_free           = reinterpret_cast<free_fn>(dlsym(RTLD_NEXT, "free"));
+        real_posix_memalign = reinterpret_cast<posix_memalign_fn>(
+            dlsym(RTLD_NEXT, "posix_memalign"));
+        real_malloc         = reinterpret_cast<malloc_fn>(dlsym(RTLD_NEXT, "malloc"));
+        resolving           = false;
+
+        if (real_malloc == nullptr || real_calloc == nullptr || real_realloc == nullptr ||
+            real_free == nullptr || real_posix_memalign == nullptr)
+        {
+            abort();
+        }
+    }
+
+    __attribute__((noinline)) int backtrace(uintptr_t* out)
+    {
+        // Skip this function and `record` (the caller of the interposed function is next).
+        constexpr int skip = 2;
+
+        const uintptr_t* fp = static_cast<const uintptr_t*>(__builtin_frame_address(0));
+        int n               = 0;
+        int i               = 0;
+        while (fp != nullptr && n < max_frames)
+        {
+            const uintptr_t ret = fp[1];
+            if (ret == 0)
+            {
+                break;
+            }
+
+            if (i >= skip)
+            {
+                out[n++] = ret - 1; // Inside the call instruction.
+            }
+            ++i;
+
+            const uintptr_t* next = reinterpret_cast<const uintptr_t*>(fp[0]);
+            const uintptr_t distance =
+                reinterpret_cast<uintptr_t>(next) - reinterpret_cast<uintptr_t>(fp);
+            if (next <= fp || distance > (1 << 20) || (reinterpret_cast<uintptr_t>(next) & 7))
+            {
+                break;
+            }
+            fp = next;
+        }
+        return n;
+    }
+
+    __attribute__((noinline)) void record(const size_t size)
+    {
+        uint64_t weight = 1;
+        if (sample_period > 1)
+        {
+            if (__atomic_fetch_add(&sample_counter, 1, __ATOMIC_RELAXED) % sample_period != 0)
+            {
+                return;
+            }
+            weight = sample_period;
+        }
+
+        uintptr_t frames[max_frames];
+        const int frame_count = backtrace(frames);
+
+        uint64_t hash = 14695981039346656037u; // FNV-1a
+        for (int i = 0; i < frame_count; ++i)
+        {
+            hash = (hash ^ frames[i]) * 1099511628211u;
+        }
+        if (hash == 0)
+        {
+            hash = 1;
+        }
+
+        for (size_t probe = 0; probe < site_count; ++probe)
+        {
+            site& s = sites[(hash + probe) & (site_count - 1)];
+
+            uint64_t current = __atomic_load_n(&s.hash, __ATOMIC_ACQUIRE);
+            if (current == 0)
+            {
+                uint64_t expected = 0;
+                if (__atomic_compare_exchange_n(&s.hash, &expected, hash, false,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                    memcpy(s.frames, frames, sizeof(frames));
+                    s.frame_count = frame_count;
+                    current       = hash;
+                }
+                else
+                {
+                    current = expected;
+                }
+            }
+
+            if (current == hash)
+            {
+                __atomic_fetch_add(&s.count, weight, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&s.bytes, size * weight, __ATOMIC_RELAXED);
+                return;
+            }
+        }
+
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+    }
+
+    void add_live(const int64_t n)
+    {
+        const int64_t live = __atomic_add_fetch(&live_bytes, n, __ATOMIC_RELAXED);
+        int64_t peak       = __atomic_load_n(&peak_live_bytes, __ATOMIC_RELAXED);
+        while (live > peak && !__atomic_compare_exchange_n(&peak_live_bytes, &peak, live, true,
+                                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+        }
+    }
+
+    __attribute__((always_inline)) inline void account(void* p, const size_t size, const kind k)
+    {
+        if (p != nullptr && !reporting)
+        {
+            __atomic_fetch_add(&calls[k], 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&allocated_bytes, size, __ATOMIC_RELAXED);
+            add_live(static_cast<int64_t>(malloc_usable_size(p)));
+            record(size);
+        }
+    }
+
+    __attribute__((always_inline)) inline void* allocate(const size_t size, const kind k)
+    {
+        if (real_malloc == nullptr)
+        {
+            if (resolving)
+            {
+                return bootstrap_alloc(size);
+            }
+            resolve();
+        }
+
+        void* p = real_malloc(size);
+        account(p, size, k);
+        return p;
+    }
+
+    __attribute__((always_inline)) inline void* allocate_aligned(const size_t alignment,
+                                                                 const size_t size,
+                                                                 const kind k)
+    {
+        resolve();
+
+        void* p = nullptr;
+        if (real_posix_memalign(&p, alignment, size) != 0)
+        {
+            return nullptr;
+        }
+        account(p, size, k);
+        return p;
+    }
+
+    __attribute__((always_inline)) inline void deallocate(void* p, const kind k)
+    {
+        if (p == nullptr || is_bootstrap(p))
+        {
+            return;
+        }
+
+        resolve();
+
+        if (!reporting)
+        {
+            __atomic_fetch_add(&calls[k], 1, __ATOMIC_RELAXED);
+            add_live(-static_cast<int64_t>(malloc_usable_size(p)));
+        }
+        real_free(p);
+    }
+
+    void write_all(const int fd, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t n = write(fd, data, size);
+            if (n <= 0)
+            {
+                return;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    __attribute__((constructor)) void start()
+    {
+        const char* path = getenv("SNN_HEAP_REPORT");
+        if (path != nullptr && strlen(path) < sizeof(report_path))
+        {
+            strcpy(report_path, path);
+        }
+
+        // Child processes should not overwrite the report.
+        unsetenv("SNN_HEAP_REPORT");
+
+        const char* period = getenv("SNN_HEAP_SAMPLE");
+        if (period != nullptr)
+        {
+            const unsigned long long n = strtoull(period, nullptr, 10);
+            sample_period              = n > 0 ? n : 1;
+        }
+    }
+
+    __attribute__((destructor)) void stop()
+    {
+        if (report_path[0] == '\0')
+        {
+            return;
+        }
+
+        reporting = true;
+
+        const int fd = open(report_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        char line[8192];
+        int n = snprintf(line, sizeof(line),
+                         "calls\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\n"
+                         "bytes\t%llu\t%lld\n"
+                         "dropped\t%llu\n",
+                         static_cast<unsigned long long>(calls[k_malloc]),
+                         static_cast<unsigned long long>(calls[k_calloc]),
+                         static_cast<unsigned long long>(calls[k_realloc]),
+                         static_cast<unsigned long long>(calls[k_memalign]),
+                         static_cast<unsigned long long>(calls[k_new]),
+                         static_cast<unsigned long long>(calls[k_free]),
+                         static_cast<unsigned long long>(calls[k_delete]),
+                         static_cast<unsigned long long>(allocated_bytes),
+                         static_cast<long long>(peak_live_bytes),
+                         static_cast<unsigned long long>(dropped));
+        write_all(fd, line, static_cast<size_t>(n));
+
+        for (const site& s : sites)
+        {
+            if (s.hash == 0)
+            {
+                continue;
+            }
+
+            n = snprintf(line, sizeof(line), "site\t%llu\t%llu",
+                         static_cast<unsigned long long>(s.count),
+                         static_cast<unsigned long long>(s.bytes));
+
+            for (int i = 0; i < s.frame_count; ++i)
+            {
+                const uintptr_t ip = s.frames[i];
+
+                Dl_info info;
+                if (dladdr(reinterpret_cast<void*>(ip), &info) != 0 &&
+                    info.dli_fname != nullptr && info.dli_fname[0] != '\0')
+                {
+                    const uintptr_t base = reinterpret_cast<uintptr_t>(info.dli_fbase);
+                    n += snprintf(line + n, sizeof(line) - static_cast<size_t>(n), "\t%lx\t%s",
+                                  static_cast<unsigned long>(ip - base), info.dli_fname);
+                }
+                else
+                {
+                    n += snprintf(line + n, sizeof(line) - static_cast<size_t>(n), "\t%lx\t?",
+                                  static_cast<unsigned long>(ip));
+                }
+
+                if (n >= static_cast<int>(sizeof(line)) - 1)
+                {
+                    n = static_cast<int>(sizeof(line)) - 2;
+                    break;
+                }
+            }
+
+            line[n++] = '\n';
+            write_all(fd, line, static_cast<size_t>(n));
+        }
+
+        close(fd);
+    }
+}
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        return allocate(size, k_malloc);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        if (real_calloc == nullptr)
+        {
+            if (resolving)
+            {
+                return bootstrap_alloc(count * size); // Zeroed (static storage).
+            }
+            resolve();
+        }
+
+        void* p = real_calloc(count, size);
+        account(p, count * size, k_calloc);
+        return p;
+    }
+
+    void* realloc(void* p, size_t size)
+    {
+        if (p == nullptr)
+        {
+            return allocate(size, k_realloc);
+        }
+
+        if (is_bootstrap(p))
+        {
+            void* q = allocate(size, k_realloc);
+            if (q != nullptr)
+            {
+                const size_t available =
+                    sizeof(bootstrap) - static_cast<size_t>(static_cast<char*>(p) - bootstrap);
+                memcpy(q, p, size < available ? size : available);
+            }
+            return q;
+        }
+
+        resolve();
+
+        const size_t old_size = malloc_usable_size(p);
+        void* q               = real_realloc(p, size);
+        if (q == nullptr && size == 0 && !reporting)
+        {
+            // Freed (glibc).
+            __atomic_fetch_add(&calls[k_free], 1, __ATOMIC_RELAXED);
+            add_live(-static_cast<int64_t>(old_size));
+        }
+        else if (q != nullptr && !reporting)
+        {
+            __atomic_fetch_add(&calls[k_realloc], 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&allocated_bytes, size, __ATOMIC_RELAXED);
+            add_live(static_cast<int64_t>(malloc_usable_size(q)) -
+                     static_cast<int64_t>(old_size));
+            record(size);
+        }
+        return q;
+    }
+
+    void free(void* p)
+    {
+        deallocate(p, k_free);
+    }
+
+    int posix_memalign(void** p, size_t alignment, size_t size)
+    {
+        resolve();
+
+        const int res = real_posix_memalign(p, alignment, size);
+        if (res == 0)
+        {
+            account(*p, size, k_memalign);
+        }
+        return res;
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        return allocate_aligned(alignment, size, k_memalign);
+    }
+}
+
+// No exceptions (the C++ standard library is not linked), abort on failure. Each operator
+// calls `allocate` directly so that the call stack depth is the same for all entry points.
+
+void* operator new(size_t size)
+{
+    void* p = allocate(size, k_new);
+    if (p == nullptr)
+    {
+        abort();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    void* p = allocate(size, k_new);
+    if (p == nullptr)
+    {
+        abort();
+    }
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, k_new);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, k_new);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    void* p = allocate_aligned(static_cast<size_t>(alignment), size, k_new);
+    if (p == nullptr)
+    {
+        abort();
+    }
+    return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    void* p = allocate_aligned(static_cast<size_t>(alignment), size, k_new);
+    if (p == nullptr)
+    {
+        abort();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    deallocate(p, k_delete);
+}
+
+void operator delete[](void* p) noexcept
+{
+    deallocate(p, k_delete);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    deallocate(p, k_delete);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    deallocate(p, k_delete);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    deallocate(p, k_delete);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    deallocate(p, k_delete);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    deallocate(p, k_delete);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+    deallocate(p, k_delete);
+}
+)src";
+
+    // Startup probe, records when the probe constructor runs (after loading and relocation),
+    // when `main` is entered and when it returns (or `exit` is called) and counts the loaded
+    // objects. `main` is only wrapped with glibc (through `__libc_start_main`), elsewhere only
+    // the constructor and exit times are recorded.
+    //
+    // Environment:
+    // SNN_STARTUP_REPORT  Report file (required, nothing is reported if not set).
+    //
+    // Report format (tab separated, CLOCK_MONOTONIC nanoseconds, 0 if not recorded):
+    // constructor <ns>
+    // main <ns>
+    // exit <ns>
+    // objects <loaded-objects>
+    constexpr cstrview startup_source = R"src(
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace
+{
+    char report_path[4096];
+    unsigned long long constructor_ns = 0;
+    unsigned long long main_ns        = 0;
+    unsigned long long exit_ns        = 0;
+    unsigned long long objects        = 0;
+
+    unsigned long long now() noexcept
+    {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ull +
+               static_cast<unsigned long long>(ts.tv_nsec);
+    }
+
+    int count_object(dl_phdr_info*, size_t, void*) noexcept
+    {
+        ++objects;
+        return 0;
+    }
+
+    void enter_main() noexcept
+    {
+        main_ns = now();
+        dl_iterate_phdr(count_object, nullptr);
+    }
+
+    __attribute__((constructor(101))) void start() noexcept
+    {
+        constructor_ns = now();
+
+        const char* const path = getenv("SNN_STARTUP_REPORT");
+        if (path != nullptr && strlen(path) < sizeof(report_path))
+        {
+            strcpy(report_path, path);
+        }
+
+        // Don't propagate to child processes.
+        unsetenv("SNN_STARTUP_REPORT");
+        unsetenv("LD_DEBUG");
+        unsetenv("LD_DEBUG_OUTPUT");
+        unsetenv("LD_PRELOAD");
+    }
+
+    __attribute__((destructor(101))) void stop() noexcept
+    {
+        if (exit_ns == 0)
+        {
+            exit_ns = now();
+        }
+
+        if (report_path[0] == '\0')
+        {
+            return;
+        }
+
+        if (objects == 0)
+        {
+            dl_iterate_phdr(count_object, nullptr);
+        }
+
+        const int fd = open(report_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        char buf[256];
+        const int size = snprintf(buf, sizeof(buf),
+                                  "constructor\t%llu\nmain\t%llu\nexit\t%llu\nobjects\t%llu\n",
+                                  constructor_ns, main_ns, exit_ns, objects);
+        if (size > 0 && static_cast<size_t>(size) < sizeof(buf))
+        {
+            (void)!write(fd, buf, static_cast<size_t>(size));
+        }
+        close(fd);
+    }
+}
+
+#if defined(__GLIBC__)
+namespace
+{
+    using main_fn = int (*)(int, char**, char**);
+
+    main_fn real_main = nullptr;
+
+    int wrapped_main(int argc, char** argv, char** envp)
+    {
+        enter_main();
+        const int status = real_main(argc, argv, envp);
+        exit_ns          = now();
+        return status;
+    }
+}
+
+// Static initializers of the executable run inside `__libc_start_main` (before `main`).
+extern "C" int __libc_start_main(main_fn main, int argc, char** argv, void (*init)(),
+                                 void (*fini)(), void (*rtld_fini)(), void* stack_end)
+{
+    using start_fn = int (*)(main_fn, int, char**, void (*)(), void (*)(), void (*)(), void*);
+    const auto real_start = reinterpret_cast<start_fn>(dlsym(RTLD_NEXT, "__libc_start_main"));
+    real_main             = main;
+    return real_start(wrapped_main, argc, argv, init, fini, rtld_fini, stack_end);
+}
+#endif
+)src";
+
+    // Compile embedded source to a shared library. The source file is written next to the
+    // library (with an added ".cc" extension) and is removed after compilation.
+    [[nodiscard]] inline bool build(const cstrview compiler, const cstrview source,
+                                    const str& library, const u32 verbose_level)
+    {
+        const str source_file = concat(library, ".cc");
+        if (!file::write(source_file, source, file::option::create_or_fail))
+        {
+            fmt::print_error_line("Error: Failed to create: {}", source_file);
+            return false;
+        }
+
+        process::command cmd;
+        cmd.append_command(compiler, promise::is_valid);
+        cmd << " -std=c++20 -O2 -fPIC -shared -fno-exceptions -fno-rtti"
+               " -fno-omit-frame-pointer";
+        if (compiler.has_front("clang"))
+        {
+            cmd << " -nostdlib++";
+        }
+        cmd << " -o ";
+        cmd.append_command(library, promise::is_valid);
+        cmd << ' ';
+        cmd.append_command(source_file, promise::is_valid);
+#if defined(__linux__)
+        cmd << " -ldl";
+#endif
+        cmd << " 2>&1";
+
+        if (verbose_level >= 2)
+        {
+            fmt::print_error_line("{}", cmd.to<cstrview>());
+        }
+
+        strbuf diagnostics;
+        bool success = false;
+
+        auto output = process::execute_and_consume_output(cmd);
+        if (output)
+        {
+            while (const auto line = output.read_line<cstrview>())
+            {
+                auto rng = line.value(promise::has_value).range();
+                rng.pop_back_while(chr::is_ascii_control_or_space);
+                diagnostics << cstrview{rng} << '\n';
+            }
+            success = output.exit_status() == constant::exit::success;
+        }
+
+        file::remove(source_file).or_throw();
+
+        if (!success)
+        {
+            fmt::print_error_line("Error: Failed to build preload library: {}", library);
+            file::standard::error{} << diagnostics;
+        }
+
+        return success;
+    }
+}
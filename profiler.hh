@@ -0,0 +1,475 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/array.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/map/unsorted.hh"
+#include "snn-core/pair/common.hh"
+#include "snn-core/set/unsorted.hh"
+#include "build-tool/elf.hh"
+#include "build-tool/report.hh"
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <poll.h>        // poll
+#include <sys/mman.h>    // mmap, munmap
+#include <sys/syscall.h> // SYS_perf_event_open
+#include <unistd.h>      // close, sysconf, syscall
+#include <cerrno>
+#include <cstring> // memcpy, memset
+#endif
+
+namespace snn::app::profiler
+{
+    // Folded stacks ("root;caller;leaf count") plus self/inclusive counts per function.
+    class folded_stacks final
+    {
+      public:
+        // Frames are leaf first (as they are sampled).
+        void add(const vec<str>& frames, const usize count = 1)
+        {
+            if (frames.is_empty())
+            {
+                return;
+            }
+
+            str key;
+            for (usize i = frames.count(); i > 0; --i)
+            {
+                if (key)
+                {
+                    key << ';';
+                }
+                key << frames.at(i - 1, promise::within_bounds);
+            }
+            increment_(stacks_, key, count);
+
+            increment_(self_, frames.front(promise::not_empty), count);
+
+            set::unsorted<cstrview> seen; // Recursion must only be counted once.
+            for (const auto& frame : frames)
+            {
+                if (seen.insert(frame.view()))
+                {
+                    increment_(inclusive_, frame, count);
+                }
+            }
+
+            total_ += count;
+        }
+
+        [[nodiscard]] usize total() const noexcept
+        {
+            return total_;
+        }
+
+        // Format understood by flame graph tools (e.g. `flamegraph.pl` and speedscope).
+        [[nodiscard]] strbuf folded() const
+        {
+            strbuf out{container::reserve, stacks_.count() * 128};
+            for (const auto& p : stacks_)
+            {
+                out << p.first << ' ' << as_num(p.second) << '\n';
+            }
+            return out;
+        }
+
+        // Top `limit` functions by self samples.
+        [[nodiscard]] strbuf top(const usize limit) const
+        {
+            vec<pair::first_second<cstrview, usize>> functions{container::reserve,
+                                                               self_.count()};
+            for (const auto& p : inclusive_)
+            {
+                functions.append_inplace(p.first.view(), self_.get(p.first).value_or(0));
+            }
+
+            algo::sort(functions.range(), [](const auto& a, const auto& b) {
+                if (a.second != b.second)
+                {
+                    return a.second > b.second;
+                }
+                return a.first < b.first;
+            });
+
+            report::table t;
+            t.add_row("Self", "Self%", "Incl%", "Function");
+            for (const auto& f : functions)
+            {
+                if (t.count() > limit)
+                {
+                    break;
+                }
+
+                const usize incl = inclusive_.get(f.first).value_or(0);
+                str self;
+                self << as_num(f.second);
+                t.add_row(std::move(self), report::percent(f.second, total_),
+                          report::percent(incl, total_), f.first);
+            }
+            return t.format();
+        }
+
+      private:
+        map::sorted<str, usize> stacks_;
+        map::sorted<str, usize> self_;
+        map::sorted<str, usize> inclusive_;
+        usize total_ = 0;
+
+        static void increment_(map::sorted<str, usize>& m, const cstrview key, const usize count)
+        {
+            if (auto v = m.get(key))
+            {
+                v.value() += count;
+            }
+            else
+            {
+                m.insert(key, count);
+            }
+        }
+    };
+
+    // Raw samples (instruction pointers, leaf first) and the memory mappings needed to resolve
+    // them to function names.
+    class profile final
+    {
+      public:
+        explicit profile(const cstrview executable)
+            : executable_{executable}
+        {
+        }
+
+        void add_lost(const u64 count) noexcept
+        {
+            lost_ += count;
+        }
+
+        void add_mapping(const u64 address, const u64 length, const u64 offset,
+                         const cstrview path)
+        {
+            mappings_.append(mapping{address, address + length, offset, str{path}});
+        }
+
+        void add_sample(const u64* const ips, const usize count)
+        {
+            if (count > 0)
+            {
+                samples_.append(count);
+                for (usize i = 0; i < count; ++i)
+                {
+                    samples_.append(ips[i]);
+                }
+                ++sample_count_;
+            }
+        }
+
+        [[nodiscard]] u64 lost() const noexcept
+        {
+            return lost_;
+        }
+
+        [[nodiscard]] usize sample_count() const noexcept
+        {
+            return sample_count_;
+        }
+
+        [[nodiscard]] folded_stacks resolve()
+        {
+            folded_stacks folded;
+
+            vec<str> frames;
+            usize i = 0;
+            while (i < samples_.count())
+            {
+                const auto count = static_cast<usize>(samples_.at(i, promise::within_bounds));
+                ++i;
+
+                frames.clear();
+                for (usize j = 0; j < count && i < samples_.count(); ++j, ++i)
+                {
+                    frames.append(name_(samples_.at(i, promise::within_bounds)));
+                }
+
+                folded.add(frames);
+            }
+
+            return folded;
+        }
+
+      private:
+        struct mapping final
+        {
+            u64 start  = 0;
+            u64 end    = 0;
+            u64 offset = 0;
+            str path;
+        };
+
+        str executable_;
+        vec<mapping> mappings_;
+        vec<u64> samples_; // [count, ip...] per sample.
+        map::unsorted<u64, str> names_;
+        elf::symbolizer symbolizer_;
+        usize sample_count_ = 0;
+        u64 lost_           = 0;
+
+        const str& name_(const u64 ip)
+        {
+            if (const auto name = names_.get(ip))
+            {
+                return name.value();
+            }
+            return names_.insert_inplace(ip, resolve_(ip)).value();
+        }
+
+        str resolve_(const u64 ip)
+        {
+            for (const auto& m : mappings_)
+            {
+                if (ip >= m.start && ip < m.end)
+                {
+                    const elf::file& f = symbolizer_.get(m.path);
+                    if (const auto address = f.address_from_offset(ip - m.start + m.offset))
+                    {
+                        return symbolizer_.name(m.path, address.value());
+                    }
+                    return concat("[", m.path, "]");
+                }
+            }
+
+            // Not in a known mapping, try the (non position independent) executable directly.
+            const elf::file& exe = symbolizer_.get(executable_);
+            if (!exe.is_position_independent())
+            {
+                if (const elf::symbol* sym = exe.find(ip))
+                {
+                    return elf::demangle(sym->name);
+                }
+            }
+
+            return str{"[unknown]"};
+        }
+    };
+
+#if defined(__linux__)
+    // CPU clock sampler with call chains, using perf_event_open(2) and reading the ring buffer
+    // directly. The event is opened disabled and inherited for the calling process and is
+    // enabled when a child calls exec, so only the child (and its descendants) is sampled. Open
+    // it just before spawning the child and close it directly after.
+    class sampler final
+    {
+      public:
+        sampler() = default;
+
+        ~sampler()
+        {
+            close();
+        }
+
+        // Non-copyable
+        sampler(const sampler&)            = delete;
+        sampler& operator=(const sampler&) = delete;
+
+        // Non-movable
+        sampler(sampler&&)            = delete;
+        sampler& operator=(sampler&&) = delete;
+
+        [[nodiscard]] bool open(const u64 frequency)
+        {
+            snn_should(fd_ < 0);
+
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size                     = sizeof(attr);
+            attr.type                     = PERF_TYPE_SOFTWARE;
+            attr.config                   = PERF_COUNT_SW_CPU_CLOCK;
+            attr.sample_freq              = frequency;
+            attr.freq                     = 1;
+            attr.sample_type              = PERF_SAMPLE_IP | PERF_SAMPLE_TID |
+                                            PERF_SAMPLE_CALLCHAIN;
+            attr.disabled                 = 1;
+            attr.inherit                  = 1;
+            attr.enable_on_exec           = 1;
+            attr.exclude_kernel           = 1;
+            attr.exclude_hv               = 1;
+            attr.exclude_callchain_kernel = 1;
+            attr.mmap                     = 1;
+
+            fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                                             PERF_FLAG_FD_CLOEXEC));
+            if (fd_ < 0)
+            {
+                error_ = errno;
+                return false;
+            }
+
+            page_size_ = static_cast<usize>(::sysconf(_SC_PAGESIZE));
+            data_size_ = page_size_ * data_pages_;
+            buffer_    = ::mmap(nullptr, page_size_ + data_size_, PROT_READ | PROT_WRITE,
+                                MAP_SHARED, fd_, 0);
+            if (buffer_ == MAP_FAILED)
+            {
+                error_  = errno;
+                buffer_ = nullptr;
+                close();
+                return false;
+            }
+
+            return true;
+        }
+
+        void close() noexcept
+        {
+            if (buffer_ != nullptr)
+            {
+                ::munmap(buffer_, page_size_ + data_size_);
+                buffer_ = nullptr;
+            }
+
+            if (fd_ >= 0)
+            {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+
+        [[nodiscard]] int error_number() const noexcept
+        {
+            return error_;
+        }
+
+        // Wait (at most `timeout_ms`) for the ring buffer to fill up.
+        void poll(const int timeout_ms) noexcept
+        {
+            if (fd_ >= 0)
+            {
+                pollfd pfd{fd_, POLLIN, 0};
+                ::poll(&pfd, 1, timeout_ms);
+            }
+        }
+
+        // Consume all records currently in the ring buffer.
+        void read(profile& p)
+        {
+            if (buffer_ == nullptr)
+            {
+                return;
+            }
+
+            auto* const meta = static_cast<perf_event_mmap_page*>(buffer_);
+            const u64 head   = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+            u64 tail         = meta->data_tail;
+
+            while (tail < head)
+            {
+                perf_event_header header;
+                copy_(tail, &header, sizeof(header));
+                if (header.size < sizeof(header) || header.size > head - tail)
+                {
+                    break; // Corrupt, should never happen.
+                }
+
+                copy_(tail, record_.begin(), header.size);
+                tail += header.size;
+
+                process_(header, p);
+            }
+
+            __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+        }
+
+      private:
+        static constexpr usize data_pages_ = 512; // Must be a power of two (2 MiB).
+
+        array<char, 65536> record_; // Maximum record size (`perf_event_header::size` is u16).
+        void* buffer_    = nullptr;
+        usize page_size_ = 0;
+        usize data_size_ = 0;
+        int fd_          = -1;
+        int error_       = 0;
+
+        void copy_(const u64 position, void* const dest, const usize size) const noexcept
+        {
+            const char* const data = static_cast<const char*>(buffer_) + page_size_;
+            const usize offset     = static_cast<usize>(position % data_size_);
+            const usize first      = math::min(size, data_size_ - offset);
+            std::memcpy(dest, data + offset, first);
+            std::memcpy(static_cast<char*>(dest) + first, data, size - first);
+        }
+
+        template <typename T>
+        [[nodiscard]] T load_(const usize offset) const noexcept
+        {
+            T value;
+            std::memcpy(&value, record_.begin() + offset, sizeof(T));
+            return value;
+        }
+
+        void process_(const perf_event_header& header, profile& p)
+        {
+            const usize size = header.size;
+
+            if (header.type == PERF_RECORD_SAMPLE)
+            {
+                // u64 ip; u32 pid, tid; u64 nr; u64 ips[nr];
+                usize offset = sizeof(perf_event_header) + sizeof(u64) + 2 * sizeof(u32);
+                if (offset + sizeof(u64) > size)
+                {
+                    return;
+                }
+                const u64 nr = load_<u64>(offset);
+                offset += sizeof(u64);
+
+                array<u64, 256> ips;
+                usize count = 0;
+                for (u64 i = 0; i < nr && offset + sizeof(u64) <= size; ++i)
+                {
+                    const u64 ip = load_<u64>(offset);
+                    offset += sizeof(u64);
+
+                    // Skip context markers (`PERF_CONTEXT_USER` etc.).
+                    if (ip < static_cast<u64>(PERF_CONTEXT_MAX) && count < ips.count())
+                    {
+                        ips.at(count, promise::within_bounds) = ip;
+                        ++count;
+                    }
+                }
+
+                p.add_sample(ips.begin(), count);
+            }
+            else if (header.type == PERF_RECORD_MMAP)
+            {
+                // u32 pid, tid; u64 addr, len, pgoff; char filename[];
+                const usize offset = sizeof(perf_event_header) + 2 * sizeof(u32);
+                if (offset + 3 * sizeof(u64) < size)
+                {
+                    const u64 address = load_<u64>(offset);
+                    const u64 length  = load_<u64>(offset + sizeof(u64));
+                    const u64 pgoff   = load_<u64>(offset + 2 * sizeof(u64));
+
+                    const usize name_offset = offset + 3 * sizeof(u64);
+                    const cstrview rest{record_.begin() + name_offset, size - name_offset};
+                    const cstrview path = rest.view(0, rest.find('\0').value_or(rest.size()));
+                    if (path.has_front('/'))
+                    {
+                        p.add_mapping(address, length, pgoff, path);
+                    }
+                }
+            }
+            else if (header.type == PERF_RECORD_LOST)
+            {
+                // u64 id, lost;
+                const usize offset = sizeof(perf_event_header) + sizeof(u64);
+                if (offset + sizeof(u64) <= size)
+                {
+                    p.add_lost(load_<u64>(offset));
+                }
+            }
+        }
+    };
+#endif
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/profiler.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        app::profiler::folded_stacks folded;
+        snn_require(folded.total() == 0);
+        snn_require(folded.folded() == "");
+
+        vec<str> frames;
+
+        // Leaf first.
+        frames.append("parse");
+        frames.append("run");
+        frames.append("main");
+        folded.add(frames);
+        folded.add(frames);
+
+        frames.clear();
+        frames.append("run");
+        frames.append("main");
+        folded.add(frames, 3);
+
+        // Recursion
+        frames.clear();
+        frames.append("walk");
+        frames.append("walk");
+        frames.append("main");
+        folded.add(frames);
+
+        snn_require(folded.total() == 6);
+        snn_require(folded.folded() == "main;run 3\n"
+                                       "main;run;parse 2\n"
+                                       "main;walk;walk 1\n");
+
+        snn_require(folded.top(2) == "Self  Self%  Incl%  Function\n"
+                                     "   3  50.0%  83.3%  run\n"
+                                     "   2  33.3%  33.3%  parse\n");
+    }
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/range/view/enumerate.hh"
+#include <iterator> // size
+
+namespace snn::app::report
+{
+    // Percent with one decimal, e.g. "12.3%".
+    [[nodiscard]] inline str percent(const u64 part, const u64 total)
+    {
+        const u64 tenths = total > 0 ? (part * 1000 + total / 2) / total : 0;
+        str s;
+        s << as_num(tenths / 10) << '.' << as_num(tenths % 10) << '%';
+        return s;
+    }
+
+    // Human readable size, e.g. "512 B", "1.5 KiB", "12.0 MiB".
+    [[nodiscard]] inline str bytes(const u64 n)
+    {
+        str s;
+        if (n < 1024)
+        {
+            s << as_num(n) << " B";
+            return s;
+        }
+
+        constexpr cstrview units[] = {"KiB", "MiB", "GiB", "TiB"};
+
+        u64 unit = 1024;
+        usize i  = 0;
+        while (i + 1 < std::size(units) && n >= unit * 1024)
+        {
+            unit *= 1024;
+            ++i;
+        }
+
+        const u64 tenths = (n * 10 + unit / 2) / unit;
+        s << as_num(tenths / 10) << '.' << as_num(tenths % 10) << ' ' << units[i];
+        return s;
+    }
+
+    // Human readable duration, e.g. "850 us", "123 ms", "4.56 s".
+    [[nodiscard]] inline str duration(const u64 nanoseconds)
+    {
+        str s;
+        if (nanoseconds < 1'000'000)
+        {
+            s << as_num(nanoseconds / 1'000) << " us";
+        }
+        else if (nanoseconds < 1'000'000'000)
+        {
+            s << as_num(nanoseconds / 1'000'000) << " ms";
+        }
+        else
+        {
+            const u64 hundredths = nanoseconds / 10'000'000;
+            s << as_num(hundredths / 100) << '.';
+            if (hundredths % 100 < 10)
+            {
+                s << '0';
+            }
+            s << as_num(hundredths % 100) << " s";
+        }
+        return s;
+    }
+
+    // Plain text table, all columns except the last are right aligned, the last column (usually
+    // a name or a path) is left aligned and not padded.
+    class table final
+    {
+      public:
+        template <typename... Cells>
+        void add_row(Cells&&... cells)
+        {
+            vec<str> row{container::reserve, sizeof...(Cells)};
+            (row.append(str{std::forward<Cells>(cells)}), ...);
+            rows_.append(std::move(row));
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return rows_.count();
+        }
+
+        [[nodiscard]] strbuf format() const
+        {
+            vec<usize> widths;
+            for (const auto& row : rows_)
+            {
+                for (const auto [i, cell] : row.range() | range::v::enumerate{})
+                {
+                    if (i >= widths.count())
+                    {
+                        widths.append(0);
+                    }
+                    widths.at(i, promise::within_bounds) =
+                        math::max(widths.at(i, promise::within_bounds), cell.size());
+                }
+            }
+
+            strbuf out{container::reserve, rows_.count() * 80};
+            for (const auto& row : rows_)
+            {
+                for (const auto [i, cell] : row.range() | range::v::enumerate{})
+                {
+                    if (i > 0)
+                    {
+                        out << "  ";
+                    }
+
+                    if (i + 1 < row.count())
+                    {
+                        for (usize pad = cell.size(); pad < widths.at(i, promise::within_bounds);
+                             ++pad)
+                        {
+                            out << ' ';
+                        }
+                    }
+
+                    out << cell;
+                }
+                out << '\n';
+            }
+            return out;
+        }
+
+      private:
+        vec<vec<str>> rows_;
+    };
+}
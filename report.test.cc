@@ -0,0 +1,42 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/report.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        snn_require(app::report::percent(0, 0) == "0.0%");
+        snn_require(app::report::percent(0, 10) == "0.0%");
+        snn_require(app::report::percent(1, 3) == "33.3%");
+        snn_require(app::report::percent(2, 3) == "66.7%");
+        snn_require(app::report::percent(10, 10) == "100.0%");
+
+        snn_require(app::report::bytes(0) == "0 B");
+        snn_require(app::report::bytes(1023) == "1023 B");
+        snn_require(app::report::bytes(1024) == "1.0 KiB");
+        snn_require(app::report::bytes(1536) == "1.5 KiB");
+        snn_require(app::report::bytes(12 * 1024 * 1024) == "12.0 MiB");
+
+        snn_require(app::report::duration(0) == "0 us");
+        snn_require(app::report::duration(850'000) == "850 us");
+        snn_require(app::report::duration(123'456'789) == "123 ms");
+        snn_require(app::report::duration(4'560'000'000) == "4.56 s");
+        snn_require(app::report::duration(4'050'000'000) == "4.05 s");
+
+        app::report::table t;
+        snn_require(t.count() == 0);
+        snn_require(t.format() == "");
+
+        t.add_row("Self", "Total", "Function");
+        t.add_row("5", "100", "main");
+        t.add_row("12345", "7", "snn::unittest()");
+        snn_require(t.count() == 3);
+        snn_require(t.format() == " Self  Total  Function\n"
+                                  "    5    100  main\n"
+                                  "12345      7  snn::unittest()\n");
+    }
+}
@@ -0,0 +1,196 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "build-tool/report.hh"
+#include <sys/resource.h> // rusage
+
+namespace snn::app::resources
+{
+    // Resource usage of a finished process.
+    struct usage final
+    {
+        u64 wall_ns              = 0;
+        u64 user_ns              = 0;
+        u64 system_ns            = 0;
+        u64 max_rss              = 0; // Peak resident set size in bytes.
+        u64 minor_faults         = 0; // Page faults without I/O.
+        u64 major_faults         = 0; // Page faults with I/O.
+        u64 voluntary_switches   = 0; // E.g. waiting for I/O or a lock.
+        u64 involuntary_switches = 0; // Preempted.
+        u64 block_input          = 0; // Block input operations.
+        u64 block_output         = 0; // Block output operations.
+
+        [[nodiscard]] constexpr u64 cpu_ns() const noexcept
+        {
+            return user_ns + system_ns;
+        }
+    };
+
+    namespace detail
+    {
+        [[nodiscard]] constexpr u64 nanoseconds(const ::timeval& tv) noexcept
+        {
+            if (tv.tv_sec < 0 || tv.tv_usec < 0)
+            {
+                return 0;
+            }
+            return static_cast<u64>(tv.tv_sec) * 1'000'000'000 +
+                   static_cast<u64>(tv.tv_usec) * 1'000;
+        }
+
+        [[nodiscard]] constexpr u64 count(const long n) noexcept
+        {
+            return n > 0 ? static_cast<u64>(n) : 0;
+        }
+    }
+
+    // `ru_maxrss` is in kilobytes on Linux and FreeBSD.
+    [[nodiscard]] constexpr usage from_rusage(const ::rusage& ru, const u64 wall_ns) noexcept
+    {
+        usage u;
+        u.wall_ns              = wall_ns;
+        u.user_ns              = detail::nanoseconds(ru.ru_utime);
+        u.system_ns            = detail::nanoseconds(ru.ru_stime);
+        u.max_rss              = detail::count(ru.ru_maxrss) * 1024;
+        u.minor_faults         = detail::count(ru.ru_minflt);
+        u.major_faults         = detail::count(ru.ru_majflt);
+        u.voluntary_switches   = detail::count(ru.ru_nvcsw);
+        u.involuntary_switches = detail::count(ru.ru_nivcsw);
+        u.block_input          = detail::count(ru.ru_inblock);
+        u.block_output         = detail::count(ru.ru_oublock);
+        return u;
+    }
+
+    // Sort column of a `table`.
+    enum class column : u8
+    {
+        wall,
+        cpu,
+        rss,
+        faults,
+        switches,
+        io,
+    };
+
+    [[nodiscard]] constexpr optional<column> parse_column(const cstrview s) noexcept
+    {
+        if (s == "wall")
+        {
+            return column::wall;
+        }
+        if (s == "cpu")
+        {
+            return column::cpu;
+        }
+        if (s == "rss")
+        {
+            return column::rss;
+        }
+        if (s == "faults")
+        {
+            return column::faults;
+        }
+        if (s == "switches")
+        {
+            return column::switches;
+        }
+        if (s == "io")
+        {
+            return column::io;
+        }
+        return nullopt;
+    }
+
+    [[nodiscard]] constexpr u64 value(const usage& u, const column c) noexcept
+    {
+        switch (c)
+        {
+            case column::wall:
+                return u.wall_ns;
+            case column::cpu:
+                return u.cpu_ns();
+            case column::rss:
+                return u.max_rss;
+            case column::faults:
+                return u.major_faults + u.minor_faults;
+            case column::switches:
+                return u.voluntary_switches + u.involuntary_switches;
+            case column::io:
+                return u.block_input + u.block_output;
+        }
+        return 0;
+    }
+
+    // Resource usage per application, sorted by a column (descending).
+    class table final
+    {
+      public:
+        void add(str name, const usage& u)
+        {
+            rows_.append(row{std::move(name), u});
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return rows_.count();
+        }
+
+        [[nodiscard]] strbuf format(const column sort_by) const
+        {
+            vec<usize> order{container::reserve, rows_.count()};
+            for (usize i = 0; i < rows_.count(); ++i)
+            {
+                order.append(i);
+            }
+
+            algo::sort(order.range(), [this, sort_by](const usize a, const usize b) {
+                const row& x = rows_.at(a, promise::within_bounds);
+                const row& y = rows_.at(b, promise::within_bounds);
+                const u64 xv = value(x.u, sort_by);
+                const u64 yv = value(y.u, sort_by);
+                if (xv != yv)
+                {
+                    return xv > yv;
+                }
+                return x.name < y.name;
+            });
+
+            report::table t;
+            // Page faults (minor/major), context switches (voluntary/involuntary) and block
+            // operations (input/output).
+            t.add_row("Wall", "User", "System", "Max RSS", "MinFlt", "MajFlt", "VCSW", "IVCSW",
+                      "BlkIn", "BlkOut", "Application");
+            for (const usize i : order)
+            {
+                const row& r = rows_.at(i, promise::within_bounds);
+                t.add_row(report::duration(r.u.wall_ns), report::duration(r.u.user_ns),
+                          report::duration(r.u.system_ns), report::bytes(r.u.max_rss),
+                          number_(r.u.minor_faults), number_(r.u.major_faults),
+                          number_(r.u.voluntary_switches), number_(r.u.involuntary_switches),
+                          number_(r.u.block_input), number_(r.u.block_output), r.name);
+            }
+            return t.format();
+        }
+
+      private:
+        struct row final
+        {
+            str name;
+            usage u;
+        };
+
+        vec<row> rows_;
+
+        [[nodiscard]] static str number_(const u64 n)
+        {
+            str s;
+            s << as_num(n);
+            return s;
+        }
+    };
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/resources.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            ::rusage ru{};
+            ru.ru_utime.tv_sec  = 1;
+            ru.ru_utime.tv_usec = 500'000;
+            ru.ru_stime.tv_usec = 250;
+            ru.ru_maxrss        = 2048;
+            ru.ru_minflt        = 10;
+            ru.ru_majflt        = 1;
+            ru.ru_nvcsw         = 5;
+            ru.ru_nivcsw        = 2;
+            ru.ru_inblock       = 8;
+            ru.ru_oublock       = 16;
+
+            const auto u = app::resources::from_rusage(ru, 3'000'000'000);
+            snn_require(u.wall_ns == 3'000'000'000);
+            snn_require(u.user_ns == 1'500'000'000);
+            snn_require(u.system_ns == 250'000);
+            snn_require(u.cpu_ns() == 1'500'250'000);
+            snn_require(u.max_rss == 2 * 1024 * 1024);
+            snn_require(u.minor_faults == 10);
+            snn_require(u.major_faults == 1);
+            snn_require(u.voluntary_switches == 5);
+            snn_require(u.involuntary_switches == 2);
+            snn_require(u.block_input == 8);
+            snn_require(u.block_output == 16);
+
+            using app::resources::column;
+            snn_require(app::resources::value(u, column::wall) == 3'000'000'000);
+            snn_require(app::resources::value(u, column::cpu) == 1'500'250'000);
+            snn_require(app::resources::value(u, column::rss) == 2 * 1024 * 1024);
+            snn_require(app::resources::value(u, column::faults) == 11);
+            snn_require(app::resources::value(u, column::switches) == 7);
+            snn_require(app::resources::value(u, column::io) == 24);
+        }
+        {
+            const auto u = app::resources::from_rusage(::rusage{}, 0);
+            snn_require(u.cpu_ns() == 0);
+            snn_require(u.max_rss == 0);
+            snn_require(u.minor_faults == 0);
+        }
+        {
+            static_assert(app::resources::parse_column("rss").value() ==
+                          app::resources::column::rss);
+            static_assert(app::resources::parse_column("io").value() ==
+                          app::resources::column::io);
+            static_assert(!app::resources::parse_column(""));
+            static_assert(!app::resources::parse_column("RSS"));
+        }
+        {
+            app::resources::usage a;
+            a.wall_ns = 2'000'000;
+            a.max_rss = 1024;
+
+            app::resources::usage b;
+            b.wall_ns      = 1'000'000;
+            b.max_rss      = 4096;
+            b.minor_faults = 3;
+
+            app::resources::table t;
+            t.add("./a", a);
+            t.add("./b", b);
+            snn_require(t.count() == 2);
+
+            snn_require(t.format(app::resources::column::rss) ==
+                        "Wall  User  System  Max RSS  MinFlt  MajFlt  VCSW  IVCSW  BlkIn  BlkOut"
+                        "  Application\n"
+                        "1 ms  0 us    0 us  4.0 KiB       3       0     0      0      0       0"
+                        "  ./b\n"
+                        "2 ms  0 us    0 us  1.0 KiB       0       0     0      0      0       0"
+                        "  ./a\n");
+            snn_require(t.format(app::resources::column::wall).has_front(
+                "Wall  User  System  Max RSS  MinFlt  MajFlt  VCSW  IVCSW  BlkIn  BlkOut"
+                "  Application\n2 ms"));
+        }
+    }
+}
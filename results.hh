@@ -0,0 +1,364 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/set/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/json.hh"
+#include "build-tool/report.hh"
+#include "build-tool/resources.hh"
+
+namespace snn::app::results
+{
+    inline constexpr cstrview passed    = "passed";
+    inline constexpr cstrview failed    = "failed";
+    inline constexpr cstrview cached    = "cached";
+    inline constexpr cstrview not_run   = "not-run"; // Build failure or stopped after a failure.
+    inline constexpr cstrview timed_out = "timed-out";
+    inline constexpr cstrview missing   = "missing"; // Selected, but not in any shard's results.
+
+    struct entry final
+    {
+        str application;
+        str shard; // "K/N" or empty.
+        str status;
+        u64 duration_ns = 0;
+        resources::usage usage; // Only for applications that ran (`wall_ns` is not used).
+    };
+
+    namespace detail
+    {
+        struct usage_field final
+        {
+            cstrview key;
+            u64 resources::usage::*member;
+        };
+
+        inline constexpr usage_field usage_fields[] = {
+            {"user_ns", &resources::usage::user_ns},
+            {"system_ns", &resources::usage::system_ns},
+            {"max_rss", &resources::usage::max_rss},
+            {"minor_faults", &resources::usage::minor_faults},
+            {"major_faults", &resources::usage::major_faults},
+            {"voluntary_switches", &resources::usage::voluntary_switches},
+            {"involuntary_switches", &resources::usage::involuntary_switches},
+            {"block_input", &resources::usage::block_input},
+            {"block_output", &resources::usage::block_output},
+        };
+    }
+
+    // One JSON object per line (JSON Lines), e.g.:
+    // {"application":"a.test.cc","shard":"1/2","status":"passed","duration_ns":1200}
+    // Followed by the resource usage fields ("user_ns", "max_rss", ...) if the application ran.
+    inline void append_line(const entry& e, strbuf& out)
+    {
+        out << "{\"application\":";
+        json::append_string(e.application, out);
+        out << ",\"shard\":";
+        json::append_string(e.shard, out);
+        out << ",\"status\":";
+        json::append_string(e.status, out);
+        out << ",\"duration_ns\":" << as_num(e.duration_ns);
+        if (e.usage.cpu_ns() > 0 || e.usage.max_rss > 0)
+        {
+            for (const auto& field : detail::usage_fields)
+            {
+                out << ",\"" << field.key << "\":" << as_num(e.usage.*field.member);
+            }
+        }
+        out << "}\n";
+    }
+
+    // The applications that were selected before they were partitioned into shards (the same for
+    // every shard), e.g.:
+    // {"shard":"1/2","selected":["a.test.cc","b.test.cc"]}
+    inline void append_selection(const cstrview shard, const set::sorted<str>& applications,
+                                 strbuf& out)
+    {
+        out << "{\"shard\":";
+        json::append_string(shard, out);
+        out << ",\"selected\":[";
+        bool first = true;
+        for (const auto& application : applications)
+        {
+            if (!first)
+            {
+                out << ',';
+            }
+            first = false;
+            json::append_string(application, out);
+        }
+        out << "]}\n";
+    }
+
+    // Results from one or more `runall --json` files (e.g. one per shard), keyed by application.
+    class merged final
+    {
+      public:
+        // Returns false if a line is invalid. Applications that are already added (e.g. in
+        // overlapping shards) are counted as duplicates, the first result is kept.
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                entry e;
+                set::sorted<str> selection;
+                bool is_selection = false; // `e.shard` is the shard of the selection.
+                json::reader r{line};
+                r.object([&](const cstrview key, json::reader& v) {
+                    if (key == "selected")
+                    {
+                        is_selection = true;
+                        v.array([&selection](json::reader& application) {
+                            selection.insert(application.string().value_or_default());
+                        });
+                    }
+                    else if (key == "application")
+                    {
+                        e.application = v.string().value_or_default();
+                    }
+                    else if (key == "shard")
+                    {
+                        e.shard = v.string().value_or_default();
+                    }
+                    else if (key == "status")
+                    {
+                        e.status = v.string().value_or_default();
+                    }
+                    else if (key == "duration_ns")
+                    {
+                        e.duration_ns = v.integer().value_or(0);
+                    }
+                    else
+                    {
+                        for (const auto& field : detail::usage_fields)
+                        {
+                            if (key == field.key)
+                            {
+                                e.usage.*field.member = v.integer().value_or(0);
+                                break;
+                            }
+                        }
+                    }
+                });
+
+                if (!r.is_valid())
+                {
+                    return false;
+                }
+
+                if (is_selection)
+                {
+                    select(std::move(e.shard), std::move(selection));
+                    continue;
+                }
+
+                if (e.application.is_empty() || e.status.is_empty())
+                {
+                    return false;
+                }
+
+                add(std::move(e));
+            }
+            return true;
+        }
+
+        // Set the applications that a shard was selected from. Every shard must have the same
+        // selection, a different one is counted as a mismatch (the first one is kept).
+        void select(str shard, set::sorted<str> applications)
+        {
+            if (!has_selection_)
+            {
+                selection_shard_ = std::move(shard);
+                selection_       = std::move(applications);
+                has_selection_   = true;
+                return;
+            }
+
+            if (shard != selection_shard_)
+            {
+                selection_shard_.clear(); // Merged from several shards.
+            }
+
+            bool same = applications.count() == selection_.count();
+            for (const auto& application : applications)
+            {
+                same = same && selection_.contains(application);
+            }
+            if (!same)
+            {
+                ++selection_mismatches_;
+            }
+        }
+
+        // Selected applications without a result (no shard had them, e.g. because the workers
+        // partitioned with different timing files).
+        [[nodiscard]] vec<cstrview> missing_applications() const
+        {
+            vec<cstrview> missing_apps;
+            for (const auto& application : selection_)
+            {
+                if (!contains(application))
+                {
+                    missing_apps.append(application.view());
+                }
+            }
+            return missing_apps;
+        }
+
+        [[nodiscard]] usize selection_mismatches() const noexcept
+        {
+            return selection_mismatches_;
+        }
+
+        void add(entry e)
+        {
+            if (entries_.get(e.application))
+            {
+                ++duplicates_;
+                return;
+            }
+
+            if (e.shard)
+            {
+                shards_.insert(e.shard);
+            }
+            str application = e.application;
+            entries_.insert(std::move(application), std::move(e));
+        }
+
+        [[nodiscard]] bool contains(const cstrview application) const
+        {
+            return entries_.get(application).has_value();
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return entries_.count();
+        }
+
+        [[nodiscard]] usize count(const cstrview status) const
+        {
+            usize n = 0;
+            for (const auto& p : entries_)
+            {
+                if (p.second.status == status)
+                {
+                    ++n;
+                }
+            }
+            return n;
+        }
+
+        [[nodiscard]] usize duplicates() const noexcept
+        {
+            return duplicates_;
+        }
+
+        // True if every application passed (or was cached), no application was run twice and
+        // (with a selection) every selected application has a result.
+        [[nodiscard]] bool is_success() const
+        {
+            return count(passed) + count(cached) == count() && duplicates_ == 0 &&
+                   selection_mismatches_ == 0 && missing_applications().is_empty();
+        }
+
+        [[nodiscard]] strbuf serialize() const
+        {
+            strbuf out{container::reserve, entries_.count() * 100 + selection_.count() * 40};
+            if (has_selection_)
+            {
+                append_selection(selection_shard_, selection_, out);
+            }
+            for (const auto& p : entries_)
+            {
+                append_line(p.second, out);
+            }
+            return out;
+        }
+
+        // Applications that didn't pass (all with `all`) and a summary line.
+        [[nodiscard]] strbuf format(const bool all) const
+        {
+            report::table t;
+            t.add_row("Time", "Status", "Shard", "Application");
+            for (const auto& p : entries_)
+            {
+                const entry& e = p.second;
+                if (all || (e.status != passed && e.status != cached))
+                {
+                    t.add_row(report::duration(e.duration_ns), e.status, e.shard, e.application);
+                }
+            }
+
+            const auto missing_apps = missing_applications();
+            for (const cstrview application : missing_apps)
+            {
+                t.add_row("-", missing, "", application);
+            }
+
+            strbuf out{container::reserve, t.count() * 80 + 128};
+            if (t.count() > 1)
+            {
+                out << t.format();
+                out << '\n';
+            }
+
+            const usize others = count() - count(passed) - count(failed) - count(cached) -
+                                 count(not_run) - count(timed_out);
+            fmt::format_append("Applications: {}, passed: {}, cached: {}, failed: {}, not run: {}",
+                               out, promise::no_overlap, count(), count(passed), count(cached),
+                               count(failed), count(not_run));
+            if (count(timed_out) > 0)
+            {
+                fmt::format_append(", timed out: {}", out, promise::no_overlap, count(timed_out));
+            }
+            if (others > 0)
+            {
+                fmt::format_append(", other: {}", out, promise::no_overlap, others);
+            }
+            if (!missing_apps.is_empty())
+            {
+                fmt::format_append(", missing: {}", out, promise::no_overlap,
+                                   missing_apps.count());
+            }
+            if (shards_.count() > 0)
+            {
+                fmt::format_append(" (shards: {})", out, promise::no_overlap, shards_.count());
+            }
+            out << '\n';
+
+            if (duplicates_ > 0)
+            {
+                fmt::format_append("Duplicates: {} (overlapping shards, were the same timing files"
+                                   " used by all workers?)\n",
+                                   out, promise::no_overlap, duplicates_);
+            }
+            if (selection_mismatches_ > 0)
+            {
+                fmt::format_append("Selection mismatches: {} (the shards were selected from"
+                                   " different applications)\n",
+                                   out, promise::no_overlap, selection_mismatches_);
+            }
+            return out;
+        }
+
+      private:
+        map::sorted<str, entry> entries_;
+        set::sorted<str> shards_;
+        set::sorted<str> selection_;
+        str selection_shard_;
+        usize duplicates_           = 0;
+        usize selection_mismatches_ = 0;
+        bool has_selection_         = false;
+    };
+}
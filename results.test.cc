@@ -0,0 +1,152 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/results.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            strbuf out;
+            app::results::append_line(app::results::entry{"a.test.cc", "1/2", "passed", 1200},
+                                      out);
+            snn_require(out == "{\"application\":\"a.test.cc\",\"shard\":\"1/2\","
+                               "\"status\":\"passed\",\"duration_ns\":1200}\n");
+
+            app::results::merged m;
+            snn_require(m.parse(out));
+            snn_require(m.count() == 1);
+            snn_require(m.count(app::results::passed) == 1);
+            snn_require(m.is_success());
+            snn_require(m.serialize() == out);
+        }
+        {
+            app::results::entry e{"a.test.cc", "", "passed", 1200};
+            e.usage.user_ns      = 900;
+            e.usage.max_rss      = 4096;
+            e.usage.block_output = 2;
+
+            strbuf out;
+            app::results::append_line(e, out);
+            snn_require(out == "{\"application\":\"a.test.cc\",\"shard\":\"\","
+                               "\"status\":\"passed\",\"duration_ns\":1200,\"user_ns\":900,"
+                               "\"system_ns\":0,\"max_rss\":4096,\"minor_faults\":0,"
+                               "\"major_faults\":0,\"voluntary_switches\":0,"
+                               "\"involuntary_switches\":0,\"block_input\":0,"
+                               "\"block_output\":2}\n");
+
+            app::results::merged m;
+            snn_require(m.parse(out));
+            snn_require(m.serialize() == out);
+        }
+        {
+            strbuf shard1;
+            app::results::append_line(app::results::entry{"b.test.cc", "1/2", "failed", 3'000},
+                                      shard1);
+            app::results::append_line(app::results::entry{"c.test.cc", "1/2", "not-run", 0},
+                                      shard1);
+
+            strbuf shard2;
+            app::results::append_line(app::results::entry{"a.test.cc", "2/2", "cached", 0},
+                                      shard2);
+
+            app::results::merged m;
+            snn_require(m.parse(shard1));
+            snn_require(m.parse(shard2));
+            snn_require(m.count() == 3);
+            snn_require(m.count(app::results::failed) == 1);
+            snn_require(m.count(app::results::not_run) == 1);
+            snn_require(m.count(app::results::cached) == 1);
+            snn_require(m.duplicates() == 0);
+            snn_require(!m.is_success());
+
+            // Sorted by application.
+            snn_require(m.serialize().view().has_front("{\"application\":\"a.test.cc\""));
+
+            snn_require(m.format(false) == "Time   Status  Shard  Application\n"
+                                           "3 us   failed    1/2  b.test.cc\n"
+                                           "0 us  not-run   1/2  c.test.cc\n"
+                                           "\n"
+                                           "Applications: 3, passed: 0, cached: 1, failed: 1,"
+                                           " not run: 1 (shards: 2)\n");
+
+            // Overlapping shards.
+            snn_require(m.parse(shard2));
+            snn_require(m.count() == 3);
+            snn_require(m.duplicates() == 1);
+        }
+        {
+            set::sorted<str> selected;
+            selected.insert("a.test.cc");
+            selected.insert("b.test.cc");
+            selected.insert("c.test.cc");
+
+            strbuf shard1;
+            app::results::append_selection("1/2", selected, shard1);
+            snn_require(shard1 == "{\"shard\":\"1/2\",\"selected\":[\"a.test.cc\","
+                                  "\"b.test.cc\",\"c.test.cc\"]}\n");
+            app::results::append_line(app::results::entry{"a.test.cc", "1/2", "passed", 0},
+                                      shard1);
+
+            strbuf shard2;
+            app::results::append_selection("2/2", selected, shard2);
+            app::results::append_line(app::results::entry{"b.test.cc", "2/2", "passed", 0},
+                                      shard2);
+
+            app::results::merged m;
+            snn_require(m.parse(shard1));
+            snn_require(m.parse(shard2));
+            snn_require(m.count() == 2);
+            snn_require(!m.is_success()); // Gap: no shard ran c.test.cc.
+            snn_require(m.missing_applications().count() == 1);
+            snn_require(m.missing_applications().at(0).value() == "c.test.cc");
+            snn_require(m.format(false) == "Time   Status  Shard  Application\n"
+                                           "   -  missing         c.test.cc\n"
+                                           "\n"
+                                           "Applications: 2, passed: 2, cached: 0, failed: 0,"
+                                           " not run: 0, missing: 1 (shards: 2)\n");
+
+            // Merged results keep the selection.
+            app::results::merged copy;
+            snn_require(copy.parse(m.serialize()));
+            snn_require(copy.serialize().view().has_front("{\"shard\":\"\",\"selected\":["));
+            snn_require(copy.missing_applications().count() == 1);
+
+            // A shard selected from different applications.
+            strbuf other;
+            selected.insert("d.test.cc");
+            app::results::append_selection("2/2", selected, other);
+            app::results::append_line(app::results::entry{"c.test.cc", "2/2", "passed", 0},
+                                      other);
+            snn_require(m.parse(other));
+            snn_require(m.missing_applications().is_empty());
+            snn_require(m.selection_mismatches() == 1);
+            snn_require(!m.is_success());
+            snn_require(m.format(false).view().has_back(
+                "Selection mismatches: 1 (the shards were selected from different"
+                " applications)\n"));
+        }
+        {
+            strbuf out;
+            app::results::append_selection("1/1", {}, out);
+            app::results::merged m;
+            snn_require(m.parse(out));
+            snn_require(m.count() == 0);
+            snn_require(m.is_success()); // Empty selection.
+        }
+        {
+            app::results::merged m;
+            snn_require(m.parse(""));
+            snn_require(!m.parse("{}\n"));
+            snn_require(m.parse("{\"application\":\"a.test.cc\",\"status\":\"timed-out\"}\n"));
+            snn_require(m.count(app::results::timed_out) == 1);
+            snn_require(m.format(false).view().has_back(
+                "Applications: 1, passed: 0, cached: 0, failed: 0, not run: 0, timed out: 1\n"));
+            snn_require(!m.parse("{\"application\":\"a.test.cc\"}\n"));
+            snn_require(!m.parse("not json\n"));
+        }
+    }
+}
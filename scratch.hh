@@ -0,0 +1,86 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include <ftw.h>    // nftw
+#include <stdio.h>  // remove
+#include <stdlib.h> // getenv, mkdtemp
+#include <unistd.h> // access
+#include <cstring>  // memcpy, strlen
+
+namespace snn::app::scratch
+{
+    // Private scratch directories for applications, exposed as `TMPDIR` and `SNN_TEST_TMPDIR`, so
+    // that applications that run in parallel don't share temporary files.
+
+    // `/dev/shm` (tmpfs) if it is writable, otherwise `$TMPDIR` or `/tmp`.
+    [[nodiscard]] inline str base_directory()
+    {
+        if (::access("/dev/shm", W_OK | X_OK) == 0)
+        {
+            return str{"/dev/shm"};
+        }
+
+        const char* const tmpdir = std::getenv("TMPDIR");
+        if (tmpdir != nullptr && tmpdir[0] == '/')
+        {
+            str base{cstrview{tmpdir, std::strlen(tmpdir)}};
+            if (base.has_back('/'))
+            {
+                base.drop_back_n(1);
+            }
+            return base;
+        }
+
+        return str{"/tmp"};
+    }
+
+    // Create a directory (mode 0700) in `base`, returns an empty string on failure.
+    [[nodiscard]] inline str create(const cstrview base)
+    {
+        constexpr usize max_size = 4096; // PATH_MAX on Linux.
+
+        const str pattern = concat(base, "/snn-test-XXXXXX");
+        if (pattern.size() >= max_size)
+        {
+            return str{};
+        }
+
+        char buf[max_size];
+        std::memcpy(buf, pattern.null_terminated().get(), pattern.size() + 1);
+        if (::mkdtemp(buf) == nullptr)
+        {
+            return str{};
+        }
+        return str{cstrview{buf, pattern.size()}};
+    }
+
+    // "NAME=value" strings for the environment of an application.
+    [[nodiscard]] inline vec<str> environment(const cstrview dir)
+    {
+        vec<str> env{container::reserve, 2};
+        env.append(concat("TMPDIR=", dir));
+        env.append(concat("SNN_TEST_TMPDIR=", dir));
+        return env;
+    }
+
+    namespace detail
+    {
+        inline int remove_entry(const char* const path, const struct stat*, const int,
+                                FTW*) noexcept
+        {
+            return ::remove(path);
+        }
+    }
+
+    // Remove a directory and everything in it (symbolic links are not followed).
+    [[nodiscard]] inline bool remove(const str& dir)
+    {
+        constexpr int max_open_fds = 16;
+        return ::nftw(dir.null_terminated().get(), detail::remove_entry, max_open_fds,
+                      FTW_DEPTH | FTW_PHYS) == 0;
+    }
+}
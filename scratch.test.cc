@@ -0,0 +1,41 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/scratch.hh"
+
+#include "snn-core/unittest.hh"
+#include "snn-core/file/is_directory.hh"
+#include "snn-core/file/is_something.hh"
+#include "snn-core/file/write.hh"
+#include <sys/stat.h> // mkdir
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            const auto env = app::scratch::environment("/dev/shm/snn-test-abc123");
+            snn_require(env.count() == 2);
+            snn_require(env.at(0).value() == "TMPDIR=/dev/shm/snn-test-abc123");
+            snn_require(env.at(1).value() == "SNN_TEST_TMPDIR=/dev/shm/snn-test-abc123");
+        }
+        {
+            const str base = app::scratch::base_directory();
+            snn_require(base.has_front('/'));
+            snn_require(!base.has_back('/'));
+
+            const str dir = app::scratch::create(base);
+            snn_require(dir.has_front(concat(base, "/snn-test-")));
+            snn_require(file::is_directory(dir));
+
+            const str nested = concat(dir, "/a");
+            snn_require(::mkdir(nested.null_terminated().get(), 0700) == 0);
+            snn_require(file::write(concat(nested, "/b.txt"), "b"));
+
+            snn_require(app::scratch::remove(dir));
+            snn_require(!file::is_something(dir));
+
+            snn_require(app::scratch::create("/nonexistent-snn-dir").is_empty());
+        }
+    }
+}
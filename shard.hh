@@ -0,0 +1,112 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "build-tool/number.hh"
+
+namespace snn::app::shard
+{
+    struct spec final
+    {
+        usize index = 0; // Zero-based.
+        usize count = 1;
+    };
+
+    // Parse "K/N" where 1 <= K <= N (K is one-based).
+    [[nodiscard]] inline optional<spec> parse(const cstrview s)
+    {
+        const auto slash = s.find('/');
+        if (!slash)
+        {
+            return nullopt;
+        }
+
+        const usize pos = slash.value(promise::has_value);
+        const auto k    = number::parse(s.view(0, pos));
+        const auto n    = number::parse(s.view(pos + 1));
+        if (!k || !n)
+        {
+            return nullopt;
+        }
+
+        const u64 kv = k.value(promise::has_value);
+        const u64 nv = n.value(promise::has_value);
+        if (kv == 0 || kv > nv || nv > 10'000) // Arbitrary upper limit.
+        {
+            return nullopt;
+        }
+
+        return spec{static_cast<usize>(kv - 1), static_cast<usize>(nv)};
+    }
+
+    struct item final
+    {
+        cstrview name;
+        u64 cost = 0;
+    };
+
+    // Deterministic longest-first partition: items are sorted by cost (descending, then by name)
+    // and each goes to the least loaded shard (the lowest index on ties). Returns the shard index
+    // of each item (in item order). Every worker must use the same items and costs.
+    [[nodiscard]] inline vec<usize> partition(const vec<item>& items, const usize count)
+    {
+        vec<usize> order{container::reserve, items.count()};
+        for (usize i = 0; i < items.count(); ++i)
+        {
+            order.append(i);
+        }
+
+        algo::sort(order.range(), [&items](const usize a, const usize b) {
+            const item& x = items.at(a, promise::within_bounds);
+            const item& y = items.at(b, promise::within_bounds);
+            if (x.cost != y.cost)
+            {
+                return x.cost > y.cost;
+            }
+            return x.name < y.name;
+        });
+
+        const usize shards = math::max(usize{1}, count);
+
+        vec<u64> loads{container::reserve, shards};
+        vec<usize> counts{container::reserve, shards};
+        for (usize i = 0; i < shards; ++i)
+        {
+            loads.append(0);
+            counts.append(0);
+        }
+
+        vec<usize> assigned{container::reserve, items.count()};
+        for (usize i = 0; i < items.count(); ++i)
+        {
+            assigned.append(0);
+        }
+
+        for (const usize index : order)
+        {
+            // Least loaded, then fewest items (spreads zero cost items), then lowest index.
+            usize least = 0;
+            for (usize s = 1; s < shards; ++s)
+            {
+                const u64 load       = loads.at(s, promise::within_bounds);
+                const u64 least_load = loads.at(least, promise::within_bounds);
+                if (load < least_load ||
+                    (load == least_load && counts.at(s, promise::within_bounds) <
+                                               counts.at(least, promise::within_bounds)))
+                {
+                    least = s;
+                }
+            }
+
+            loads.at(least, promise::within_bounds) += items.at(index, promise::within_bounds).cost;
+            ++counts.at(least, promise::within_bounds);
+            assigned.at(index, promise::within_bounds) = least;
+        }
+
+        return assigned;
+    }
+}
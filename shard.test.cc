@@ -0,0 +1,66 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/shard.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            const auto s = app::shard::parse("2/4");
+            snn_require(s);
+            snn_require(s.value().index == 1);
+            snn_require(s.value().count == 4);
+
+            snn_require(app::shard::parse("1/1"));
+            snn_require(app::shard::parse("4/4"));
+
+            snn_require(!app::shard::parse(""));
+            snn_require(!app::shard::parse("1"));
+            snn_require(!app::shard::parse("0/4"));
+            snn_require(!app::shard::parse("5/4"));
+            snn_require(!app::shard::parse("1/0"));
+            snn_require(!app::shard::parse("a/4"));
+            snn_require(!app::shard::parse("1/4/2"));
+        }
+        {
+            vec<app::shard::item> items;
+            items.append(app::shard::item{"a", 1});
+            items.append(app::shard::item{"b", 7});
+            items.append(app::shard::item{"c", 3});
+            items.append(app::shard::item{"d", 3});
+            items.append(app::shard::item{"e", 2});
+
+            // Sorted: b(7), c(3), d(3), e(2), a(1).
+            // b -> 0, c -> 1, d -> 1 (3 < 7), e -> 1 (6 < 7), a -> 0 (7 < 8).
+            const auto assigned = app::shard::partition(items, 2);
+            snn_require(assigned.count() == 5);
+            snn_require(assigned.at(0).value() == 0);
+            snn_require(assigned.at(1).value() == 0);
+            snn_require(assigned.at(2).value() == 1);
+            snn_require(assigned.at(3).value() == 1);
+            snn_require(assigned.at(4).value() == 1);
+        }
+        {
+            // Without costs the items are spread by count (in name order).
+            vec<app::shard::item> items;
+            items.append(app::shard::item{"c", 0});
+            items.append(app::shard::item{"a", 0});
+            items.append(app::shard::item{"b", 0});
+            items.append(app::shard::item{"d", 0});
+
+            const auto assigned = app::shard::partition(items, 3);
+            snn_require(assigned.at(0).value() == 2); // c
+            snn_require(assigned.at(1).value() == 0); // a
+            snn_require(assigned.at(2).value() == 1); // b
+            snn_require(assigned.at(3).value() == 0); // d
+        }
+        {
+            const vec<app::shard::item> items;
+            snn_require(app::shard::partition(items, 4).is_empty());
+        }
+    }
+}
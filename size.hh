@@ -0,0 +1,546 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/pair/common.hh"
+#include "snn-core/range/step.hh"
+#include "snn-core/set/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+#include "build-tool/report.hh"
+
+namespace snn::app::size
+{
+    // Origin of symbols that are not defined by a single object file of the application (inline
+    // functions and template instantiations whose header couldn't be determined).
+    constexpr cstrview origin_inline = "(inline/template)";
+
+    // Origin of symbols from outside the application (C runtime, static libraries).
+    constexpr cstrview origin_other = "(other)";
+
+    // Drop template arguments, function parameters, qualifiers and the return type from a
+    // demangled name, e.g. "void snn::vec<int, 8ul>::append(int) const" -> "snn::vec<>::append".
+    [[nodiscard]] inline str without_arguments(const cstrview name)
+    {
+        str out;
+        usize templates  = 0;
+        usize braces     = 0;
+        bool in_operator = false;
+
+        for (usize i = 0; i < name.size(); ++i)
+        {
+            const cstrview rest = name.view(i);
+            const char c        = rest.front(promise::not_empty);
+
+            if (templates > 0)
+            {
+                if (c == '<')
+                {
+                    ++templates;
+                }
+                else if (c == '>')
+                {
+                    --templates;
+                }
+                continue;
+            }
+
+            if (braces > 0)
+            {
+                // E.g. "{lambda(int)#1}", kept as is.
+                if (c == '{')
+                {
+                    ++braces;
+                }
+                else if (c == '}')
+                {
+                    --braces;
+                }
+                out << c;
+                continue;
+            }
+
+            if (rest.has_front("(anonymous namespace)"))
+            {
+                out << "(anonymous namespace)";
+                i += string_size("(anonymous namespace)") - 1;
+                continue;
+            }
+
+            if (in_operator || out == "operator" || out.has_back(":operator") ||
+                out.has_back(" operator"))
+            {
+                // E.g. "operator<<", "operator()" and "operator[]".
+                if (rest.has_front("()"))
+                {
+                    out << "()";
+                    ++i;
+                    in_operator = false;
+                    continue;
+                }
+
+                if (c != '(' && c != ' ' && cstrview{"<>=!+-*/%^&|~[],"}.contains(c))
+                {
+                    out << c;
+                    in_operator = true;
+                    continue;
+                }
+
+                in_operator = false;
+            }
+
+            if (c == '(')
+            {
+                break;
+            }
+
+            if (c == '<')
+            {
+                ++templates;
+                out << "<>";
+            }
+            else if (c == '{')
+            {
+                ++braces;
+                out << c;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+
+        // Drop the return type (only present for function templates).
+        for (usize i = out.size(); i > 0; --i)
+        {
+            const cstrview before = out.view(0, i - 1);
+            if (out.at(i - 1, promise::within_bounds) == ' ' && !before.has_back("(anonymous") &&
+                !before.has_back("operator"))
+            {
+                return str{out.view(i)};
+            }
+        }
+
+        return out;
+    }
+
+    // Guess the header that defines an inline function or a template (without arguments, see
+    // `without_arguments()`) from its qualified name, e.g. "snn::file::read" is matched with
+    // ".../file/read.hh" before ".../file.hh". Returns an empty view if no header matches.
+    [[nodiscard]] inline cstrview header_for(const cstrview name, const set::sorted<str>& headers)
+    {
+        vec<cstrview> parts;
+        cstrview rest = name;
+        while (!rest.is_empty())
+        {
+            const usize pos = rest.find("::").value_or(rest.size());
+            cstrview part   = rest.view(0, pos);
+            rest            = rest.view(pos + math::min(rest.size() - pos, usize{2}));
+
+            if (part.has_back("<>"))
+            {
+                part.drop_back_n(2);
+            }
+
+            if (part.is_empty() || part.contains('(') || part.contains('{') ||
+                part.contains(' '))
+            {
+                break;
+            }
+
+            parts.append(part);
+        }
+
+        // Longest match first.
+        for (usize length = parts.count(); length > 0; --length)
+        {
+            for (usize first = 0; first + length <= parts.count(); ++first)
+            {
+                str candidate;
+                for (const auto i : range::step<usize>{first, first + length})
+                {
+                    if (i > first)
+                    {
+                        candidate << '/';
+                    }
+                    candidate << parts.at(i, promise::within_bounds);
+                }
+                candidate << ".hh";
+
+                const str suffix = concat("/", candidate);
+                for (const auto& header : headers)
+                {
+                    if (header == candidate || header.has_back(suffix))
+                    {
+                        return header.view();
+                    }
+                }
+            }
+        }
+
+        return cstrview{};
+    }
+
+    // Size breakdown of an executable by section, by origin (source file, header or template)
+    // and by symbol. Can be saved and compared with another build (or configuration).
+    class breakdown final
+    {
+      public:
+        void add_section(str name, const u64 size)
+        {
+            sections_.append(entry{std::move(name), size});
+        }
+
+        // The name is demangled.
+        void add_symbol(str name, str origin, const u64 size)
+        {
+            symbols_.append(symbol{std::move(name), std::move(origin), size});
+        }
+
+        // Format (tab separated):
+        // section <size> <name>
+        // symbol <size> <origin> <name>
+        [[nodiscard]] strbuf serialize() const
+        {
+            strbuf out{container::reserve, (sections_.count() + symbols_.count()) * 64};
+            for (const auto& s : sections_)
+            {
+                out << "section\t" << as_num(s.size) << '\t' << s.name << '\n';
+            }
+            for (const auto& s : symbols_)
+            {
+                out << "symbol\t" << as_num(s.size) << '\t' << s.origin << '\t' << s.name << '\n';
+            }
+            return out;
+        }
+
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            vec<cstrview> fields;
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                fields.clear();
+                for (const cstrview field : string::range::split{line, '\t'})
+                {
+                    fields.append(field);
+                }
+
+                if (fields.count() < 2)
+                {
+                    return false;
+                }
+
+                const auto size = number::parse(fields.at(1, promise::within_bounds));
+                if (!size)
+                {
+                    return false;
+                }
+
+                const cstrview type = fields.front(promise::not_empty);
+                if (type == "section" && fields.count() == 3)
+                {
+                    add_section(str{fields.at(2, promise::within_bounds)},
+                                size.value(promise::has_value));
+                }
+                else if (type == "symbol" && fields.count() == 4)
+                {
+                    add_symbol(str{fields.at(3, promise::within_bounds)},
+                               str{fields.at(2, promise::within_bounds)},
+                               size.value(promise::has_value));
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] strbuf format(const usize top) const
+        {
+            strbuf out{container::reserve, 4 * constant::size::kibibyte<usize>};
+
+            const auto sections = sections_by_name_();
+            const u64 total     = sum_(sections);
+            fmt::format_append("Sections ({}):\n", out, promise::no_overlap,
+                               report::bytes(total));
+            out << table_(sections, total, "Section", top);
+
+            const auto origins = origins_();
+            const u64 symbols  = sum_(origins);
+            fmt::format_append("\nOrigins ({} in symbols):\n", out, promise::no_overlap,
+                               report::bytes(symbols));
+            out << table_(origins, symbols, "Origin", top);
+
+            const auto templates = templates_();
+            if (templates)
+            {
+                out << "\nTemplates (two or more instantiations):\n";
+                report::table t;
+                t.add_row("Size", "Count", "Template");
+                for (const auto& p : sorted_(templates, [](const auto& v) { return v.size; }))
+                {
+                    if (t.count() > top)
+                    {
+                        break;
+                    }
+                    const instantiations& inst = templates.get(p.first).value();
+                    str count;
+                    count << as_num(inst.count);
+                    t.add_row(report::bytes(inst.size), std::move(count), p.first);
+                }
+                out << t.format();
+            }
+
+            out << "\nLargest symbols:\n";
+            out << table_(symbols_by_name_(), symbols, "Symbol", top);
+
+            return out;
+        }
+
+        // Differences from a previous breakdown, largest changes first.
+        [[nodiscard]] strbuf format_diff(const breakdown& before, const usize top) const
+        {
+            strbuf out{container::reserve, 4 * constant::size::kibibyte<usize>};
+
+            const auto sections_before = before.sections_by_name_();
+            const auto sections_after  = sections_by_name_();
+            fmt::format_append("Total: {} -> {} ({})\n", out, promise::no_overlap,
+                               report::bytes(sum_(sections_before)),
+                               report::bytes(sum_(sections_after)),
+                               delta_(sum_(sections_before), sum_(sections_after)));
+
+            out << "\nSections:\n";
+            out << diff_table_(sections_before, sections_after, "Section", top);
+            out << "\nOrigins:\n";
+            out << diff_table_(before.origins_(), origins_(), "Origin", top);
+            out << "\nSymbols:\n";
+            out << diff_table_(before.symbols_by_name_(), symbols_by_name_(), "Symbol", top);
+
+            return out;
+        }
+
+      private:
+        struct entry final
+        {
+            str name;
+            u64 size = 0;
+        };
+
+        struct symbol final
+        {
+            str name;
+            str origin;
+            u64 size = 0;
+        };
+
+        struct instantiations final
+        {
+            u64 count = 0;
+            u64 size  = 0;
+        };
+
+        vec<entry> sections_;
+        vec<symbol> symbols_;
+
+        [[nodiscard]] map::sorted<str, u64> sections_by_name_() const
+        {
+            map::sorted<str, u64> m;
+            for (const auto& s : sections_)
+            {
+                add_(m, s.name, s.size);
+            }
+            return m;
+        }
+
+        [[nodiscard]] map::sorted<str, u64> origins_() const
+        {
+            map::sorted<str, u64> m;
+            for (const auto& s : symbols_)
+            {
+                add_(m, s.origin, s.size);
+            }
+            return m;
+        }
+
+        // Local symbols with the same name (from different object files) are summed.
+        [[nodiscard]] map::sorted<str, u64> symbols_by_name_() const
+        {
+            map::sorted<str, u64> m;
+            for (const auto& s : symbols_)
+            {
+                add_(m, s.name, s.size);
+            }
+            return m;
+        }
+
+        [[nodiscard]] map::sorted<str, instantiations> templates_() const
+        {
+            map::sorted<str, instantiations> m;
+            for (const auto& s : symbols_)
+            {
+                if (s.name.contains('<'))
+                {
+                    auto res = m.insert_inplace(without_arguments(s.name));
+                    ++res.value().count;
+                    res.value().size += s.size;
+                }
+            }
+
+            // Only report templates with more than one instantiation.
+            map::sorted<str, instantiations> bloat;
+            for (const auto& p : m)
+            {
+                if (p.second.count >= 2)
+                {
+                    bloat.insert(p.first, p.second);
+                }
+            }
+            return bloat;
+        }
+
+        static void add_(map::sorted<str, u64>& m, const cstrview key, const u64 size)
+        {
+            if (auto v = m.get(key))
+            {
+                v.value() += size;
+            }
+            else
+            {
+                m.insert(key, size);
+            }
+        }
+
+        static u64 sum_(const map::sorted<str, u64>& m) noexcept
+        {
+            u64 total = 0;
+            for (const auto& p : m)
+            {
+                total += p.second;
+            }
+            return total;
+        }
+
+        // Keys sorted by size (largest first), then by name.
+        template <typename V, typename SizeFn>
+        static vec<pair::first_second<cstrview, u64>> sorted_(const map::sorted<str, V>& m,
+                                                              SizeFn size_fn)
+        {
+            vec<pair::first_second<cstrview, u64>> v{container::reserve, m.count()};
+            for (const auto& p : m)
+            {
+                v.append_inplace(p.first.view(), size_fn(p.second));
+            }
+
+            algo::sort(v.range(), [](const auto& a, const auto& b) {
+                if (a.second != b.second)
+                {
+                    return a.second > b.second;
+                }
+                return a.first < b.first;
+            });
+
+            return v;
+        }
+
+        static strbuf table_(const map::sorted<str, u64>& m, const u64 total,
+                             const cstrview heading, const usize top)
+        {
+            report::table t;
+            t.add_row("Size", "Share", heading);
+            for (const auto& p : sorted_(m, [](const u64 size) { return size; }))
+            {
+                if (t.count() > top)
+                {
+                    break;
+                }
+                t.add_row(report::bytes(p.second), report::percent(p.second, total), p.first);
+            }
+            return t.format();
+        }
+
+        // E.g. "+1.5 KiB", "-96 B" or "0 B".
+        static str delta_(const u64 before, const u64 after)
+        {
+            if (after > before)
+            {
+                return concat("+", report::bytes(after - before));
+            }
+            if (after < before)
+            {
+                return concat("-", report::bytes(before - after));
+            }
+            return report::bytes(0);
+        }
+
+        static strbuf diff_table_(const map::sorted<str, u64>& before,
+                                  const map::sorted<str, u64>& after, const cstrview heading,
+                                  const usize top)
+        {
+            struct change final
+            {
+                cstrview name;
+                u64 before = 0;
+                u64 after  = 0;
+
+                u64 magnitude() const noexcept
+                {
+                    return after > before ? after - before : before - after;
+                }
+            };
+
+            vec<change> changes;
+            for (const auto& p : after)
+            {
+                const u64 b = before.get(p.first).value_or(0);
+                if (b != p.second)
+                {
+                    changes.append(change{p.first.view(), b, p.second});
+                }
+            }
+            for (const auto& p : before)
+            {
+                if (!after.get(p.first))
+                {
+                    changes.append(change{p.first.view(), p.second, 0});
+                }
+            }
+
+            if (changes.is_empty())
+            {
+                return strbuf{"No changes\n"};
+            }
+
+            algo::sort(changes.range(), [](const change& a, const change& b) {
+                if (a.magnitude() != b.magnitude())
+                {
+                    return a.magnitude() > b.magnitude();
+                }
+                return a.name < b.name;
+            });
+
+            report::table t;
+            t.add_row("Before", "After", "Delta", heading);
+            for (const auto& c : changes)
+            {
+                if (t.count() > top)
+                {
+                    break;
+                }
+                t.add_row(report::bytes(c.before), report::bytes(c.after),
+                          delta_(c.before, c.after), c.name);
+            }
+            return t.format();
+        }
+    };
+}
@@ -0,0 +1,122 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/size.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            using app::size::without_arguments;
+
+            snn_require(without_arguments("main") == "main");
+            snn_require(without_arguments("void snn::vec<int, 8ul>::append(int) const") ==
+                        "snn::vec<>::append");
+            snn_require(without_arguments("snn::str::operator<<(int)") ==
+                        "snn::str::operator<<");
+            snn_require(without_arguments("snn::fn::less::operator()(int, int) const") ==
+                        "snn::fn::less::operator()");
+            snn_require(without_arguments("(anonymous namespace)::helper(int)") ==
+                        "(anonymous namespace)::helper");
+            snn_require(without_arguments("void snn::(anonymous namespace)::foo<char>(char)") ==
+                        "snn::(anonymous namespace)::foo<>");
+        }
+        {
+            set::sorted<str> headers;
+            headers.insert("snn-core/file/read.hh");
+            headers.insert("snn-core/fmt/format.hh");
+            headers.insert("snn-core/vec.hh");
+
+            using app::size::header_for;
+
+            snn_require(header_for("snn::file::read", headers) == "snn-core/file/read.hh");
+            snn_require(header_for("snn::vec<>::append", headers) == "snn-core/vec.hh");
+            snn_require(header_for("snn::fmt::format_append", headers).is_empty());
+            snn_require(header_for("", headers).is_empty());
+        }
+        {
+            app::size::breakdown before;
+            before.add_section(".text", 1000);
+            before.add_section(".rodata", 200);
+            before.add_section(".data", 50);
+            before.add_symbol("main", "app.cc", 100);
+            before.add_symbol("snn::vec<int>::append(int)", "snn-core/vec.hh", 300);
+            before.add_symbol("snn::vec<char>::append(char)", "snn-core/vec.hh", 200);
+            before.add_symbol("helper()", "(other)", 50);
+
+            snn_require(before.format(10) == "Sections (1.2 KiB):\n"
+                                             "  Size  Share  Section\n"
+                                             "1000 B  80.0%  .text\n"
+                                             " 200 B  16.0%  .rodata\n"
+                                             "  50 B   4.0%  .data\n"
+                                             "\n"
+                                             "Origins (650 B in symbols):\n"
+                                             " Size  Share  Origin\n"
+                                             "500 B  76.9%  snn-core/vec.hh\n"
+                                             "100 B  15.4%  app.cc\n"
+                                             " 50 B   7.7%  (other)\n"
+                                             "\n"
+                                             "Templates (two or more instantiations):\n"
+                                             " Size  Count  Template\n"
+                                             "500 B      2  snn::vec<>::append\n"
+                                             "\n"
+                                             "Largest symbols:\n"
+                                             " Size  Share  Symbol\n"
+                                             "300 B  46.2%  snn::vec<int>::append(int)\n"
+                                             "200 B  30.8%  snn::vec<char>::append(char)\n"
+                                             "100 B  15.4%  main\n"
+                                             " 50 B   7.7%  helper()\n");
+
+            // Serialize & parse.
+            app::size::breakdown saved;
+            snn_require(saved.parse(before.serialize()));
+            snn_require(saved.serialize() == before.serialize());
+
+            app::size::breakdown after;
+            after.add_section(".text", 1100);
+            after.add_section(".rodata", 200);
+            after.add_symbol("main", "app.cc", 150);
+            after.add_symbol("snn::vec<int>::append(int)", "snn-core/vec.hh", 300);
+            after.add_symbol("helper()", "(other)", 50);
+
+            snn_require(after.format_diff(saved, 10) ==
+                        "Total: 1.2 KiB -> 1.3 KiB (+50 B)\n"
+                        "\n"
+                        "Sections:\n"
+                        "Before   After   Delta  Section\n"
+                        "1000 B  1100 B  +100 B  .text\n"
+                        "  50 B     0 B   -50 B  .data\n"
+                        "\n"
+                        "Origins:\n"
+                        "Before  After   Delta  Origin\n"
+                        " 500 B  300 B  -200 B  snn-core/vec.hh\n"
+                        " 100 B  150 B   +50 B  app.cc\n"
+                        "\n"
+                        "Symbols:\n"
+                        "Before  After   Delta  Symbol\n"
+                        " 200 B    0 B  -200 B  snn::vec<char>::append(char)\n"
+                        " 100 B  150 B   +50 B  main\n");
+
+            snn_require(after.format_diff(after, 10) == "Total: 1.3 KiB -> 1.3 KiB (0 B)\n"
+                                                        "\n"
+                                                        "Sections:\n"
+                                                        "No changes\n"
+                                                        "\n"
+                                                        "Origins:\n"
+                                                        "No changes\n"
+                                                        "\n"
+                                                        "Symbols:\n"
+                                                        "No changes\n");
+        }
+        {
+            app::size::breakdown b;
+            snn_require(b.parse(""));
+            snn_require(!b.parse("section\n"));
+            snn_require(!b.parse("section\tabc\t.text\n"));
+            snn_require(!b.parse("unknown\t1\tx\n"));
+        }
+    }
+}
@@ -5,6 +5,7 @@
 #include "snn-core/main.hh"
 #include "snn-core/vec.hh"
 #include "snn-core/algo/join.hh"
+#include "snn-core/algo/sort.hh"
 #include "snn-core/ascii/trim.hh"
 #include "snn-core/chr/common.hh"
 #include "snn-core/env/options.hh"
@@ -23,7 +24,6 @@
 #include "snn-core/map/sorted.hh"
 #include "snn-core/map/unsorted.hh"
 #include "snn-core/process/execute.hh"
-#include "snn-core/process/spawner.hh"
 #include "snn-core/random/number.hh"
 #include "snn-core/range/step.hh"
 #include "snn-core/range/view/element.hh"
@@ -33,8 +33,43 @@
 #include "snn-core/string/range/split.hh"
 #include "snn-core/string/range/wrap.hh"
 #include "snn-core/utf8/is_valid.hh"
+#include "build-tool/annotations.hh"
+#include "build-tool/bundle.hh"
+#include "build-tool/cache.hh"
+#include "build-tool/capture.hh"
+#include "build-tool/cgroup.hh"
+#include "build-tool/child.hh"
+#include "build-tool/clock.hh"
+#include "build-tool/coverage.hh"
+#include "build-tool/digest.hh"
+#include "build-tool/fuzz.hh"
+#include "build-tool/hang.hh"
+#include "build-tool/heap.hh"
+#include "build-tool/jobs.hh"
+#include "build-tool/number.hh"
+#include "build-tool/preload.hh"
 #include "build-tool/preprocessor.hh"
+#include "build-tool/profiler.hh"
+#include "build-tool/resources.hh"
+#include "build-tool/results.hh"
+#include "build-tool/scratch.hh"
+#include "build-tool/shard.hh"
+#include "build-tool/size.hh"
+#include "build-tool/startup.hh"
+#include "build-tool/stats.hh"
+#include "build-tool/timetrace.hh"
+#include "build-tool/timings.hh"
+#include "build-tool/trace.hh"
 #include "build-tool/validator.hh"
+#include <sys/ioctl.h> // ioctl
+#include <sys/stat.h>  // mkdir
+#include <fcntl.h>     // open
+#include <unistd.h>    // close, getcwd, isatty, write
+#include <cerrno>
+#include <cstdio>  // rename
+#include <cstdlib> // free, getenv, realpath, setenv
+#include <cstring> // strlen
+#include <ctime>   // time
 
 namespace snn::app
 {
@@ -124,13 +159,150 @@ namespace snn::app
             return applications_;
         }
 
+        [[nodiscard]] const vec<bundle::group>& bundles() const noexcept
+        {
+            return bundles_;
+        }
+
+        // `[#test:...]` annotations of an application, call after `parse()`.
+        [[nodiscard]] annotations::test test_annotations(const cstrview application) const
+        {
+            if (const auto t = test_annotations_.get(application))
+            {
+                return t.value();
+            }
+            return annotations::test{};
+        }
+
+        [[nodiscard]] cstrview compiler() const noexcept
+        {
+            return compiler_;
+        }
+
         [[nodiscard]] cstrview compiler_default() const noexcept
         {
             return compiler_default_;
         }
 
+        // Libraries (`LIBn`) that an application links with, call after `parse()`.
+        [[nodiscard]] set::sorted<str> libraries(const str& application) const
+        {
+            set::sorted<str> libraries;
+            for (const auto lib : library_dependencies_(application))
+            {
+                libraries.insert(lib);
+            }
+            return libraries;
+        }
+
+        // Directory for per-workspace data (e.g. caches), next to the compiler config file, call
+        // after `setup_compiler_and_macros()`.
+        [[nodiscard]] str workspace_directory() const
+        {
+            // The config file path always includes a directory separator, e.g. "../.clang".
+            usize pos = config_file_.size();
+            while (pos > 0 && config_file_.at(pos - 1, promise::within_bounds) != '/')
+            {
+                --pos;
+            }
+            return concat(config_file_.view(0, pos), ".snn");
+        }
+
+        // Headers that an application (and the source files it depends on) includes, call after
+        // `parse()`.
+        [[nodiscard]] set::sorted<str> headers(const str& application) const
+        {
+            set::sorted<str> headers;
+            for (const auto source : source_dependencies_(application))
+            {
+                for (const auto header : header_dependencies_(str{source}))
+                {
+                    headers.insert(header);
+                }
+            }
+            return headers;
+        }
+
+        // Source files that an application depends on (including itself), call after `parse()`.
+        [[nodiscard]] set::sorted<str> sources(const str& application) const
+        {
+            set::sorted<str> sources;
+            for (const auto source : source_dependencies_(application))
+            {
+                sources.insert(source);
+            }
+            return sources;
+        }
+
+        // Applications whose dependency graph includes one of the changed files, call after
+        // `parse()`. Paths are compared after resolving them, so the changed files can be relative
+        // to the current directory or absolute. Files that don't exist (deleted) are ignored.
+        [[nodiscard]] set::sorted<str> affected_applications(const vec<str>& changed) const
+        {
+            const auto affected = affected_(changed, true);
+
+            set::sorted<str> applications;
+            for (const auto& app : applications_)
+            {
+                if (affected.contains(app.view()))
+                {
+                    applications.insert(app);
+                }
+            }
+            return applications;
+        }
+
+        // Source files that must be recompiled if the changed files change (the changed source
+        // files and the source files that include a changed file), call after `parse()`.
+        [[nodiscard]] set::sorted<str> affected_sources(const vec<str>& changed) const
+        {
+            set::sorted<str> sources;
+            for (const auto file : affected_(changed, false))
+            {
+                if (file.has_back(".cc"))
+                {
+                    sources.insert(file);
+                }
+            }
+            return sources;
+        }
+
+        // Number of source files that include each file (directly or indirectly), zero for files
+        // that are not in the dependency graph, call after `parse()`.
+        [[nodiscard]] vec<usize> fan_in(const vec<str>& files) const
+        {
+            const auto index = reverse_index_(false);
+
+            vec<usize> counts{container::reserve, files.count()};
+            vec<str> file{container::reserve, 1};
+            for (const auto& f : files)
+            {
+                file.clear();
+                file.append(f);
+
+                usize count = 0;
+                for (const auto dependent : affected_(index, file))
+                {
+                    if (dependent.has_back(".cc"))
+                    {
+                        ++count;
+                    }
+                }
+                counts.append(count);
+            }
+            return counts;
+        }
+
+        // Only generate targets for a subset of the applications, call after `parse()`.
+        void select_applications(set::sorted<str> selection) noexcept
+        {
+            applications_ = std::move(selection);
+        }
+
         [[nodiscard]] bool generate(const str& makefile, const str& makefile_depend) const
         {
+            const trace::scope span{"generate", makefile};
+
             if (verbose_level_ >= 3)
             {
                 fmt::print_error_line("Generating: {}", makefile);
@@ -156,6 +328,14 @@ namespace snn::app
             {
                 mk << "time ";
             }
+            if (isolator_)
+            {
+                mk << isolator_ << ' ';
+            }
+            if (timer_)
+            {
+                mk << timer_ << ' ';
+            }
             mk << compiler_ << '\n';
 
             mk << "CFLAGS =";
@@ -189,6 +369,25 @@ namespace snn::app
                 cflags.append("-fno-sanitize-recover=all");
             }
 
+            if (coverage_)
+            {
+                // Source-based coverage (clang only).
+                cflags.append("-fprofile-instr-generate");
+                cflags.append("-fcoverage-mapping");
+            }
+
+            if (frame_pointers_)
+            {
+                // Frame pointers are needed to walk the stack when profiling.
+                cflags.append("-fno-omit-frame-pointer");
+            }
+
+            if (time_trace_)
+            {
+                // Time trace (clang only), written next to the object file: "a.o" -> "a.json".
+                cflags.append("-ftime-trace");
+            }
+
             for (const cstrview macro : string::range::split{macros_, ','})
             {
                 cflags.append(concat("-D", macro));
@@ -211,6 +410,19 @@ namespace snn::app
 
             mk << "LINK = -L/usr/local/lib/\n";
 
+            if (!bundles_.is_empty())
+            {
+                // The renamed `main` functions of bundled tests have no previous declaration.
+                if (compiler_.has_front("clang"))
+                {
+                    mk << "BUNDLE = -Wno-missing-prototypes\n";
+                }
+                else
+                {
+                    mk << "BUNDLE = -Wno-missing-declarations\n";
+                }
+            }
+
 #if defined(__FreeBSD__)
             if (makefile_depend)
             {
@@ -218,12 +430,30 @@ namespace snn::app
             }
 #endif
 
-            // Variables for each application.
+            // Variables for each application (bundled tests are built as part of their bundle).
+
+            set::unsorted<cstrview> bundled;
+            for (const auto& b : bundles_)
+            {
+                for (const auto& test : b.tests)
+                {
+                    bundled.insert(test.view());
+                }
+            }
+
+            set::sorted<cstrview> optimized; // Source files with `[#opt:...]` flags.
+            usize target_count = 0;
 
-            for (const auto [index, app] : applications_.range() | range::v::enumerate{})
+            for (const auto& app : applications_)
             {
+                if (bundled.contains(app.view()))
+                {
+                    continue;
+                }
+
                 str idx;
-                idx << as_num(index);
+                idx << as_num(target_count);
+                ++target_count;
 
                 const auto executable = app.view_offset(0, -3); // Drop ".cc".
 
@@ -234,6 +464,14 @@ namespace snn::app
                 algo::join(sources.range(), "\\\n\t   ", mk, promise::no_overlap);
                 mk << '\n';
 
+                for (const auto source : sources)
+                {
+                    if (has_object_flags_(source))
+                    {
+                        optimized.insert(source);
+                    }
+                }
+
                 mk << "OBJ" << idx << " = $(SRC" << idx << ":.cc=.o)\n";
 
                 mk << "LIB" << idx << " =";
@@ -245,6 +483,62 @@ namespace snn::app
                 mk << '\n';
             }
 
+            // Variables for each bundle, the driver and the source files that the tests depend on
+            // are built as usual, the tests with their own rules (see below).
+
+            for (const auto& b : bundles_)
+            {
+                str idx;
+                idx << as_num(target_count);
+                ++target_count;
+
+                mk << "\nAPP" << idx << " = " << b.executable << '\n';
+
+                set::sorted<cstrview> sources;
+                set::sorted<cstrview> libraries;
+                sources.insert(b.driver.view());
+                for (const auto& test : b.tests)
+                {
+                    for (const cstrview source : source_dependencies_(test))
+                    {
+                        if (source != test)
+                        {
+                            sources.insert(source);
+                        }
+                    }
+                    for (const cstrview lib : library_dependencies_(test))
+                    {
+                        libraries.insert(lib);
+                    }
+                }
+
+                mk << "SRC" << idx << " = ";
+                algo::join(sources.range(), "\\\n\t   ", mk, promise::no_overlap);
+                mk << '\n';
+
+                for (const auto source : sources)
+                {
+                    if (has_object_flags_(source))
+                    {
+                        optimized.insert(source);
+                    }
+                }
+
+                mk << "OBJ" << idx << " = $(SRC" << idx << ":.cc=.o)";
+                for (const auto& test : b.tests)
+                {
+                    mk << "\\\n\t   " << bundle::object(test);
+                }
+                mk << '\n';
+
+                mk << "LIB" << idx << " =";
+                for (const auto lib : libraries)
+                {
+                    mk << " -l" << lib;
+                }
+                mk << '\n';
+            }
+
             // How to build object files (suffixes).
 
             mk << "\n";
@@ -259,8 +553,8 @@ namespace snn::app
 
             phony_targets.append("all");
             mk << "\nall:";
-            strbuf all{container::reserve, 8 * applications_.count()};
-            for (const auto index : range::step<usize>{0, applications_.count()})
+            strbuf all{container::reserve, 8 * target_count};
+            for (const auto index : range::step<usize>{0, target_count})
             {
                 all << " $(APP" << as_num(index) << ')';
             }
@@ -270,7 +564,7 @@ namespace snn::app
             }
             mk << '\n';
 
-            for (const auto index : range::step<usize>{0, applications_.count()})
+            for (const auto index : range::step<usize>{0, target_count})
             {
                 str idx;
                 idx << as_num(index);
@@ -279,11 +573,41 @@ namespace snn::app
                    << " $(LINK) $(LIB" << idx << ")\n";
             }
 
+            // Bundled tests, with `unittest` and `main` renamed (see `bundle::group`).
+
+            for (const auto& b : bundles_)
+            {
+                for (const auto [index, test] : b.tests.range() | range::v::enumerate{})
+                {
+                    mk << '\n' << bundle::object(test) << ": " << test << '\n';
+                    mk << "\t$(CC) $(CFLAGS) $(INC) $(BUNDLE) " << bundle::macros(index);
+                    for (const auto& flag : dependencies_.get(test).value().flags)
+                    {
+                        mk << ' ' << flag;
+                    }
+                    mk << " -c -o $@ " << test << '\n';
+                }
+            }
+
+            // Source files with `[#opt:...]` annotations, the flags are added after `$(CFLAGS)`
+            // so that they take precedence (e.g. `-O3` in a `-O2` or debug build).
+
+            for (const auto source : optimized)
+            {
+                mk << '\n' << source.view_offset(0, -3) << ".o: " << source << '\n';
+                mk << "\t$(CC) $(CFLAGS) $(INC)";
+                for (const auto& flag : dependencies_.get(source).value().flags)
+                {
+                    mk << ' ' << flag;
+                }
+                mk << " -c -o $@ " << source << '\n';
+            }
+
             // Target: clean-executables
 
             phony_targets.append("clean-executables");
             mk << "\nclean-executables:\n";
-            for (const auto index : range::step<usize>{0, applications_.count()})
+            for (const auto index : range::step<usize>{0, target_count})
             {
                 mk << "\trm -f $(APP" << as_num(index) << ")\n";
             }
@@ -292,9 +616,14 @@ namespace snn::app
 
             phony_targets.append("clean-object-files");
             mk << "\nclean-object-files:\n";
-            for (const auto index : range::step<usize>{0, applications_.count()})
+            for (const auto index : range::step<usize>{0, target_count})
             {
                 mk << "\trm -f $(OBJ" << as_num(index) << ")\n";
+                if (time_trace_)
+                {
+                    // Also after a failed build (some objects were compiled).
+                    mk << "\trm -f $(OBJ" << as_num(index) << ":.o=.json)\n";
+                }
             }
 
             // Target: clean
@@ -319,7 +648,7 @@ namespace snn::app
 
                 phony_targets.append("run");
                 mk << "\nrun: all\n";
-                for (const auto index : range::step<usize>{0, applications_.count()})
+                for (const auto index : range::step<usize>{0, target_count})
                 {
                     mk << "\t./$(APP" << as_num(index) << ")\n";
                 }
@@ -336,12 +665,12 @@ namespace snn::app
                     mk << ' ' << makefile_depend;
                 }
                 mk << '\n';
-                for (const auto index : range::step<usize>{0, applications_.count()})
+                for (const auto index : range::step<usize>{0, target_count})
                 {
                     mk << "\trm -rf $(APP" << as_num(index) << ").corpus\n";
                 }
 
-                // Target: minimize-corpus
+                // Target: minimize-corpus (one sub-target per application, for `make -j`)
                 // Target: compress-corpus
                 // Target: run
 
@@ -352,7 +681,7 @@ namespace snn::app
 
                 str cd_dir_and;
 
-                for (const auto& app : applications_)
+                for (const auto [index, app] : applications_.range() | range::v::enumerate{})
                 {
                     const auto [dir, base, ext] = file::path::split<cstrview>(app).value();
 
@@ -362,8 +691,17 @@ namespace snn::app
                         cd_dir_and << "cd " << dir << " && ";
                     }
 
-                    // minimize-corpus
+                    const bool zstd =
+                        corpus_zstd_ || file::is_something(concat(dir, base, ".corpus.tar.zst"));
+                    const cstrview archive_ext = zstd ? ".corpus.tar.zst" : ".corpus.tar.gz";
+                    const cstrview compression = zstd ? "--zstd" : "-z";
+
+                    // minimize-corpus-N
 
+                    str minimize_target = "minimize-corpus-";
+                    minimize_target << as_num(index);
+
+                    minimize << '\n' << minimize_target << ": all\n";
                     minimize << "\t@test ! -e " << dir << base << ".corpus.old || \\\n"
                              << "\t\t(echo 'Error: Directory exists: " << dir << base
                              << ".corpus.old'; exit 1;)\n";
@@ -374,28 +712,31 @@ namespace snn::app
                              << ".corpus " << base << ".corpus.old\n";
                     minimize << "\trm -rf " << dir << base << ".corpus.old\n";
 
+                    phony_targets.append(std::move(minimize_target));
+
                     // compress-corpus
 
 #if defined(__FreeBSD__)
-                    constexpr cstrview tarcmd{"tar -cz --gid 0 --uid 0 -f "};
+                    constexpr cstrview owner{" --gid 0 --uid 0"};
 #elif defined(__linux__)
-                    constexpr cstrview tarcmd{"tar -cz --owner=0 --group=0 -f "};
+                    constexpr cstrview owner{" --owner=0 --group=0"};
 #else
-                    constexpr cstrview tarcmd{"tar -czf "};
+                    constexpr cstrview owner{""};
 #endif
 
-                    compress << "\trm -f " << dir << base << ".corpus.tar.gz\n";
-                    compress << '\t' << cd_dir_and << tarcmd << base << ".corpus.tar.gz " << base
-                             << ".corpus\n";
+                    compress << "\trm -f " << dir << base << archive_ext << '\n';
+                    compress << '\t' << cd_dir_and << "tar -c " << compression << owner << " -f "
+                             << base << archive_ext << ' ' << base << ".corpus\n";
                     compress << "\trm -rf " << dir << base << ".corpus\n";
 
                     // run
 
                     run << "\t@test -d " << dir << base << ".corpus || test ! -e " << dir << base
-                        << ".corpus.tar.gz || \\\n";
-                    run << "\t\t(echo '" << cd_dir_and << "tar -xzf " << base
-                        << ".corpus.tar.gz' && \\\n";
-                    run << "\t\t" << cd_dir_and << "tar -xzf " << base << ".corpus.tar.gz)\n";
+                        << archive_ext << " || \\\n";
+                    run << "\t\t(echo '" << cd_dir_and << "tar -x " << compression << " -f "
+                        << base << archive_ext << "' && \\\n";
+                    run << "\t\t" << cd_dir_and << "tar -x " << compression << " -f " << base
+                        << archive_ext << ")\n";
                     run << "\t@test -d " << dir << base << ".corpus || \\\n";
                     run << "\t\t(echo 'mkdir " << dir << base << ".corpus' && mkdir " << dir << base
                         << ".corpus)\n";
@@ -411,7 +752,12 @@ namespace snn::app
                 phony_targets.append("compress-corpus");
                 phony_targets.append("run");
 
-                mk << "\nminimize-corpus: all\n" << minimize;
+                mk << "\nminimize-corpus:";
+                for (const auto index : range::step<usize>{0, applications_.count()})
+                {
+                    mk << " minimize-corpus-" << as_num(index);
+                }
+                mk << '\n' << minimize;
                 mk << "\ncompress-corpus: minimize-corpus\n" << compress;
                 mk << "\nrun: all\n" << run;
             }
@@ -437,6 +783,16 @@ namespace snn::app
                 return false;
             }
 
+            stats::counters& counters = stats::global();
+            counters.makefile_bytes += mk.size();
+            counters.graph_files = dependencies_.count();
+            counters.graph_edges = 0;
+            for (const auto& p : dependencies_)
+            {
+                counters.graph_edges +=
+                    p.second.header_files.count() + p.second.source_files.count();
+            }
+
             if (makefile_depend)
             {
                 const strbuf dependency_list = dependency_list_();
@@ -483,11 +839,42 @@ namespace snn::app
             return false;
         }
 
+        // Link tests into bundles (see `bundle::group`), the driver sources must be written
+        // before building.
+        void set_bundles(vec<bundle::group> bundles) noexcept
+        {
+            bundles_ = std::move(bundles);
+        }
+
+        // Compress fuzz corpora with zstd (`.corpus.tar.zst`) instead of gzip. Targets that
+        // already have a `.corpus.tar.zst` archive use zstd regardless.
+        void set_corpus_zstd(const bool b) noexcept
+        {
+            corpus_zstd_ = b;
+        }
+
+        void set_coverage(const bool b) noexcept
+        {
+            coverage_ = b;
+        }
+
+        void set_frame_pointers(const bool b) noexcept
+        {
+            frame_pointers_ = b;
+        }
+
         void set_fuzz(const bool b) noexcept
         {
             fuzz_ = b;
         }
 
+        // Command prefix for compile and link commands to run each in a cgroup of its own (see
+        // `snn cgroup-exec`).
+        void set_isolator(str command) noexcept
+        {
+            isolator_ = std::move(command);
+        }
+
         void set_optimize(const bool b) noexcept
         {
             optimize_ = b;
@@ -503,6 +890,17 @@ namespace snn::app
             time_execution_ = b;
         }
 
+        void set_time_trace(const bool b) noexcept
+        {
+            time_trace_ = b;
+        }
+
+        // Command prefix for compile and link commands (see `snn timed`).
+        void set_timer(str command) noexcept
+        {
+            timer_ = std::move(command);
+        }
+
         void set_verbose_level(const u32 i) noexcept
         {
             verbose_level_ = i;
@@ -514,17 +912,22 @@ namespace snn::app
             set::unsorted<str> libraries;
             set::unsorted<str> source_files;
             set::unsorted<str> header_files;
+            set::sorted<str> flags; // Compile flags from `[#opt:...]` (source files only).
         };
 
         map::unsorted<str, dependencies> dependencies_;
         map::sorted<str, str> predefined_macros_;
+        map::sorted<str, annotations::test> test_annotations_;
 
         set::sorted<str> applications_;
 
+        vec<bundle::group> bundles_;
         vec<str> compiler_include_paths_;
 
         str config_file_;
         str include_path_;
+        str isolator_;
+        str timer_;
 
         cstrview compiler_;
         cstrview compiler_default_{"clang++"};
@@ -532,15 +935,21 @@ namespace snn::app
 
         u32 verbose_level_ = 0;
 
+        bool corpus_zstd_    = false;
+        bool coverage_       = false;
+        bool frame_pointers_ = false;
         bool fuzz_           = false;
         bool optimize_       = false;
         bool sanitize_       = false;
         bool time_execution_ = false;
+        bool time_trace_     = false;
 
         [[nodiscard]] bool ask_compiler_for_defaults_()
         {
             snn_should(compiler_);
 
+            const trace::scope span{"probe", compiler_};
+
             process::command cmd;
 
             cmd.append_command(compiler_, promise::is_valid);
@@ -684,6 +1093,8 @@ namespace snn::app
 
         [[nodiscard]] bool detect_include_path_(const cstrview file)
         {
+            const trace::scope span{"config", "detect include path"};
+
             if (file::path::is_absolute(file))
             {
                 return false;
@@ -696,7 +1107,7 @@ namespace snn::app
             include_path_ = "./";
 
             check << include_path_ << file;
-            if (file::is_regular(check))
+            if (is_regular_(check))
             {
                 return true;
             }
@@ -709,7 +1120,7 @@ namespace snn::app
             {
                 check.clear();
                 check << include_path_ << file;
-                if (file::is_regular(check))
+                if (is_regular_(check))
                 {
                     return true;
                 }
@@ -731,7 +1142,7 @@ namespace snn::app
 
                 if (validator::is_file_path(check))
                 {
-                    return file::is_regular(check);
+                    return is_regular_(check);
                 }
             }
 
@@ -740,6 +1151,8 @@ namespace snn::app
 
         [[nodiscard]] bool find_compiler_config_()
         {
+            const trace::scope span{"config", "find compiler config"};
+
             // Always include a directory separator in the path, even if the config file is in the
             // current directory, otherwise clang will look for the file elsewhere:
             // https://clang.llvm.org/docs/UsersManual.html#configuration-files
@@ -750,7 +1163,7 @@ namespace snn::app
 
             config_file_.clear();
             config_file_ << path << name;
-            if (file::is_regular(config_file_))
+            if (is_regular_(config_file_))
             {
                 return true;
             }
@@ -761,7 +1174,7 @@ namespace snn::app
             {
                 config_file_.clear();
                 config_file_ << path << name;
-                if (file::is_regular(config_file_))
+                if (is_regular_(config_file_))
                 {
                     return true;
                 }
@@ -774,8 +1187,117 @@ namespace snn::app
             return false;
         }
 
+        // Reverse index of the dependency graph, see `reverse_index_()`.
+        struct reverse_index
+        {
+            map::unsorted<str, vec<cstrview>> dependents; // File -> files that depend on it.
+            map::unsorted<str, cstrview> resolved;        // Real path -> file.
+        };
+
+        // With `with_sources`, a file also depends on the source files of the headers it includes
+        // (link dependencies), otherwise only on the included headers.
+        [[nodiscard]] reverse_index reverse_index_(const bool with_sources) const
+        {
+            reverse_index index;
+            auto& dependents = index.dependents;
+            auto& resolved   = index.resolved;
+            for (const auto& p : dependencies_)
+            {
+                const str& file = p.first;
+                for (const auto& header : p.second.header_files)
+                {
+                    dependents.insert_inplace(header).value().append(file.view());
+                }
+                if (with_sources)
+                {
+                    for (const auto& source : p.second.source_files)
+                    {
+                        dependents.insert_inplace(source).value().append(file.view());
+                    }
+                }
+
+                str real = real_path_(file);
+                if (real)
+                {
+                    resolved.insert(std::move(real), file.view());
+                }
+            }
+            return index;
+        }
+
+        // Files that depend on the changed files (including the changed files that are part of
+        // the dependency graph), see `reverse_index_()`.
+        [[nodiscard]] set::unsorted<cstrview> affected_(const vec<str>& changed,
+                                                        const bool with_sources) const
+        {
+            return affected_(reverse_index_(with_sources), changed);
+        }
+
+        [[nodiscard]] static set::unsorted<cstrview> affected_(const reverse_index& index,
+                                                               const vec<str>& changed)
+        {
+            vec<cstrview> pending;
+            set::unsorted<cstrview> affected;
+            for (const auto& path : changed)
+            {
+                if (const auto file = index.resolved.get(real_path_(path)))
+                {
+                    if (affected.insert(file.value()))
+                    {
+                        pending.append(file.value());
+                    }
+                }
+            }
+
+            for (usize i = 0; i < pending.count(); ++i)
+            {
+                if (const auto deps = index.dependents.get(pending.at(i, promise::within_bounds)))
+                {
+                    for (const cstrview dependent : deps.value())
+                    {
+                        if (affected.insert(dependent))
+                        {
+                            pending.append(dependent);
+                        }
+                    }
+                }
+            }
+
+            return affected;
+        }
+
+        // `file::is_regular()`, counted (see `stats::counters`).
+        [[nodiscard]] static bool is_regular_(const str& path)
+        {
+            ++stats::global().file_checks;
+            return file::is_regular(path);
+        }
+
+        // Absolute path without symbolic links, empty if the file doesn't exist. Counted (see
+        // `stats::counters`).
+        [[nodiscard]] static str real_path_(const str& path)
+        {
+            ++stats::global().file_checks;
+            char* const resolved = ::realpath(path.null_terminated().get(), nullptr);
+            if (resolved == nullptr)
+            {
+                return str{};
+            }
+            str real{cstrview{resolved, std::strlen(resolved)}};
+            std::free(resolved);
+            return real;
+        }
+
+        [[nodiscard]] bool has_object_flags_(const cstrview source_file) const
+        {
+            const auto deps = dependencies_.get(source_file);
+            return deps && !deps.value().flags.is_empty();
+        }
+
         [[nodiscard]] set::unsorted<cstrview> header_dependencies_(const str& file) const
         {
+            const stats::timer timer{stats::global().closure_ns, stats::global().closure_calls};
+
             set::unsorted<cstrview> dependencies;
             header_dependencies_recursive_(file, dependencies);
             return dependencies;
@@ -796,6 +1318,8 @@ namespace snn::app
 
         [[nodiscard]] set::unsorted<cstrview> library_dependencies_(const str& source_file) const
         {
+            const stats::timer timer{stats::global().closure_ns, stats::global().closure_calls};
+
             set::unsorted<cstrview> dependencies;
             set::unsorted<cstrview> handled; // In case there is a circular dependency.
             library_dependencies_recursive_(source_file, dependencies, handled);
@@ -857,26 +1381,64 @@ namespace snn::app
             return true;
         }
 
-        [[nodiscard]] bool parse_recursive_(const str& file, const u32 depth)
+        [[nodiscard]] static bool parse_options_(const cstrview line, set::sorted<str>& flags)
         {
-            constexpr u32 max_depth = 128; // Arbitrary (around 10 is normal for `snn-core`).
-            if (depth > max_depth) [[unlikely]] // Clang bug if unreachable code warning.
+            const usize pos = line.find('[').value_or_npos();
+            if (pos != constant::npos)
             {
-                fmt::print_error_line("Error: Maximum recursion depth ({}) exceeded", max_depth);
-                return false;
-            }
+                for (cstrview word : string::range::split{line.view(pos), ' '})
+                {
+                    if (word.has_front("[#opt:") && word.has_back(']'))
+                    {
+                        word.drop_front_n(string_size("[#opt:"));
+                        word.drop_back_n(string_size("]"));
 
-            auto ins_res = dependencies_.insert_inplace(file);
-            if (!ins_res.was_inserted())
-            {
-                // Already parsed.
-                return true;
-            }
+                        if (!validator::is_optimization(word))
+                        {
+                            fmt::print_error_line("Error: Invalid compile option: {}", word);
+                            return false;
+                        }
+
+                        if (word == "no-sanitize")
+                        {
+                            flags.insert("-fno-sanitize=all");
+                        }
+                        else
+                        {
+                            flags.insert(concat("-", word));
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool parse_recursive_(const str& file, const u32 depth)
+        {
+            constexpr u32 max_depth = 128; // Arbitrary (around 10 is normal for `snn-core`).
+            if (depth > max_depth) [[unlikely]] // Clang bug if unreachable code warning.
+            {
+                fmt::print_error_line("Error: Maximum recursion depth ({}) exceeded", max_depth);
+                return false;
+            }
+
+            auto ins_res = dependencies_.insert_inplace(file);
+            if (!ins_res.was_inserted())
+            {
+                // Already parsed.
+                return true;
+            }
             auto& deps = ins_res.value();
 
+            const trace::scope span{"scan", file};
+
             strbuf contents;
             if (file::read(file, contents) && contents)
             {
+                stats::counters& counters = stats::global();
+                ++counters.files_scanned;
+                counters.bytes_read += contents.size();
+
                 if (!utf8::is_valid(contents))
                 {
                     fmt::print_error("Warning: File does not pass UTF-8 validation:\n"
@@ -891,6 +1453,7 @@ namespace snn::app
                 {
                     ascii::trim_inplace(line);
 
+                    ++counters.preprocessor_lines;
                     const auto status = preprocessor.process(line);
                     if (status != preprocessor.compile)
                     {
@@ -913,6 +1476,26 @@ namespace snn::app
                         }
                     }
 
+                    if (depth == 0 && (line.has_front("//") || line.has_front("#include ")))
+                    {
+                        auto& annotated = test_annotations_.insert_inplace(file).value();
+                        if (!annotations::parse_test(line, annotated))
+                        {
+                            fmt::print_error_line("Error: Parsing failed while parsing: {}", file);
+                            return false;
+                        }
+                    }
+
+                    if (file.has_back(".cc") &&
+                        (line.has_front("//") || line.has_front("#include ")))
+                    {
+                        if (!parse_options_(line, deps.flags))
+                        {
+                            fmt::print_error_line("Error: Parsing failed while parsing: {}", file);
+                            return false;
+                        }
+                    }
+
                     if (line.has_front("#include \""))
                     {
                         if (!parse_libraries_(line, deps.libraries))
@@ -959,7 +1542,7 @@ namespace snn::app
                                 file_next.drop_back_n(string_size("hh"));
                                 file_next.append("cc");
                                 if (!deps.source_files.contains(file_next) &&
-                                    file::is_regular(file_next))
+                                    is_regular_(file_next))
                                 {
                                     deps.source_files.insert(file_next);
                                     if (!parse_recursive_(file_next, depth + 1))
@@ -1084,6 +1667,8 @@ namespace snn::app
 
         [[nodiscard]] set::unsorted<cstrview> source_dependencies_(const str& source_file) const
         {
+            const stats::timer timer{stats::global().closure_ns, stats::global().closure_calls};
+
             set::unsorted<cstrview> dependencies;
             dependencies.insert(source_file.view());
             set::unsorted<cstrview> handled; // In case there is a circular dependency.
@@ -1116,15 +1701,19 @@ namespace snn::app
 
     namespace
     {
-        int spawn(const str& path, vec<str> arguments)
+        // `environment` holds "NAME=value" strings that are added to the current environment.
+        int spawn(const str& path, const vec<str>& arguments, const vec<str>& environment,
+                  resources::usage& usage)
         {
-            auto spawn_res = process::spawner{path, std::move(arguments)}.spawn();
-            if (spawn_res)
+            app::child child;
+            const u64 start = clock::monotonic();
+            if (child.spawn(path, arguments, environment))
             {
-                const process::termination_status term = spawn_res.value().wait().value();
-                if (term.with_exit_status())
+                child.wait();
+                usage = resources::from_rusage(child.usage(), clock::monotonic() - start);
+                if (child.exited_normally())
                 {
-                    return term.exit_status();
+                    return child.exit_status();
                 }
                 else
                 {
@@ -1134,14 +1723,177 @@ namespace snn::app
             else
             {
                 fmt::print_error_line("Error: Failed to execute: {}", path);
-                fmt::print_error_line("Error: {}", spawn_res.error_code());
+                fmt::print_error_line("Error: errno {}", child.error_number());
+            }
+
+            return constant::exit::failure;
+        }
+
+        int spawn(const str& path, const vec<str>& arguments, const vec<str>& environment = {})
+        {
+            resources::usage usage;
+            return app::spawn(path, arguments, environment, usage);
+        }
+
+        // Parse the `--sort` column of `runall --resources`, prints an error if it is invalid.
+        [[nodiscard]] optional<resources::column> resources_column(const cstrview name)
+        {
+            const auto column = resources::parse_column(name);
+            if (!column)
+            {
+                fmt::print_error_line("Error: Invalid sort column: {}"
+                                      " (wall, cpu, rss, faults, switches or io)",
+                                      name);
+            }
+            return column;
+        }
+
+        // Parse a timeout in seconds (zero if `seconds` is empty), prints an error if it is
+        // invalid.
+        [[nodiscard]] optional<u64> timeout_ns(const cstrview seconds)
+        {
+            if (seconds.is_empty())
+            {
+                return u64{0};
+            }
+
+            const auto n = number::parse(seconds);
+            if (!n || n.value() == 0 || n.value() > 86'400)
+            {
+                fmt::print_error_line("Error: Invalid timeout (1-86400 seconds): {}", seconds);
+                return nullopt;
+            }
+            return n.value() * 1'000'000'000;
+        }
+
+        // Called before a timed out process is killed: print where it is stuck.
+        void report_timeout(const cstrview path, const pid_t pid, const u64 elapsed_ns)
+        {
+            fmt::print_error_line("Error: Timed out after {}: {} (pid {})",
+                                  report::duration(elapsed_ns), path, pid);
+
+            const strbuf dump = hang::stack_dump(pid);
+            if (dump)
+            {
+                file::standard::error{} << dump;
+            }
+            else
+            {
+                fmt::print_error_line("No stack dump (eu-stack or gdb not found or not allowed to"
+                                      " attach, see: /proc/sys/kernel/yama/ptrace_scope),"
+                                      " sending SIGABRT");
+                constexpr u64 grace_ns = 2'000'000'000;
+                hang::abort_and_wait(pid, grace_ns);
+            }
+        }
+
+        // Like `spawn` but the application (and its process group) is killed if it runs longer
+        // than `timeout_ns`.
+        int spawn_with_timeout(const str& path, const vec<str>& arguments,
+                               const vec<str>& environment, const u64 timeout_ns,
+                               resources::usage& usage)
+        {
+            vec<jobs::job> single;
+            single.append(jobs::job{path, arguments, environment, timeout_ns});
+
+            const auto results = jobs::run(
+                single, 1, 0, [](const usize, const jobs::result&) { return true; },
+                [&path](const usize, const pid_t pid, const u64 elapsed_ns) {
+                    app::report_timeout(path, pid, elapsed_ns);
+                });
+
+            const jobs::result& r = results.at(0, promise::within_bounds);
+            usage                 = r.usage;
+            if (r.error_number != 0)
+            {
+                fmt::print_error_line("Error: Failed to execute: {}", path);
+                fmt::print_error_line("Error: errno {}", r.error_number);
+            }
+            else if (r.exited_normally)
+            {
+                return r.exit_status;
+            }
+            else if (!r.timed_out)
+            {
+                fmt::print_error_line("Error: Exited abnormally: {}", path);
+            }
+
+            return constant::exit::failure;
+        }
+
+#if defined(__linux__)
+        int profile(const str& path, const vec<str>& arguments)
+        {
+            constexpr u64 frequency = 997; // Hz (not a multiple of common timer frequencies).
+            constexpr usize top     = 25;
+
+            profiler::sampler sampler;
+            if (!sampler.open(frequency))
+            {
+                fmt::print_error_line("Error: Failed to open perf event (errno {}), see:"
+                                      " /proc/sys/kernel/perf_event_paranoid",
+                                      sampler.error_number());
+                return constant::exit::failure;
+            }
+
+            profiler::profile prof{path};
+
+            app::child child;
+            const vec<str> environment;
+            if (!child.spawn(path, arguments, environment))
+            {
+                fmt::print_error_line("Error: Failed to execute: {}", path);
+                fmt::print_error_line("Error: errno {}", child.error_number());
+                return constant::exit::failure;
+            }
+
+            while (!child.try_wait())
+            {
+                sampler.poll(100); // Milliseconds
+                sampler.read(prof);
+            }
+            sampler.read(prof);
+            sampler.close();
+
+            if (!child.exited_normally())
+            {
+                fmt::print_error_line("Error: Exited abnormally: {}", path);
+            }
+
+            // Resolve while the executable still exists.
+            const auto folded = prof.resolve();
+
+            const str folded_path = concat(path, ".folded");
+            if (!file::write(folded_path, folded.folded()))
+            {
+                fmt::print_error_line("Error: Failed to write to: {}", folded_path);
+                return constant::exit::failure;
             }
 
+            strbuf out{container::reserve, 4 * constant::size::kibibyte<usize>};
+            fmt::format_append("Profile: {} samples ({} lost) at {} Hz\n", out,
+                               promise::no_overlap, prof.sample_count(), prof.lost(), frequency);
+            out << folded.top(top);
+            fmt::format_append("Folded stacks written to: {}\n", out, promise::no_overlap,
+                               folded_path);
+            file::standard::error{} << out;
+
+            return child.exit_status();
+        }
+#else
+        int profile(const str&, const vec<str>&)
+        {
+            // Unreachable, checked before building.
+            fmt::print_error_line("Error: Profiling is only supported on Linux");
             return constant::exit::failure;
         }
+#endif
 
         int make(const str& makefile, str target, const u32 verbose_level)
         {
+            const str span_name = concat("make ", target);
+            const trace::scope span{"make", span_name};
+
             if (verbose_level >= 2)
             {
                 fmt::print_error_line("make -f {} {}", makefile, target);
@@ -1157,256 +1909,4077 @@ namespace snn::app
             spawn_args.append(makefile);
             spawn_args.append(std::move(target));
 
-            return app::spawn("make", std::move(spawn_args));
+            return app::spawn("make", spawn_args);
         }
 
-        [[nodiscard]] str temporary_makefile_name()
+        [[nodiscard]] bool create_directory(const str& path)
         {
-            for (loop::count lc{10}; lc--;) // X tries.
+            if (::mkdir(path.null_terminated().get(), 0755) == 0 || errno == EEXIST)
             {
-                str name = "tmp-";
+                return true;
+            }
+            fmt::print_error_line("Error: Failed to create directory: {} (errno {})", path, errno);
+            return false;
+        }
 
-                const auto n                = random::number<u32>();
-                constexpr usize pad_to_size = sizeof(n) * 2;
-                name.append_integral<math::base::hex>(n, pad_to_size);
+        // Digest of the environment variables that can change the outcome of a test run.
+        [[nodiscard]] u64 environment_digest()
+        {
+            constexpr cstrview names[] = {
+                "ASAN_OPTIONS", "HOME", "LANG",   "LD_LIBRARY_PATH", "LD_PRELOAD",
+                "PATH",         "TZ",   "TMPDIR", "UBSAN_OPTIONS",
+            };
 
-                name.append(".mk");
+            vec<cstrview> variables;
+            for (char** e = environ; e != nullptr && *e != nullptr; ++e)
+            {
+                const cstrview var{*e, std::strlen(*e)};
+                const cstrview name = var.view(0, var.find('=').value_or(var.size()));
 
-                if (!file::is_something(name))
+                bool relevant = name.has_front("LC_") || name.has_front("SNN_");
+                for (const cstrview n : names)
                 {
-                    return name;
+                    relevant = relevant || name == n;
+                }
+
+                if (relevant)
+                {
+                    variables.append(var);
                 }
             }
+            algo::sort(variables.range()); // The order of `environ` is unspecified.
 
-            // This should never happen, u32 has over 4 billion unique values.
-            throw_or_abort("Failed to generate unique makefile name");
+            digest::fnv1a d;
+            for (const cstrview var : variables)
+            {
+                d.update_field(var);
+            }
+            return d.value();
         }
 
-        int build(const cstrview program_name, const array_view<const env::argument> arguments)
+        // Cache key for a test run: the executable content, the arguments and the environment.
+        [[nodiscard]] optional<u64> run_digest(const str& path, const vec<str>& arguments,
+                                               const u64 environment)
         {
-            env::options opts{arguments,
-                              {
-                                  {"compiler", 'c', env::option::takes_values},
-                                  {"define", 'd', env::option::takes_values},
-                                  {"optimize", 'o'},
-                                  {"sanitize", 's'},
-                                  {"time-execution", 't'},
-                                  {"verbose", 'v'},
-                              },
-                              promise::is_sorted};
-
-            if (!opts)
+            strbuf contents;
+            if (!file::read(path, contents))
             {
-                fmt::print_error_line("Error: {}.", opts.error_message());
-                return constant::exit::failure;
+                return nullopt;
             }
 
-            app::generator gen;
-
-            const auto args = opts.arguments();
-            if (args.count() >= 1)
+            digest::fnv1a d;
+            d.update_field(contents);
+            for (const auto& arg : arguments)
             {
-                const bool optimize       = opts.option('o').is_set();
-                const bool sanitize       = opts.option('s').is_set();
-                const bool time_execution = opts.option('t').is_set();
-                auto verbose_level        = opts.option('v').count();
+                d.update_field(arg);
+            }
 
-                if (time_execution)
-                {
-                    verbose_level = math::max(verbose_level, 1);
-                }
+            str env;
+            env.append_integral<math::base::hex>(environment, 16);
+            d.update_field(env);
 
-                gen.set_optimize(optimize);
-                gen.set_sanitize(sanitize);
-                gen.set_time_execution(time_execution);
-                gen.set_verbose_level(verbose_level);
+            return d.value();
+        }
 
-                // Makefile
+        // Run a git command and append each (non-empty) line of output, prefixed with `prefix`.
+        [[nodiscard]] bool git_lines(const cstrview arguments, const cstrview prefix,
+                                     const u32 verbose_level, vec<str>& lines)
+        {
+            process::command cmd;
+            cmd << "git " << arguments;
 
-                const str makefile = app::temporary_makefile_name();
+            if (verbose_level >= 2)
+            {
+                fmt::print_error_line("{}", cmd.to<cstrview>());
+            }
 
-                // Compiler & macros.
+            auto output = process::execute_and_consume_output(cmd);
+            if (!output)
+            {
+                return false;
+            }
 
-                const cstrview compiler = opts.option('c').values().back().value_or_default();
-                const cstrview macros   = opts.option('d').values().back().value_or_default();
-                if (!gen.setup_compiler_and_macros(compiler, macros))
+            while (const auto line = output.read_line<cstrview>())
+            {
+                cstrview name = line.value(promise::has_value);
+                ascii::trim_inplace(name);
+                if (name)
                 {
-                    return constant::exit::failure;
+                    lines.append(concat(prefix, name));
                 }
+            }
 
-                // Sources
-
-                for (const auto arg : args)
-                {
-                    if (!gen.add_application(arg.to<str>()))
-                    {
-                        return constant::exit::failure;
-                    }
-                }
+            return output.exit_status() == constant::exit::success;
+        }
 
-                if (gen.applications().is_empty())
-                {
-                    fmt::print_error_line("Error: No application source files to process");
-                    return constant::exit::failure;
-                }
+        // Files changed since a git revision: committed, staged, unstaged and untracked (not
+        // ignored), as absolute paths.
+        [[nodiscard]] bool git_changed_files(const cstrview revision, const u32 verbose_level,
+                                             vec<str>& changed)
+        {
+            vec<str> toplevel;
+            if (!app::git_lines("rev-parse --show-toplevel", "", verbose_level, toplevel) ||
+                toplevel.count() != 1)
+            {
+                fmt::print_error_line("Error: Not in a git repository");
+                return false;
+            }
+            const str prefix = concat(toplevel.front().value(), "/");
 
-                // Parse, generate & build.
+            // The revision is validated (it can't start with '-' or include shell characters).
+            if (!app::git_lines(concat("diff --name-only ", revision, " --"), prefix,
+                                verbose_level, changed))
+            {
+                fmt::print_error_line("Error: Failed to list files changed since: {}", revision);
+                return false;
+            }
 
-                if (gen.parse())
-                {
-                    const str makefile_depend; // Empty (don't generate).
+            if (!app::git_lines("ls-files --others --exclude-standard --full-name -- :/", prefix,
+                                verbose_level, changed))
+            {
+                fmt::print_error_line("Error: Failed to list untracked files");
+                return false;
+            }
 
-                    if (gen.generate(makefile, makefile_depend))
-                    {
-                        app::make(makefile, "clean", verbose_level);
+            return true;
+        }
 
-                        const int exit_status = app::make(makefile, "all", verbose_level);
+        [[nodiscard]] str temporary_file_name(const cstrview extension)
+        {
+            for (loop::count lc{10}; lc--;) // X tries.
+            {
+                str name = "tmp-";
 
-                        app::make(makefile, "clean-object-files", verbose_level);
+                const auto n                = random::number<u32>();
+                constexpr usize pad_to_size = sizeof(n) * 2;
+                name.append_integral<math::base::hex>(n, pad_to_size);
 
-                        if (verbose_level >= 3)
-                        {
-                            fmt::print_error_line("Deleting: {}", makefile);
-                        }
-                        file::remove(makefile).or_throw();
+                name.append(extension);
 
-                        return exit_status;
-                    }
+                if (!file::is_something(name))
+                {
+                    return name;
                 }
             }
-            else
-            {
-                strbuf usage{container::reserve, 600};
 
-                usage << "Usage: " << program_name << " build [options] [--] app.cc [...]\n";
+            // This should never happen, u32 has over 4 billion unique values.
+            throw_or_abort("Failed to generate unique file name");
+        }
 
-                usage << '\n';
+        [[nodiscard]] str current_directory()
+        {
+            char* const cwd = ::getcwd(nullptr, 0);
+            if (cwd == nullptr)
+            {
+                throw_or_abort("Failed to get the current directory");
+            }
+            str directory{cstrview{cwd, std::strlen(cwd)}};
+            std::free(cwd);
+            return directory;
+        }
 
-                usage << "Options:\n";
-                usage << "-o --optimize            Optimize (-O2)\n";
-                usage << "-t --time-execution      Time command execution (implies verbose)\n";
-                usage << "-s --sanitize            Enable sanitizers (Address & "
-                         "UndefinedBehavior)\n";
-                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
-                      << ")\n";
-                usage << "-d --define MACRO[,...]  Define macro(s)\n";
-                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+        // Path relative to the current directory made absolute, e.g. for `LD_PRELOAD` (resolved by
+        // the dynamic loader in the working directory of the application).
+        [[nodiscard]] str absolute_path(const str& path)
+        {
+            if (path.has_front('/'))
+            {
+                return path;
+            }
+            return concat(app::current_directory(), "/", path);
+        }
 
-                usage << '\n';
+        [[nodiscard]] str compile_times_file(const generator& gen)
+        {
+            return concat(gen.workspace_directory(), "/compile-times");
+        }
 
-                usage << "Verbosity levels:\n";
-                usage << "1. Show compile/run commands\n";
-                usage << "2. Show all commands\n";
-                usage << "3. Debug\n";
+        [[nodiscard]] str test_history_file(const generator& gen)
+        {
+            return concat(gen.workspace_directory(), "/test-history");
+        }
 
-                file::standard::error{} << usage;
+        [[nodiscard]] timings::keys timing_keys(const generator& gen)
+        {
+            return timings::keys{app::current_directory(),
+                                 concat(gen.workspace_directory(), "/..")};
+        }
+
+        // Read `timings::durations` or `timings::test_history`, an invalid file is ignored (with
+        // a warning).
+        template <typename Timings>
+        [[nodiscard]] Timings read_timings(const str& path)
+        {
+            Timings t;
+            strbuf contents;
+            if (file::read(path, contents) && !t.parse(contents))
+            {
+                fmt::print_error_line("Warning: Ignoring invalid timings: {}", path);
+                return Timings{};
             }
+            return t;
+        }
 
-            return constant::exit::failure;
+        [[nodiscard]] bool write_results(const cstrview path, const results::merged& r)
+        {
+            if (file::write(path, r.serialize()))
+            {
+                return true;
+            }
+            fmt::print_error_line("Error: Failed to write to: {}", path);
+            return false;
         }
 
-        int gen(const cstrview program_name, const array_view<const env::argument> arguments)
+        // Applications in a shard. The partition is balanced by the recorded compile, link and run
+        // times of each application (the average if nothing is recorded). All workers must use the
+        // same timing files (e.g. restored from a shared cache) to get the same partition, without
+        // any recorded times the applications are dealt out in name order.
+        [[nodiscard]] set::sorted<str> shard_applications(const generator& gen,
+                                                          const shard::spec spec)
         {
-            env::options opts{arguments,
-                              {
-                                  {"compiler", 'c', env::option::takes_values},
-                                  {"define", 'd', env::option::takes_values},
-                                  {"fuzz", 'z'},
-                                  {"makefile", 'f', env::option::takes_values},
-                                  {"optimize", 'o'},
-                                  {"sanitize", 's'},
-                                  {"time-execution", 't'},
-                                  {"verbose", 'v'},
-                              },
-                              promise::is_sorted};
+            const auto compile_times =
+                app::read_timings<timings::durations>(app::compile_times_file(gen));
+            const auto history =
+                app::read_timings<timings::test_history>(app::test_history_file(gen));
+            const auto keys = app::timing_keys(gen);
+
+            vec<shard::item> items{container::reserve, gen.applications().count()};
+            vec<usize> unknown;
+            u64 known_total = 0;
+            for (const auto& app : gen.applications())
+            {
+                const str executable = keys.key(app.view_offset(0, -3));
 
-            if (!opts)
+                u64 cost      = 0;
+                bool recorded = false;
+                const auto add = [&cost, &recorded](const optional<u64> duration) {
+                    if (duration)
+                    {
+                        cost += duration.value();
+                        recorded = true;
+                    }
+                };
+
+                for (const auto& source : gen.sources(app))
+                {
+                    add(compile_times.get(keys.key(concat(source.view_offset(0, -3), ".o"))));
+                }
+                add(compile_times.get(executable));
+                if (const auto run = history.get(executable))
+                {
+                    add(run.value().wall_ns);
+                }
+
+                if (recorded)
+                {
+                    known_total += cost;
+                }
+                else
+                {
+                    unknown.append(items.count());
+                }
+                items.append(shard::item{app.view(), cost});
+            }
+
+            const usize known = items.count() - unknown.count();
+            if (known > 0)
             {
-                fmt::print_error_line("Error: {}", opts.error_message());
-                return constant::exit::failure;
+                for (const usize index : unknown)
+                {
+                    items.at(index, promise::within_bounds).cost = known_total / known;
+                }
             }
 
-            app::generator gen;
+            const auto assigned = shard::partition(items, spec.count);
 
-            const auto args = opts.arguments();
-            if (args.count() >= 1)
+            set::sorted<str> selection;
+            for (const auto [index, item] : items.range() | range::v::enumerate{})
             {
-                const bool fuzz           = opts.option('z').is_set();
-                const bool optimize       = opts.option('o').is_set();
-                const bool sanitize       = opts.option('s').is_set();
-                const bool time_execution = opts.option('t').is_set();
-                auto verbose_level        = opts.option('v').count();
-
-                if (time_execution)
+                if (assigned.at(index, promise::within_bounds) == spec.index)
                 {
-                    verbose_level = math::max(verbose_level, 1);
+                    selection.insert(item.name);
                 }
+            }
+            return selection;
+        }
 
-                gen.set_fuzz(fuzz);
-                gen.set_optimize(optimize);
-                gen.set_sanitize(sanitize);
-                gen.set_time_execution(time_execution);
-                gen.set_verbose_level(verbose_level);
+        // True if a path can be used as is in a makefile recipe (no quoting needed).
+        [[nodiscard]] bool is_recipe_safe(const cstrview path) noexcept
+        {
+            auto rng = path.range();
+            rng.pop_front_while(
+                fn::is_any_of{chr::is_alphanumeric, fn::in_array{'/', '.', '_', '-', '+', ','}});
+            return rng.is_empty() && !path.is_empty();
+        }
 
-                // Makefile
+        // Time compile and link commands (see `timed`) if compile times are recorded or the command
+        // is traced (`--trace`). Compile times are only recorded in the workspace (for `impact` and
+        // `--shard`) if `SNN_COMPILE_TIMES` is set (not to "0"), as every compile and link command
+        // then runs through snn. The file is appended to by every build, compact it when most lines
+        // are superseded.
+        void record_compile_times(generator& gen, const cstrview program_name)
+        {
+            const char* const env = std::getenv("SNN_COMPILE_TIMES");
+            const bool record =
+                env != nullptr && env[0] != '\0' && cstrview{env, std::strlen(env)} != "0";
+            const bool trace = std::getenv("SNN_TRACE_EVENTS") != nullptr;
+            if (!record && !trace)
+            {
+                return;
+            }
 
-                str makefile;
+            str path{"-"}; // Don't record.
+            if (record)
+            {
+                path = app::compile_times_file(gen);
+            }
 
-                if (auto opt = opts.option('f'); opt.is_set())
+            for (const cstrview p : {program_name, path.view()})
+            {
+                if (!app::is_recipe_safe(p))
                 {
-                    makefile = opt.values().back().value_or_default();
+                    fmt::print_error_line("Warning: Not timing compiles (unsupported characters"
+                                          " in path): {}",
+                                          p);
+                    return;
                 }
-                else
+            }
+
+            if (record && app::create_directory(gen.workspace_directory()))
+            {
+                strbuf contents;
+                if (file::read(path, contents))
                 {
-                    makefile = "makefile";
+                    timings::durations times;
+                    bool rewrite = false;
+                    if (!times.parse(contents))
+                    {
+                        fmt::print_error_line("Warning: Discarding invalid compile times: {}",
+                                              path);
+                        times   = timings::durations{};
+                        rewrite = true;
+                    }
+
+                    if ((rewrite || times.needs_compaction()) &&
+                        !file::write(path, times.serialize()))
+                    {
+                        fmt::print_error_line("Warning: Failed to write compile times: {}", path);
+                        path = "-";
+                    }
                 }
+            }
+            else if (record)
+            {
+                path = "-";
+            }
 
-                if (!app::validator::is_file_path(makefile))
+            gen.set_timer(concat(program_name, " timed ", path));
+        }
+
+        // Create a scratch directory for an application (`--scratch`), returns the environment
+        // variables that point to it (none on failure).
+        [[nodiscard]] vec<str> create_scratch(const cstrview base, str& dir)
+        {
+            dir = scratch::create(base);
+            if (dir.is_empty())
+            {
+                fmt::print_error_line("Warning: Failed to create a scratch directory in: {}", base);
+                return {};
+            }
+            return scratch::environment(dir);
+        }
+
+        // Remove a scratch directory if the application passed, otherwise keep it for inspection.
+        void finish_scratch(const str& dir, const bool passed)
+        {
+            if (dir.is_empty())
+            {
+                return;
+            }
+
+            if (!passed)
+            {
+                fmt::print_error_line("Scratch directory kept: {}", dir);
+            }
+            else if (!scratch::remove(dir))
+            {
+                fmt::print_error_line("Warning: Failed to remove scratch directory: {}", dir);
+            }
+        }
+
+        // Set up `--cgroup` isolation, compile and link commands (and jobs created with
+        // `cgroups.create()`) run in cgroups of their own. Returns false if the limits are invalid,
+        // continues without cgroups (with a warning) if delegation is not available.
+        [[nodiscard]] bool setup_cgroups(generator& gen, cgroup::tree& cgroups,
+                                         const cstrview program_name, const cstrview spec)
+        {
+            const auto limits = cgroup::parse_limits(spec);
+            if (!limits)
+            {
+                fmt::print_error_line("Error: Invalid cgroup limits (e.g. memory=2G,cpu=150): {}",
+                                      spec);
+                return false;
+            }
+
+            if (const auto error = cgroups.setup(limits.value()))
+            {
+                fmt::print_error_line("Warning: Not using cgroups, {}", error.value());
+                fmt::print_error_line("Run in a delegated scope, e.g.:"
+                                      " systemd-run --user --scope -p Delegate=yes {} ...",
+                                      program_name);
+                return true;
+            }
+
+            gen.set_isolator(concat(program_name, " cgroup-exec ", spec));
+            return true;
+        }
+
+        // Run an application with the heap interposer (`library`) preloaded and print its report.
+        int spawn_with_heap_report(const str& path, const vec<str>& arguments, const str& library)
+        {
+            constexpr usize top = 10;
+
+            const str report_file = app::absolute_path(app::temporary_file_name(".heap"));
+
+            vec<str> environment{container::reserve, 2};
+            environment.append(concat("LD_PRELOAD=", app::absolute_path(library)));
+            environment.append(concat("SNN_HEAP_REPORT=", report_file));
+
+            const int exit_status = app::spawn(path, arguments, environment);
+
+            strbuf contents;
+            heap::report report;
+            if (file::read(report_file, contents) && report.parse(contents))
+            {
+                elf::symbolizer symbolizer;
+
+                strbuf out{container::reserve, 2 * constant::size::kibibyte<usize>};
+                fmt::format_append("Heap profile: {}\n", out, promise::no_overlap, path);
+                out << report.format(symbolizer, top);
+                file::standard::error{} << out;
+            }
+            else
+            {
+                fmt::print_error_line("Error: No heap report from: {}", path);
+            }
+
+            if (file::is_something(report_file))
+            {
+                file::remove(report_file).or_throw();
+            }
+
+            return exit_status;
+        }
+
+        // Run an application with the startup probe (`library`) preloaded (and with dynamic loader
+        // statistics on Linux) and print where the time between exec and exit was spent.
+        int spawn_with_startup_report(const str& path, const vec<str>& arguments,
+                                      const str& library, const set::sorted<str>& libraries)
+        {
+            // Absolute, the application may change directory.
+            const str report_file   = app::absolute_path(app::temporary_file_name(".startup"));
+            const str loader_prefix = app::absolute_path(app::temporary_file_name(".ld"));
+
+            vec<str> environment{container::reserve, 4};
+            environment.append(concat("LD_PRELOAD=", app::absolute_path(library)));
+            environment.append(concat("SNN_STARTUP_REPORT=", report_file));
+#if defined(__linux__)
+            environment.append("LD_DEBUG=statistics");
+            environment.append(concat("LD_DEBUG_OUTPUT=", loader_prefix));
+#endif
+
+            app::child child;
+            const u64 spawn_ns = clock::monotonic();
+            if (!child.spawn(path, arguments, environment))
+            {
+                fmt::print_error_line("Error: Failed to execute: {}", path);
+                fmt::print_error_line("Error: errno {}", child.error_number());
+                return constant::exit::failure;
+            }
+            const pid_t pid = child.pid();
+            child.wait();
+            const u64 end_ns = clock::monotonic();
+
+            if (!child.exited_normally())
+            {
+                fmt::print_error_line("Error: Exited abnormally: {}", path);
+            }
+
+            // No probe report if `LD_PRELOAD` was ignored (e.g. statically linked).
+            strbuf contents;
+            startup::report report;
+            if (file::read(report_file, contents) && !report.parse_probe(contents))
+            {
+                fmt::print_error_line("Error: Invalid startup report from: {}", path);
+            }
+
+            // The loader appends the process id to the output file name.
+            str loader_file = concat(loader_prefix, ".");
+            loader_file << as_num(pid);
+            strbuf loader_contents;
+            if (file::read(loader_file, loader_contents))
+            {
+                report.parse_loader_statistics(loader_contents);
+            }
+            if (file::is_something(loader_file))
+            {
+                file::remove(loader_file).or_throw();
+            }
+
+            strbuf out{container::reserve, constant::size::kibibyte<usize>};
+            fmt::format_append("Startup profile: {}\n", out, promise::no_overlap, path);
+            out << report.format(spawn_ns, end_ns, libraries);
+            file::standard::error{} << out;
+
+            if (file::is_something(report_file))
+            {
+                file::remove(report_file).or_throw();
+            }
+
+            return child.exit_status();
+        }
+
+        // Size breakdown of a built application (the object files must still exist). Strong
+        // symbols are attributed to the source file whose object file defines them (local symbols
+        // by their name and `STT_FILE` symbol, as several translation units can define the same
+        // local name), weak symbols (inline functions and template instantiations) to the header
+        // guessed from their name.
+        [[nodiscard]] bool size_breakdown(const str& executable, const set::sorted<str>& sources,
+                                          const set::sorted<str>& headers,
+                                          size::breakdown& breakdown)
+        {
+            struct weak_definitions
+            {
+                u64 count = 0;
+                u64 size  = 0;
+            };
+
+            map::unsorted<str, str> origins;            // Mangled name -> source file.
+            map::unsorted<str, str> locals;             // File and mangled name -> source file.
+            map::unsorted<str, weak_definitions> weaks; // Mangled name -> definitions.
+
+            for (const auto& source : sources)
+            {
+                const str object = concat(source.view_offset(0, -3), ".o");
+
+                elf::file obj;
+                if (!obj.load(object))
                 {
-                    fmt::print_error_line("Error: Invalid makefile name: {}", makefile);
-                    return constant::exit::failure;
+                    fmt::print_error_line("Error: Failed to read object file: {}", object);
+                    return false;
                 }
 
-                if (file::is_something(makefile))
+                for (const auto& sym : obj.symbols())
                 {
-                    fmt::print_error_line("Error: Makefile already exists: {}", makefile);
-                    return constant::exit::failure;
+                    if (sym.binding == STB_WEAK)
+                    {
+                        auto res = weaks.insert_inplace(sym.name);
+                        ++res.value().count;
+                        res.value().size += sym.size;
+                    }
+                    else if (sym.binding == STB_LOCAL)
+                    {
+                        locals.insert(concat(sym.file, "\t", sym.name), source);
+                    }
+                    else
+                    {
+                        origins.insert(sym.name, source);
+                    }
                 }
+            }
 
-                // Compiler & macros.
+            elf::file exe;
+            if (!exe.load(executable))
+            {
+                fmt::print_error_line("Error: Failed to read executable: {}", executable);
+                return false;
+            }
 
-                const cstrview compiler = opts.option('c').values().back().value_or_default();
-                const cstrview macros   = opts.option('d').values().back().value_or_default();
-                if (!gen.setup_compiler_and_macros(compiler, macros))
+            for (const auto& sec : exe.sections())
+            {
+                if ((sec.flags & SHF_ALLOC) != 0 && sec.size > 0)
                 {
-                    return constant::exit::failure;
+                    breakdown.add_section(sec.name, sec.size);
                 }
+            }
 
-                // Sources
+            u64 discarded = 0; // Duplicate weak definitions dropped by the linker.
+            for (const auto& sym : exe.symbols())
+            {
+                if (sym.size == 0)
+                {
+                    continue;
+                }
 
-                for (const auto arg : args)
+                str name = elf::demangle(sym.name);
+                str origin;
+                if (sym.binding == STB_LOCAL)
                 {
-                    if (!gen.add_application(arg.to<str>()))
+                    const auto l = locals.get(concat(sym.file, "\t", sym.name));
+                    origin       = l ? l.value() : str{size::origin_other};
+                }
+                else if (const auto o = origins.get(sym.name))
+                {
+                    origin = o.value();
+                }
+                else if (const auto w = weaks.get(sym.name))
+                {
+                    const auto& defs = w.value();
+                    if (defs.size > sym.size)
                     {
-                        return constant::exit::failure;
+                        discarded += defs.size - sym.size;
                     }
+
+                    const cstrview header = size::header_for(size::without_arguments(name),
+                                                             headers);
+                    origin = header.is_empty() ? size::origin_inline : header;
+                }
+                else
+                {
+                    origin = size::origin_other;
+                }
+
+                breakdown.add_symbol(std::move(name), std::move(origin), sym.size);
+            }
+
+            if (discarded > 0)
+            {
+                fmt::print_error_line("Inline/template code compiled more than once (discarded by"
+                                      " the linker): {}",
+                                      report::bytes(discarded));
+            }
+
+            return true;
+        }
+
+        // Run all (built) applications in parallel, each with its own raw profile, merge the
+        // profiles and print line/region coverage for the files in the dependency graph.
+        int cover_applications(const generator& gen, const usize concurrency, const cstrview html,
+                               const u32 verbose_level)
+        {
+            const str prefix        = app::temporary_file_name("");
+            const str profdata      = concat(prefix, ".profdata");
+            const str profdata_tool = coverage::llvm_tool(gen.compiler(), "llvm-profdata");
+            const str cov_tool      = coverage::llvm_tool(gen.compiler(), "llvm-cov");
+
+            vec<jobs::job> all_jobs{container::reserve, gen.applications().count()};
+            vec<str> executables{container::reserve, gen.applications().count()};
+            vec<str> profiles{container::reserve, gen.applications().count()};
+            set::sorted<str> files;
+
+            for (const auto [index, source] : gen.applications().range() | range::v::enumerate{})
+            {
+                str profile = concat(prefix, "-");
+                profile << as_num(index) << ".profraw";
+
+                jobs::job j;
+                j.path = concat("./", source.view_offset(0, -3)); // Drop ".cc".
+                j.environment.append(concat("LLVM_PROFILE_FILE=", profile));
+
+                executables.append(j.path);
+                profiles.append(std::move(profile));
+                all_jobs.append(std::move(j));
+
+                for (const auto& f : gen.sources(source))
+                {
+                    files.insert(f);
+                }
+                for (const auto& f : gen.headers(source))
+                {
+                    files.insert(f);
+                }
+            }
+
+            int exit_status = constant::exit::success;
+
+            jobs::run(all_jobs, concurrency, [&](const usize index, const jobs::result& r) {
+                const str& path = all_jobs.at(index, promise::within_bounds).path;
+                if (r.error_number != 0)
+                {
+                    fmt::print_error_line("Error: Failed to execute: {} (errno {})", path,
+                                          r.error_number);
+                    exit_status = constant::exit::failure;
+                }
+                else if (r.exit_status != constant::exit::success)
+                {
+                    fmt::print_error_line("Error: Failed: {}", path);
+                    exit_status = constant::exit::failure;
                 }
+                else if (verbose_level >= 1)
+                {
+                    fmt::print_error_line("{} ({})", path, report::duration(r.usage.wall_ns));
+                }
+                return true;
+            });
+
+            // Merge (profiles of applications that crashed may be missing).
+
+            vec<str> merge_args{container::reserve, profiles.count() + 4};
+            merge_args.append("merge");
+            merge_args.append("-sparse");
+            merge_args.append("-o");
+            merge_args.append(profdata);
+            for (const auto& profile : profiles)
+            {
+                if (file::is_something(profile))
+                {
+                    merge_args.append(profile);
+                }
+            }
+
+            if (verbose_level >= 2)
+            {
+                fmt::print_error_line("{} merge ... -o {}", profdata_tool, profdata);
+            }
+
+            bool reported = false;
+            if (merge_args.count() > 4 &&
+                app::spawn(profdata_tool, merge_args) == constant::exit::success)
+            {
+                // Export a summary as JSON.
+
+                process::command cmd;
+                cmd.append_command(cov_tool, promise::is_valid);
+                cmd << " export -summary-only -instr-profile=";
+                cmd.append_command(profdata, promise::is_valid);
+                for (const auto [i, executable] : executables.range() | range::v::enumerate{})
+                {
+                    if (i > 0)
+                    {
+                        cmd << " -object";
+                    }
+                    cmd << ' ';
+                    cmd.append_command(executable, promise::is_valid);
+                }
+
+                if (verbose_level >= 2)
+                {
+                    fmt::print_error_line("{}", cmd.to<cstrview>());
+                }
+
+                strbuf json{container::reserve, 64 * constant::size::kibibyte<usize>};
+                auto output = process::execute_and_consume_output(cmd);
+                if (output)
+                {
+                    while (const auto line = output.read_line<cstrview>())
+                    {
+                        json << line.value(promise::has_value);
+                    }
+
+                    coverage::summary summary;
+                    if (output.exit_status() == constant::exit::success &&
+                        summary.parse_export(json, files, app::current_directory()))
+                    {
+                        file::standard::out{} << summary.format();
+                        reported = true;
+                    }
+                }
+
+                if (reported && html)
+                {
+                    vec<str> show_args{container::reserve, executables.count() * 2 + 4};
+                    show_args.append("show");
+                    show_args.append("-format=html");
+                    show_args.append(concat("-output-dir=", html));
+                    show_args.append(concat("-instr-profile=", profdata));
+                    for (const auto [i, executable] : executables.range() | range::v::enumerate{})
+                    {
+                        if (i > 0)
+                        {
+                            show_args.append("-object");
+                        }
+                        show_args.append(executable);
+                    }
+
+                    if (app::spawn(cov_tool, show_args) == constant::exit::success)
+                    {
+                        fmt::print_error_line("HTML report written to: {}", html);
+                    }
+                    else
+                    {
+                        fmt::print_error_line("Error: Failed to write HTML report to: {}", html);
+                        exit_status = constant::exit::failure;
+                    }
+                }
+            }
+
+            if (!reported)
+            {
+                fmt::print_error_line("Error: Failed to create coverage report (with {} and {})",
+                                      profdata_tool, cov_tool);
+                exit_status = constant::exit::failure;
+            }
+
+            for (const auto& profile : profiles)
+            {
+                if (file::is_something(profile))
+                {
+                    file::remove(profile).or_throw();
+                }
+            }
+            if (file::is_something(profdata))
+            {
+                file::remove(profdata).or_throw();
+            }
+
+            return exit_status;
+        }
+
+        // A libFuzzer target (built with `gen --fuzz`) and its corpus.
+        struct fuzz_target final
+        {
+            str name;       // E.g. "base64"
+            str executable; // E.g. "dir/base64" or "./base64"
+            str directory;  // E.g. "dir/", empty for the current directory.
+            str corpus;     // E.g. "dir/base64.corpus/"
+        };
+
+        [[nodiscard]] vec<fuzz_target> fuzz_targets(const generator& gen)
+        {
+            vec<fuzz_target> targets{container::reserve, gen.applications().count()};
+            for (const auto& source : gen.applications())
+            {
+                const auto [dir, base, ext] = file::path::split<cstrview>(source).value();
+
+                fuzz_target t;
+                t.name       = str{base};
+                t.executable = dir ? concat(dir, base) : concat("./", base);
+                t.directory  = str{dir};
+                t.corpus     = concat(source.view_offset(0, -3), ".corpus/");
+                targets.append(std::move(t));
+            }
+            return targets;
+        }
+
+        [[nodiscard]] str corpus_digests_file(const generator& gen)
+        {
+            return concat(gen.workspace_directory(), "/corpus-digests");
+        }
+
+        // Extract the corpus of a fuzz target from its archive (`name.corpus.tar.zst` or
+        // `name.corpus.tar.gz`) unless the corpus directory was extracted from an archive with the
+        // same content (by `digests`, which is updated), without an archive an empty corpus
+        // directory is created.
+        [[nodiscard]] bool prepare_corpus(const fuzz_target& t, const timings::keys& keys,
+                                          timings::durations& digests, const u32 verbose_level)
+        {
+            str archive          = concat(t.directory, t.name, ".corpus.tar.zst");
+            cstrview compression = "--zstd";
+            if (!file::is_something(archive))
+            {
+                archive     = concat(t.directory, t.name, ".corpus.tar.gz");
+                compression = "-z";
+            }
+
+            const bool has_corpus = file::is_something(t.corpus);
+
+            strbuf contents;
+            if (!file::read(archive, contents))
+            {
+                return has_corpus || app::create_directory(t.corpus);
+            }
+
+            digest::fnv1a d;
+            d.update(contents);
+
+            const str key = keys.key(archive);
+            if (has_corpus && digests.get(key).value_or(0) == d.value())
+            {
+                return true;
+            }
+
+            vec<str> tar_args{container::reserve, 6};
+            tar_args.append("-x");
+            tar_args.append(str{compression});
+            tar_args.append("-f");
+            tar_args.append(archive);
+            tar_args.append("-C");
+            tar_args.append(t.directory ? t.directory : str{"."});
+
+            if (verbose_level >= 1)
+            {
+                fmt::print_error_line("tar -x {} -f {} -C {}", compression, archive,
+                                      tar_args.back().value());
+            }
+
+            if (app::spawn("tar", tar_args) != constant::exit::success)
+            {
+                return false;
+            }
+
+            digests.add(key, d.value());
+            return true;
+        }
+
+        // Minimize the corpus of each target (`-merge=1`), all targets in parallel (one merge
+        // process per core). The inputs of a corpus are moved to `name.corpus.old/` and merged
+        // back, a corpus is restored if its merge fails. All corpora are checked before any of
+        // them is moved, and the moved corpora are restored if one of them can't be moved.
+        int minimize_corpora(const vec<fuzz_target>& targets, const usize cores,
+                             const u32 verbose_level)
+        {
+            // Restore a corpus from `name.corpus.old/` (the directory may have merged inputs).
+            const auto restore = [](const str& dir, const str& old) {
+                if (file::is_something(dir) && !scratch::remove(dir))
+                {
+                    return false;
+                }
+                return ::rename(old.null_terminated().get(), dir.null_terminated().get()) == 0;
+            };
+
+            vec<str> directories{container::reserve, targets.count()};
+            vec<usize> input_counts{container::reserve, targets.count()};
+            for (const auto& t : targets)
+            {
+                const str dir{t.corpus.view_offset(0, -1)}; // Without the trailing slash.
+                const str old = concat(dir, ".old");
+
+                const auto inputs = fuzz::corpus_inputs(t.corpus);
+                if (!inputs)
+                {
+                    fmt::print_error_line("Error: Failed to read corpus: {}", t.corpus);
+                    return constant::exit::failure;
+                }
+
+                if (file::is_something(old))
+                {
+                    fmt::print_error_line("Error: Directory exists: {}", old);
+                    return constant::exit::failure;
+                }
+
+                directories.append(dir);
+                input_counts.append(inputs.value().count());
+            }
+
+            for (usize i = 0; i < directories.count(); ++i)
+            {
+                const str& dir = directories.at(i, promise::within_bounds);
+                const str old  = concat(dir, ".old");
+
+                if (::rename(dir.null_terminated().get(), old.null_terminated().get()) == 0 &&
+                    app::create_directory(dir))
+                {
+                    continue;
+                }
+
+                fmt::print_error_line("Error: Failed to move corpus: {}", dir);
+
+                // Roll back, including this corpus if it was moved.
+                const usize moved = file::is_something(old) ? i + 1 : i;
+                for (usize k = 0; k < moved; ++k)
+                {
+                    const str& d = directories.at(k, promise::within_bounds);
+                    if (!restore(d, concat(d, ".old")))
+                    {
+                        fmt::print_error_line("Error: Failed to restore corpus: {}.old", d);
+                    }
+                }
+                return constant::exit::failure;
+            }
+
+            vec<jobs::job> merge_jobs{container::reserve, targets.count()};
+            for (usize i = 0; i < targets.count(); ++i)
+            {
+                const fuzz_target& t = targets.at(i, promise::within_bounds);
+                const str old        = concat(directories.at(i, promise::within_bounds), ".old");
+
+                jobs::job j;
+                j.path = t.executable;
+                j.arguments.append("-merge=1");
+                j.arguments.append("-rss_limit_mb=3072");
+                j.arguments.append("-timeout=5");
+                if (t.directory)
+                {
+                    j.arguments.append(concat("-artifact_prefix=", t.directory));
+                }
+                j.arguments.append(t.corpus);
+                j.arguments.append(concat(old, "/"));
+
+                if (verbose_level >= 1)
+                {
+                    fmt::print_error_line("{} -merge=1 {} {}/", t.executable, t.corpus, old);
+                }
+
+                merge_jobs.append(std::move(j));
+            }
+
+            vec<strbuf> output{container::reserve, merge_jobs.count()};
+            for (usize i = 0; i < merge_jobs.count(); ++i)
+            {
+                output.append(strbuf{});
+            }
+
+            bool failed     = false;
+            const u64 start = clock::monotonic();
+
+            constexpr int tick_ms = 1000;
+            app::run_captured(
+                merge_jobs, cores, tick_ms,
+                [&](const usize index, const cstrview line) {
+                    // Only shown if the merge fails.
+                    output.at(index, promise::within_bounds) << line << '\n';
+                },
+                [&](const usize index, const int exit_status, const int error_number) {
+                    const fuzz_target& t = targets.at(index, promise::within_bounds);
+                    const str& dir       = directories.at(index, promise::within_bounds);
+                    const str old        = concat(dir, ".old");
+
+                    if (error_number == 0 && exit_status == constant::exit::success)
+                    {
+                        const auto inputs = fuzz::corpus_inputs(t.corpus);
+                        fmt::print_error_line(
+                            "Minimized {}: {} -> {} inputs", t.name,
+                            input_counts.at(index, promise::within_bounds),
+                            inputs ? inputs.value().count() : usize{0});
+                        if (!scratch::remove(old))
+                        {
+                            fmt::print_error_line("Warning: Failed to remove: {}", old);
+                        }
+                        return true;
+                    }
+
+                    if (error_number != 0)
+                    {
+                        fmt::print_error_line("Error: Failed to execute: {} (errno {})",
+                                              t.executable, error_number);
+                    }
+                    else
+                    {
+                        file::standard::error{} << output.at(index, promise::within_bounds);
+                        fmt::print_error_line("Error: Failed: {} (exit status {})", t.executable,
+                                              exit_status);
+                    }
+
+                    if (!restore(dir, old))
+                    {
+                        fmt::print_error_line("Error: Failed to restore corpus: {}", old);
+                    }
+
+                    failed = true;
+                    return true; // The other corpora are already moved, merge them too.
+                },
+                [] {});
+
+            if (verbose_level >= 1)
+            {
+                fmt::print_error_line("Minimized {} corpora in {}", merge_jobs.count(),
+                                      report::duration(clock::monotonic() - start));
+            }
+
+            return failed ? constant::exit::failure : constant::exit::success;
+        }
+
+        [[nodiscard]] usize terminal_columns() noexcept
+        {
+            winsize ws{};
+            if (::ioctl(STDERR_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0)
+            {
+                return ws.ws_col;
+            }
+            return 80;
+        }
+
+        // Run fuzz targets, at most `concurrency` at the same time, target `i` with `workers[i]`
+        // workers (see `fuzz::arguments()`). Progress lines are combined into one status line
+        // (redrawn in place on a terminal, otherwise printed every minute), everything else is
+        // printed prefixed with the name of the target. `outcomes` gets the first and last progress
+        // of each target. Returns false if a target failed (e.g. found a crash).
+        [[nodiscard]] bool fuzz_campaign(const vec<fuzz_target>& targets,
+                                         const vec<usize>& workers, const usize concurrency,
+                                         const u64 max_total_time, vec<fuzz::outcome>& outcomes,
+                                         const u32 verbose_level)
+        {
+            const bool interactive       = ::isatty(STDERR_FILENO) == 1;
+            const u64 status_interval_ns = interactive ? 1'000'000'000 : 60'000'000'000;
+
+            outcomes.clear();
+            vec<bool> finished{container::reserve, targets.count()};
+            vec<jobs::job> all_jobs{container::reserve, targets.count()};
+            for (usize i = 0; i < targets.count(); ++i)
+            {
+                const fuzz_target& t = targets.at(i, promise::within_bounds);
+                const usize n        = workers.at(i, promise::within_bounds);
+
+                jobs::job j;
+                j.path      = t.executable;
+                j.arguments = fuzz::arguments(t.corpus, n, max_total_time, t.directory);
+                all_jobs.append(std::move(j));
+
+                outcomes.append(fuzz::outcome{});
+                finished.append(false);
+            }
+
+            bool success      = true;
+            bool status_shown = false;
+            u64 last_status   = clock::monotonic();
+
+            const auto clear_status = [&] {
+                if (status_shown)
+                {
+                    file::standard::error{} << "\r\033[K";
+                    status_shown = false;
+                }
+            };
+
+            const auto print_status = [&] {
+                str line;
+                for (usize i = 0; i < targets.count(); ++i)
+                {
+                    const fuzz::outcome& o = outcomes.at(i, promise::within_bounds);
+                    if (!finished.at(i, promise::within_bounds) && o.last.executions > 0)
+                    {
+                        if (line)
+                        {
+                            line << " | ";
+                        }
+                        line << fuzz::status(targets.at(i, promise::within_bounds).name, o.last);
+                    }
+                }
+
+                if (line.is_empty())
+                {
+                    return;
+                }
+
+                if (interactive)
+                {
+                    const usize columns = app::terminal_columns();
+                    if (line.size() >= columns)
+                    {
+                        line.truncate(columns - 1);
+                    }
+                    file::standard::error{} << "\r\033[K" << line;
+                    status_shown = true;
+                }
+                else
+                {
+                    fmt::print_error_line("{}", line);
+                }
+            };
+
+            if (verbose_level >= 1)
+            {
+                for (const auto& j : all_jobs)
+                {
+                    str command{j.path};
+                    for (const auto& arg : j.arguments)
+                    {
+                        command << ' ' << arg;
+                    }
+                    fmt::print_error_line("{}", command);
+                }
+            }
+
+            constexpr int tick_ms = 250;
+            app::run_captured(
+                all_jobs, concurrency, tick_ms,
+                [&](const usize index, const cstrview line) {
+                    fuzz::outcome& o = outcomes.at(index, promise::within_bounds);
+                    if (const auto p = fuzz::parse_progress(line))
+                    {
+                        if (o.first.executions == 0)
+                        {
+                            o.first = p.value();
+                        }
+                        o.last = p.value();
+                    }
+                    else if (line)
+                    {
+                        clear_status();
+                        const fuzz_target& t = targets.at(index, promise::within_bounds);
+                        fmt::print_error_line("{}: {}", t.name, line);
+                    }
+                },
+                [&](const usize index, const int exit_status, const int error_number) {
+                    const str& path = all_jobs.at(index, promise::within_bounds).path;
+                    finished.at(index, promise::within_bounds) = true;
+                    if (error_number != 0)
+                    {
+                        clear_status();
+                        fmt::print_error_line("Error: Failed to execute: {} (errno {})", path,
+                                              error_number);
+                    }
+                    else if (exit_status != constant::exit::success)
+                    {
+                        clear_status();
+                        fmt::print_error_line("Error: Failed: {} (exit status {})", path,
+                                              exit_status);
+                    }
+                    else
+                    {
+                        return true;
+                    }
+                    outcomes.at(index, promise::within_bounds).failed = true;
+                    success                                           = false;
+                    return true;
+                },
+                [&] {
+                    const u64 now = clock::monotonic();
+                    if (now - last_status >= status_interval_ns)
+                    {
+                        print_status();
+                        last_status = now;
+                    }
+                });
+
+            clear_status();
+
+            return success;
+        }
+
+        // Split the cores: all targets run at the same time if there are enough cores, otherwise
+        // one core per target and as many targets as there are cores. With `fixed_workers` each
+        // target gets that many. Returns the number of targets to run at the same time.
+        usize split_fuzz_cores(const usize cores, const usize fixed_workers, const usize count,
+                               vec<usize>& workers)
+        {
+            workers.clear();
+            if (fixed_workers > 0)
+            {
+                for (usize i = 0; i < count; ++i)
+                {
+                    workers.append(fixed_workers);
+                }
+                return math::max(usize{1}, cores / fixed_workers);
+            }
+
+            workers = fuzz::split_cores(cores, count);
+            return math::max(usize{1}, math::min(cores, count));
+        }
+
+        [[nodiscard]] str fuzz_history_file(const generator& gen)
+        {
+            return concat(gen.workspace_directory(), "/fuzz-history");
+        }
+
+        [[nodiscard]] str fuzz_throughput_file(const generator& gen)
+        {
+            return concat(gen.workspace_directory(), "/fuzz-throughput");
+        }
+
+        // Abbreviated hash of the checked out commit, "-" outside of a git repository.
+        [[nodiscard]] str current_commit(const u32 verbose_level)
+        {
+            vec<str> lines;
+            if (app::git_lines("rev-parse --short=12 HEAD", "", verbose_level, lines) &&
+                !lines.is_empty())
+            {
+                return lines.at(0, promise::within_bounds);
+            }
+            return str{"-"};
+        }
+
+        // Add a sample (see `fuzz::throughput`) for each target that ran without failing.
+        void record_throughput(const generator& gen, const cstrview commit,
+                               const vec<fuzz_target>& targets, const vec<usize>& workers,
+                               const vec<fuzz::outcome>& outcomes)
+        {
+            const timings::keys keys = app::timing_keys(gen);
+            const str path           = app::fuzz_throughput_file(gen);
+            auto throughput          = app::read_timings<fuzz::throughput>(path);
+
+            const auto now = static_cast<u64>(std::time(nullptr));
+            for (usize i = 0; i < targets.count(); ++i)
+            {
+                const fuzz::outcome& o = outcomes.at(i, promise::within_bounds);
+                if (o.failed || o.last.execs_per_second == 0)
+                {
+                    continue;
+                }
+
+                fuzz::throughput::sample s;
+                s.time             = now;
+                s.commit           = str{commit};
+                s.workers          = workers.at(i, promise::within_bounds);
+                s.execs_per_second = o.last.execs_per_second;
+                s.coverage         = o.last.coverage;
+                s.features         = o.last.features;
+                s.rss              = o.last.rss;
+                throughput.add(keys.key(targets.at(i, promise::within_bounds).executable),
+                               std::move(s));
+            }
+
+            if (throughput.is_modified() &&
+                (!app::create_directory(gen.workspace_directory()) ||
+                 !file::write(path, throughput.serialize())))
+            {
+                fmt::print_error_line("Warning: Failed to write fuzz throughput: {}", path);
+            }
+        }
+
+        // Throughput trends of the targets (see `fuzz::analyze()`), fails if a target has
+        // regressed.
+        int fuzz_report(const generator& gen, const vec<fuzz_target>& targets)
+        {
+            constexpr u64 regression_percent = 20;
+            constexpr usize trend_runs       = 12;
+
+            const timings::keys keys = app::timing_keys(gen);
+            const str path           = app::fuzz_throughput_file(gen);
+            const auto throughput    = app::read_timings<fuzz::throughput>(path);
+
+            const auto number = [](const u64 n) {
+                str s;
+                s << as_num(n);
+                return s;
+            };
+
+            report::table table;
+            table.add_row("Exec/s", "Change", "Runs", "Trend", "Cov", "Ft", "RSS", "Target");
+
+            vec<str> regressed;
+            for (const auto& t : targets)
+            {
+                const auto samples = throughput.targets().get(keys.key(t.executable));
+                if (!samples || samples.value().is_empty())
+                {
+                    table.add_row("-", "-", "0", "", "-", "-", "-", t.executable);
+                    continue;
+                }
+
+                const vec<fuzz::throughput::sample>& all = samples.value();
+                const fuzz::throughput::sample& last     = all.back().value();
+                const fuzz::trend trend                  = fuzz::analyze(all, regression_percent);
+
+                str change{"-"};
+                if (trend.runs > 0)
+                {
+                    change = trend.latest >= trend.baseline
+                                 ? concat("+", report::percent(trend.latest - trend.baseline,
+                                                               trend.baseline))
+                                 : concat("-", report::percent(trend.baseline - trend.latest,
+                                                               trend.baseline));
+                }
+
+                vec<u64> recent{container::reserve, trend_runs};
+                for (usize i = all.count() > trend_runs ? all.count() - trend_runs : 0;
+                     i < all.count(); ++i)
+                {
+                    recent.append(all.at(i, promise::within_bounds).execs_per_worker());
+                }
+
+                table.add_row(number(trend.latest), std::move(change), number(all.count()),
+                              fuzz::sparkline(recent), number(last.coverage),
+                              number(last.features), last.rss ? report::bytes(last.rss) : str{"-"},
+                              t.executable);
+
+                if (trend.regressed)
+                {
+                    regressed.append(concat(t.executable, " (", report::percent(trend.latest,
+                                                                                trend.baseline),
+                                            " of the earlier exec/s)"));
+                }
+            }
+
+            fmt::print_error_line("Executions per second per worker (latest commit vs. the last"
+                                  " runs of earlier commits):");
+            file::standard::error{} << table.format();
+
+            for (const auto& r : regressed)
+            {
+                fmt::print_error_line("Warning: Throughput regression: {}", r);
+            }
+
+            return regressed.is_empty() ? constant::exit::success : constant::exit::failure;
+        }
+
+        // Share `budget` seconds between the targets in time slices (see `fuzz::history`). Each
+        // round about half of the targets (the best by the history) share the cores for one slice,
+        // a target that fails isn't picked again. The history is saved after each round.
+        [[nodiscard]] bool fuzz_with_budget(const generator& gen, const vec<fuzz_target>& targets,
+                                            const usize cores, const usize fixed_workers,
+                                            const u64 budget, const cstrview commit,
+                                            vec<fuzz::outcome>& outcomes, const u32 verbose_level)
+        {
+            const timings::keys keys = app::timing_keys(gen);
+            const str history_file   = app::fuzz_history_file(gen);
+            auto history             = app::read_timings<fuzz::history>(history_file);
+
+            outcomes.clear();
+            for (usize i = 0; i < targets.count(); ++i)
+            {
+                outcomes.append(fuzz::outcome{});
+            }
+
+            const u64 slice    = fuzz::slice_seconds(budget, targets.count());
+            const u64 deadline = clock::monotonic() + budget * 1'000'000'000;
+            bool success       = true;
+
+            while (true)
+            {
+                const u64 now = clock::monotonic();
+                if (now + 1'000'000'000 > deadline)
+                {
+                    break;
+                }
+                const u64 remaining = (deadline - now) / 1'000'000'000;
+
+                // Candidates (targets that haven't failed).
+                vec<usize> candidates;
+                vec<str> candidate_keys;
+                for (usize i = 0; i < targets.count(); ++i)
+                {
+                    if (!outcomes.at(i, promise::within_bounds).failed)
+                    {
+                        const fuzz_target& t = targets.at(i, promise::within_bounds);
+                        candidates.append(i);
+                        candidate_keys.append(keys.key(t.executable));
+                    }
+                }
+                if (candidates.is_empty())
+                {
+                    break;
+                }
+
+                vec<usize> workers;
+                const usize slots =
+                    app::split_fuzz_cores(cores, fixed_workers, candidates.count(), workers);
+                const usize count = (math::min(slots, candidates.count()) + 1) / 2;
+
+                const auto order = history.schedule(candidate_keys, count);
+
+                vec<fuzz_target> round;
+                for (const usize c : order)
+                {
+                    round.append(targets.at(candidates.at(c, promise::within_bounds),
+                                            promise::within_bounds));
+                }
+
+                const u64 seconds = math::min(slice, remaining);
+                if (verbose_level >= 1)
+                {
+                    fmt::print_error_line("Fuzzing {} of {} targets for {} s ({} s left)",
+                                          round.count(), candidates.count(), seconds, remaining);
+                }
+
+                vec<fuzz::outcome> round_outcomes;
+                app::split_fuzz_cores(cores, fixed_workers, round.count(), workers);
+                if (!app::fuzz_campaign(round, workers, round.count(), seconds, round_outcomes,
+                                        verbose_level))
+                {
+                    success = false;
+                }
+                app::record_throughput(gen, commit, round, workers, round_outcomes);
+
+                for (usize i = 0; i < order.count(); ++i)
+                {
+                    const usize c          = order.at(i, promise::within_bounds);
+                    const usize index      = candidates.at(c, promise::within_bounds);
+                    const fuzz::outcome& o = round_outcomes.at(i, promise::within_bounds);
+                    fuzz::outcome& total   = outcomes.at(index, promise::within_bounds);
+
+                    if (total.first.executions == 0)
+                    {
+                        total.first = o.first;
+                    }
+                    if (o.last.executions > 0)
+                    {
+                        total.last = o.last;
+                    }
+                    total.failed = o.failed;
+
+                    if (!o.failed && o.last.executions > 0)
+                    {
+                        history.add_slice(candidate_keys.at(c, promise::within_bounds),
+                                          o.first.features, o.last.features, seconds);
+                    }
+                }
+
+                if (history.is_modified() &&
+                    (!app::create_directory(gen.workspace_directory()) ||
+                     !file::write(history_file, history.serialize())))
+                {
+                    fmt::print_error_line("Warning: Failed to write fuzz history: {}",
+                                          history_file);
+                }
+            }
+
+            return success;
+        }
+
+        // Run every input of the corpora once (as regression tests) in processes split between
+        // `cores`, stop at the first failing input. Reports the time and the slowest inputs.
+        int replay_corpora(const vec<fuzz_target>& targets, const usize cores,
+                           const u32 verbose_level)
+        {
+            vec<jobs::job> all_jobs;
+            usize input_count = 0;
+            for (const auto& t : targets)
+            {
+                const auto inputs = fuzz::corpus_inputs(t.corpus);
+                if (!inputs)
+                {
+                    fmt::print_error_line("Error: Failed to read corpus: {}", t.corpus);
+                    return constant::exit::failure;
+                }
+
+                vec<u64> sizes{container::reserve, inputs.value().count()};
+                for (const auto& in : inputs.value())
+                {
+                    sizes.append(in.size);
+                }
+
+                const usize parts = fuzz::replay_parts(inputs.value().count(), cores);
+                for (const auto& group : fuzz::partition(sizes, parts))
+                {
+                    if (group.is_empty())
+                    {
+                        continue;
+                    }
+
+                    jobs::job j;
+                    j.path = t.executable;
+                    j.arguments.append("-rss_limit_mb=3072");
+                    j.arguments.append("-timeout=5");
+                    if (t.directory)
+                    {
+                        j.arguments.append(concat("-artifact_prefix=", t.directory));
+                    }
+                    for (const usize index : group)
+                    {
+                        j.arguments.append(inputs.value().at(index, promise::within_bounds).path);
+                    }
+                    all_jobs.append(std::move(j));
+                }
+
+                input_count += inputs.value().count();
+            }
+
+            if (all_jobs.is_empty())
+            {
+                fmt::print_error_line("No corpus inputs to replay");
+                return constant::exit::success;
+            }
+
+            if (verbose_level >= 1)
+            {
+                fmt::print_error_line("Replaying {} inputs in {} processes", input_count,
+                                      all_jobs.count());
+            }
+
+            struct timed_input final
+            {
+                str path;
+                u64 ms = 0;
+            };
+
+            vec<timed_input> timed{container::reserve, input_count};
+            vec<strbuf> output{container::reserve, all_jobs.count()};
+            vec<str> current{container::reserve, all_jobs.count()}; // Input being executed.
+            for (usize i = 0; i < all_jobs.count(); ++i)
+            {
+                output.append(strbuf{});
+                current.append(str{});
+            }
+
+            bool failed     = false;
+            const u64 start = clock::monotonic();
+
+            constexpr int tick_ms = 1000;
+            app::run_captured(
+                all_jobs, cores, tick_ms,
+                [&](const usize index, const cstrview line) {
+                    if (const auto e = fuzz::parse_executed(line))
+                    {
+                        timed.append(timed_input{str{e.value().input}, e.value().ms});
+                        return;
+                    }
+
+                    if (line.has_front("Running: "))
+                    {
+                        current.at(index, promise::within_bounds) =
+                            str{line.view(string_size("Running: "))};
+                    }
+
+                    // Only shown if the process fails.
+                    output.at(index, promise::within_bounds) << line << '\n';
+                },
+                [&](const usize index, const int exit_status, const int error_number) {
+                    const str& path = all_jobs.at(index, promise::within_bounds).path;
+                    if (error_number != 0)
+                    {
+                        fmt::print_error_line("Error: Failed to execute: {} (errno {})", path,
+                                              error_number);
+                    }
+                    else if (exit_status != constant::exit::success)
+                    {
+                        file::standard::error{} << output.at(index, promise::within_bounds);
+                        fmt::print_error_line("Error: Failed: {} (exit status {})", path,
+                                              exit_status);
+                        if (const str& input = current.at(index, promise::within_bounds))
+                        {
+                            fmt::print_error_line("Error: Failing input: {}", input);
+                        }
+                    }
+                    else
+                    {
+                        output.at(index, promise::within_bounds).clear();
+                        return true;
+                    }
+
+                    failed = true;
+                    return false; // Stop at the first failure.
+                },
+                [] {});
+
+            const u64 wall_ns = clock::monotonic() - start;
+
+            fmt::print_error_line("Replayed {} of {} inputs ({} targets, {} processes) in {}",
+                                  timed.count(), input_count, targets.count(), all_jobs.count(),
+                                  report::duration(wall_ns));
+
+            algo::sort(timed.range(), [](const timed_input& a, const timed_input& b) {
+                return a.ms > b.ms;
+            });
+
+            constexpr usize slowest = 10;
+            report::table table;
+            for (const auto& in : timed)
+            {
+                if (table.count() == slowest || in.ms == 0)
+                {
+                    break;
+                }
+                table.add_row(report::duration(in.ms * 1'000'000), in.path);
+            }
+            if (table.count() > 0)
+            {
+                fmt::print_error_line("Slowest inputs:");
+                file::standard::error{} << table.format();
+            }
+
+            return failed ? constant::exit::failure : constant::exit::success;
+        }
+
+        void print_fuzz_summary(const vec<fuzz_target>& targets,
+                                const vec<fuzz::outcome>& outcomes)
+        {
+            const auto number = [](const u64 n) {
+                str s;
+                s << as_num(n);
+                return s;
+            };
+
+            report::table table;
+            table.add_row("Exec/s", "Cov", "Ft", "Corpus", "Target");
+            for (usize i = 0; i < targets.count(); ++i)
+            {
+                const fuzz::progress& p = outcomes.at(i, promise::within_bounds).last;
+                table.add_row(number(p.execs_per_second), number(p.coverage), number(p.features),
+                              number(p.corpus), targets.at(i, promise::within_bounds).executable);
+            }
+            file::standard::error{} << table.format();
+        }
+
+        // Compile cost report from the `-ftime-trace` JSON files that clang writes next to the
+        // object files (deleted with them by `clean-object-files`). Each header is shown with its
+        // fan-in (source files that include it, directly or indirectly).
+        [[nodiscard]] bool time_report(const app::generator& gen)
+        {
+            constexpr usize max_rows = 20;
+
+            set::sorted<str> sources;
+            for (const auto& app : gen.applications())
+            {
+                for (const auto& source : gen.sources(app))
+                {
+                    sources.insert(source);
+                }
+            }
+
+            timetrace::aggregate costs;
+            strbuf contents;
+            for (const auto& source : sources)
+            {
+                const str trace_file = concat(source.view_offset(0, -3), ".json");
+                if (!file::read(trace_file, contents))
+                {
+                    fmt::print_error_line("Error: Failed to read time trace: {}", trace_file);
+                    return false;
+                }
+
+                if (!costs.add(contents))
+                {
+                    fmt::print_error_line("Error: Invalid time trace: {}", trace_file);
+                    return false;
+                }
+            }
+
+            const auto duration = [](const u64 microseconds) {
+                return report::duration(microseconds * 1000);
+            };
+            const auto number = [](const u64 n) {
+                str s;
+                s << as_num(n);
+                return s;
+            };
+
+            const auto top_headers = timetrace::top(costs.headers(), max_rows);
+
+            vec<str> header_paths{container::reserve, top_headers.count()};
+            for (const auto& r : top_headers)
+            {
+                header_paths.append(str{r.name});
+            }
+            const auto fan_in = gen.fan_in(header_paths);
+
+            report::table headers;
+            headers.add_row("Time", "Count", "Fan-in", "Header");
+            for (const auto [i, r] : top_headers.range() | range::v::enumerate{})
+            {
+                const usize n = fan_in.at(i, promise::within_bounds);
+                headers.add_row(duration(r.total.microseconds), number(r.total.count),
+                                n > 0 ? number(n) : str{"-"}, r.name);
+            }
+
+            report::table templates;
+            templates.add_row("Time", "Count", "Template");
+            for (const auto& r : timetrace::top(costs.templates(), max_rows))
+            {
+                templates.add_row(duration(r.total.microseconds), number(r.total.count), r.name);
+            }
+
+            const u64 frontend = costs.frontend_microseconds();
+            const u64 backend  = costs.backend_microseconds();
+
+            report::table split;
+            split.add_row("Time", "Share", "Phase");
+            split.add_row(duration(frontend), report::percent(frontend, frontend + backend),
+                          "frontend");
+            split.add_row(duration(backend), report::percent(backend, frontend + backend),
+                          "backend");
+
+            strbuf out{container::reserve, 4096};
+            out << "\nMost expensive headers (parse time, " << as_num(costs.units())
+                << " translation units):\n";
+            out << headers.format();
+            out << "\nMost expensive template instantiations:\n";
+            out << templates.format();
+            out << "\nFrontend/backend:\n";
+            out << split.format();
+            file::standard::error{} << out;
+
+            return true;
+        }
+
+        int build(const cstrview program_name, const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"cgroup", 'i', env::option::takes_values},
+                                  {"compiler", 'c', env::option::takes_values},
+                                  {"define", 'd', env::option::takes_values},
+                                  {"optimize", 'o'},
+                                  {"sanitize", 's'},
+                                  {"time-execution", 't'},
+                                  {"time-report", 'r'},
+                                  {"verbose", 'v'},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}.", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            app::generator gen;
+
+            const auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool optimize       = opts.option('o').is_set();
+                const bool sanitize       = opts.option('s').is_set();
+                const bool time_execution = opts.option('t').is_set();
+                const bool time_report    = opts.option('r').is_set();
+                auto verbose_level        = opts.option('v').count();
+
+                if (time_execution)
+                {
+                    verbose_level = math::max(verbose_level, 1);
+                }
+
+                gen.set_optimize(optimize);
+                gen.set_sanitize(sanitize);
+                gen.set_time_execution(time_execution);
+                gen.set_time_trace(time_report);
+                gen.set_verbose_level(verbose_level);
+
+                // Makefile
+
+                const str makefile = app::temporary_file_name(".mk");
+
+                // Compiler & macros.
+
+                const cstrview compiler = opts.option('c').values().back().value_or_default();
+                const cstrview macros   = opts.option('d').values().back().value_or_default();
+                if (!gen.setup_compiler_and_macros(compiler, macros))
+                {
+                    return constant::exit::failure;
+                }
+
+                if (time_report && !gen.compiler().contains("clang"))
+                {
+                    fmt::print_error_line("Error: Time report requires clang (-ftime-trace)");
+                    return constant::exit::failure;
+                }
+
+                app::record_compile_times(gen, program_name);
+
+                cgroup::tree cgroups;
+                if (opts.option('i').is_set() &&
+                    !app::setup_cgroups(gen, cgroups, program_name,
+                                        opts.option('i').values().back().value_or_default()))
+                {
+                    return constant::exit::failure;
+                }
+
+                // Sources
+
+                for (const auto arg : args)
+                {
+                    if (!gen.add_application(arg.to<str>()))
+                    {
+                        return constant::exit::failure;
+                    }
+                }
+
+                if (gen.applications().is_empty())
+                {
+                    fmt::print_error_line("Error: No application source files to process");
+                    return constant::exit::failure;
+                }
+
+                // Parse, generate & build.
+
+                if (gen.parse())
+                {
+                    const str makefile_depend; // Empty (don't generate).
+
+                    if (gen.generate(makefile, makefile_depend))
+                    {
+                        app::make(makefile, "clean", verbose_level);
+
+                        int exit_status = app::make(makefile, "all", verbose_level);
+
+                        if (time_report && exit_status == constant::exit::success &&
+                            !app::time_report(gen))
+                        {
+                            exit_status = constant::exit::failure;
+                        }
+
+                        app::make(makefile, "clean-object-files", verbose_level);
+
+                        if (verbose_level >= 3)
+                        {
+                            fmt::print_error_line("Deleting: {}", makefile);
+                        }
+                        file::remove(makefile).or_throw();
+
+                        return exit_status;
+                    }
+                }
+            }
+            else
+            {
+                strbuf usage{container::reserve, 700};
+
+                usage << "Usage: " << program_name << " build [options] [--] app.cc [...]\n";
+
+                usage << '\n';
+
+                usage << "Options:\n";
+                usage << "-o --optimize            Optimize (-O2)\n";
+                usage << "-i --cgroup limits       Compile in cgroups with limits, e.g."
+                         " memory=2G,cpu=150 (Linux)\n";
+                usage << "-t --time-execution      Time command execution (implies verbose)\n";
+                usage << "-r --time-report         Report the most expensive headers and templates"
+                         " (clang -ftime-trace)\n";
+                usage << "-s --sanitize            Enable sanitizers (Address & "
+                         "UndefinedBehavior)\n";
+                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
+                      << ")\n";
+                usage << "-d --define MACRO[,...]  Define macro(s)\n";
+                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+
+                usage << '\n';
+
+                usage << "Verbosity levels:\n";
+                usage << "1. Show compile/run commands\n";
+                usage << "2. Show all commands\n";
+                usage << "3. Debug\n";
+
+                file::standard::error{} << usage;
+            }
+
+            return constant::exit::failure;
+        }
+
+        int cover(const cstrview program_name, const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"compiler", 'c', env::option::takes_values},
+                                  {"define", 'd', env::option::takes_values},
+                                  {"html", 'w', env::option::takes_values},
+                                  {"jobs", 'j', env::option::takes_values},
+                                  {"optimize", 'o'},
+                                  {"verbose", 'v'},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            app::generator gen;
+
+            const auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool optimize      = opts.option('o').is_set();
+                const auto verbose_level = opts.option('v').count();
+                const cstrview html      = opts.option('w').values().back().value_or_default();
+
+                usize concurrency        = jobs::processors();
+                const cstrview job_count = opts.option('j').values().back().value_or_default();
+                if (job_count)
+                {
+                    const auto n = number::parse(job_count);
+                    if (!n || n.value() == 0)
+                    {
+                        fmt::print_error_line("Error: Invalid number of jobs: {}", job_count);
+                        return constant::exit::failure;
+                    }
+                    concurrency = n.value();
+                }
+
+                gen.set_coverage(true);
+                gen.set_optimize(optimize);
+                gen.set_verbose_level(verbose_level);
+
+                // Makefile
+
+                const str makefile = app::temporary_file_name(".mk");
+
+                // Compiler & macros.
+
+                const cstrview compiler = opts.option('c').values().back().value_or_default();
+                const cstrview macros   = opts.option('d').values().back().value_or_default();
+                if (!gen.setup_compiler_and_macros(compiler, macros))
+                {
+                    return constant::exit::failure;
+                }
+
+                if (!gen.compiler().contains("clang"))
+                {
+                    fmt::print_error_line("Error: Source-based coverage requires clang");
+                    return constant::exit::failure;
+                }
+
+                // Sources
+
+                for (const auto arg : args)
+                {
+                    if (!gen.add_application(arg.to<str>()))
+                    {
+                        return constant::exit::failure;
+                    }
+                }
+
+                if (gen.applications().is_empty())
+                {
+                    fmt::print_error_line("Error: No application source files to process");
+                    return constant::exit::failure;
+                }
+
+                // Parse, generate, build, run & report.
+
+                if (gen.parse())
+                {
+                    const str makefile_depend; // Empty (don't generate).
+
+                    if (gen.generate(makefile, makefile_depend))
+                    {
+                        app::make(makefile, "clean", verbose_level);
+
+                        int exit_status = app::make(makefile, "all", verbose_level);
+
+                        if (exit_status == constant::exit::success)
+                        {
+                            exit_status = app::cover_applications(gen, concurrency, html,
+                                                                  verbose_level);
+                        }
+
+                        app::make(makefile, "clean", verbose_level);
+
+                        if (verbose_level >= 3)
+                        {
+                            fmt::print_error_line("Deleting: {}", makefile);
+                        }
+                        file::remove(makefile).or_throw();
+
+                        return exit_status;
+                    }
+                }
+            }
+            else
+            {
+                strbuf usage{container::reserve, 700};
+
+                usage << "Usage: " << program_name << " cover [options] [--] app.cc [...]\n";
+
+                usage << '\n';
+
+                usage << "Options:\n";
+                usage << "-o --optimize            Optimize (-O2)\n";
+                usage << "-j --jobs N              Run N applications in parallel (default: "
+                      << as_num(jobs::processors()) << ")\n";
+                usage << "-w --html directory      Also write an HTML report to directory\n";
+                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
+                      << ")\n";
+                usage << "-d --define MACRO[,...]  Define macro(s)\n";
+                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+
+                usage << '\n';
+
+                usage << "Verbosity levels:\n";
+                usage << "1. Show compile/run commands\n";
+                usage << "2. Show all commands\n";
+                usage << "3. Debug\n";
+
+                file::standard::error{} << usage;
+            }
+
+            return constant::exit::failure;
+        }
+
+        int fuzz_command(const cstrview program_name,
+                         const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"budget", 'b', env::option::takes_values},
+                                  {"compiler", 'c', env::option::takes_values},
+                                  {"define", 'd', env::option::takes_values},
+                                  {"jobs", 'j', env::option::takes_values},
+                                  {"minimize", 'm'},
+                                  {"replay", 'r'},
+                                  {"report", 'p'},
+                                  {"time", 't', env::option::takes_values},
+                                  {"verbose", 'v'},
+                                  {"workers", 'w', env::option::takes_values},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            app::generator gen;
+
+            const auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool minimize      = opts.option('m').is_set();
+                const bool replay        = opts.option('r').is_set();
+                const bool show_report   = opts.option('p').is_set();
+                const auto verbose_level = opts.option('v').count();
+
+                usize cores              = jobs::processors();
+                const cstrview job_count = opts.option('j').values().back().value_or_default();
+                if (job_count)
+                {
+                    const auto n = number::parse(job_count);
+                    if (!n || n.value() == 0)
+                    {
+                        fmt::print_error_line("Error: Invalid number of jobs: {}", job_count);
+                        return constant::exit::failure;
+                    }
+                    cores = n.value();
+                }
+
+                usize fixed_workers         = 0; // Split the cores between the targets.
+                const cstrview worker_count = opts.option('w').values().back().value_or_default();
+                if (worker_count)
+                {
+                    const auto n = number::parse(worker_count);
+                    if (!n || n.value() == 0 || n.value() > 4096)
+                    {
+                        fmt::print_error_line("Error: Invalid number of workers (1-4096): {}",
+                                              worker_count);
+                        return constant::exit::failure;
+                    }
+                    fixed_workers = n.value();
+                }
+
+                optional<u64> max_total_time;
+                const cstrview seconds = opts.option('t').values().back().value_or_default();
+                if (seconds)
+                {
+                    const auto n = number::parse(seconds);
+                    if (!n || n.value() == 0)
+                    {
+                        fmt::print_error_line("Error: Invalid time (seconds): {}", seconds);
+                        return constant::exit::failure;
+                    }
+                    max_total_time = n.value();
+                }
+
+                optional<u64> budget;
+                const cstrview duration = opts.option('b').values().back().value_or_default();
+                if (duration)
+                {
+                    budget = fuzz::parse_duration(duration);
+                    if (!budget)
+                    {
+                        fmt::print_error_line("Error: Invalid budget (e.g. 3600, 90m or 4h): {}",
+                                              duration);
+                        return constant::exit::failure;
+                    }
+
+                    if (max_total_time)
+                    {
+                        fmt::print_error_line("Error: --budget can't be combined with --time");
+                        return constant::exit::failure;
+                    }
+                }
+
+                if (replay && (budget || max_total_time))
+                {
+                    fmt::print_error_line("Error: --replay can't be combined with --budget or"
+                                          " --time");
+                    return constant::exit::failure;
+                }
+
+                if (minimize && (replay || budget || max_total_time))
+                {
+                    fmt::print_error_line("Error: --minimize can't be combined with --replay,"
+                                          " --budget or --time");
+                    return constant::exit::failure;
+                }
+
+                if (show_report && (minimize || replay || budget || max_total_time))
+                {
+                    fmt::print_error_line("Error: --report can't be combined with --minimize,"
+                                          " --replay, --budget or --time");
+                    return constant::exit::failure;
+                }
+
+                gen.set_fuzz(true);
+                gen.set_verbose_level(verbose_level);
+
+                // Makefile
+
+                const str makefile = app::temporary_file_name(".mk");
+
+                // Compiler & macros.
+
+                const cstrview compiler = opts.option('c').values().back().value_or_default();
+                const cstrview macros   = opts.option('d').values().back().value_or_default();
+                if (!gen.setup_compiler_and_macros(compiler, macros))
+                {
+                    return constant::exit::failure;
+                }
+
+                // Sources
+
+                for (const auto arg : args)
+                {
+                    if (!gen.add_application(arg.to<str>()))
+                    {
+                        return constant::exit::failure;
+                    }
+                }
+
+                if (gen.applications().is_empty())
+                {
+                    fmt::print_error_line("Error: No application source files to process");
+                    return constant::exit::failure;
+                }
+
+                if (show_report)
+                {
+                    return app::fuzz_report(gen, app::fuzz_targets(gen));
+                }
+
+                // Parse, generate & build.
+
+                if (!gen.parse())
+                {
+                    return constant::exit::failure;
+                }
+
+                const str makefile_depend; // Empty (don't generate).
+                if (!gen.generate(makefile, makefile_depend))
+                {
+                    return constant::exit::failure;
+                }
+
+                app::make(makefile, "clean", verbose_level);
+                const int build_status = app::make(makefile, "all", verbose_level);
+                app::make(makefile, "clean-object-files", verbose_level);
+
+                if (verbose_level >= 3)
+                {
+                    fmt::print_error_line("Deleting: {}", makefile);
+                }
+                file::remove(makefile).or_throw();
+
+                if (build_status != constant::exit::success)
+                {
+                    return build_status;
+                }
+
+                // Corpora
+
+                const auto targets       = app::fuzz_targets(gen);
+                const timings::keys keys = app::timing_keys(gen);
+                const str digests_file   = app::corpus_digests_file(gen);
+                auto digests             = app::read_timings<timings::durations>(digests_file);
+                for (const auto& t : targets)
+                {
+                    if (!app::prepare_corpus(t, keys, digests, verbose_level))
+                    {
+                        fmt::print_error_line("Error: Failed to prepare corpus: {}", t.corpus);
+                        return constant::exit::failure;
+                    }
+                }
+
+                if (digests.is_modified() &&
+                    (!app::create_directory(gen.workspace_directory()) ||
+                     !file::write(digests_file, digests.serialize())))
+                {
+                    fmt::print_error_line("Warning: Failed to write corpus digests: {}",
+                                          digests_file);
+                }
+
+                if (minimize)
+                {
+                    return app::minimize_corpora(targets, cores, verbose_level);
+                }
+
+                if (replay)
+                {
+                    return app::replay_corpora(targets, cores, verbose_level);
+                }
+
+                // Fuzz
+
+                const str commit = app::current_commit(verbose_level);
+
+                vec<fuzz::outcome> outcomes;
+                bool success = false;
+                if (budget)
+                {
+                    success = app::fuzz_with_budget(gen, targets, cores, fixed_workers,
+                                                    budget.value(), commit, outcomes,
+                                                    verbose_level);
+                }
+                else
+                {
+                    vec<usize> workers;
+                    const usize concurrency = app::split_fuzz_cores(cores, fixed_workers,
+                                                                    targets.count(), workers);
+
+                    constexpr u64 default_time = 900; // Seconds per target if there are several.
+                    const u64 time =
+                        max_total_time.value_or(targets.count() > 1 ? default_time : 0);
+
+                    success = app::fuzz_campaign(targets, workers, concurrency, time, outcomes,
+                                                 verbose_level);
+                    app::record_throughput(gen, commit, targets, workers, outcomes);
+                }
+
+                app::print_fuzz_summary(targets, outcomes);
+
+                return success ? constant::exit::success : constant::exit::failure;
+            }
+            else
+            {
+                strbuf usage{container::reserve, 900};
+
+                usage << "Usage: " << program_name << " fuzz [options] [--] target.cc [...]\n";
+
+                usage << '\n';
+
+                usage << "Build libFuzzer targets (see gen --fuzz) and fuzz them in parallel.\n";
+
+                usage << '\n';
+
+                usage << "Options:\n";
+                usage << "-j --jobs N              Use N cores in total (default: "
+                      << as_num(jobs::processors()) << ")\n";
+                usage << "-w --workers N           Workers (-fork=N) per target (default: the"
+                         " cores split\n"
+                         "                         between the targets)\n";
+                usage << "-t --time seconds        Fuzz each target for seconds (default: 900"
+                         " if more than\n"
+                         "                         one target, otherwise until stopped)\n";
+                usage << "-b --budget duration     Share duration (e.g. 4h) between the targets in"
+                         " time slices,\n"
+                         "                         more to targets with growing coverage\n";
+                usage << "-r --replay              Run each corpus input once (regression test),"
+                         " stop at the\n"
+                         "                         first failure\n";
+                usage << "-m --minimize            Minimize the corpora (-merge=1), all targets in"
+                         " parallel\n";
+                usage << "-p --report              Show the throughput (exec/s) trends of the"
+                         " targets, fail if\n"
+                         "                         a target has slowed down (by 20% or more)\n";
+                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
+                      << ")\n";
+                usage << "-d --define MACRO[,...]  Define macro(s)\n";
+                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+
+                usage << '\n';
+
+                usage << "Verbosity levels:\n";
+                usage << "1. Show compile/run commands\n";
+                usage << "2. Show all commands\n";
+                usage << "3. Debug\n";
+
+                file::standard::error{} << usage;
+            }
+
+            return constant::exit::failure;
+        }
+
+        int gen(const cstrview program_name, const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"compiler", 'c', env::option::takes_values},
+                                  {"define", 'd', env::option::takes_values},
+                                  {"fuzz", 'z'},
+                                  {"makefile", 'f', env::option::takes_values},
+                                  {"optimize", 'o'},
+                                  {"sanitize", 's'},
+                                  {"time-execution", 't'},
+                                  {"verbose", 'v'},
+                                  {"zstd", 'y'},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            app::generator gen;
+
+            const auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool fuzz           = opts.option('z').is_set();
+                const bool zstd           = opts.option('y').is_set();
+                const bool optimize       = opts.option('o').is_set();
+                const bool sanitize       = opts.option('s').is_set();
+                const bool time_execution = opts.option('t').is_set();
+                auto verbose_level        = opts.option('v').count();
+
+                if (time_execution)
+                {
+                    verbose_level = math::max(verbose_level, 1);
+                }
+
+                gen.set_corpus_zstd(zstd);
+                gen.set_fuzz(fuzz);
+                gen.set_optimize(optimize);
+                gen.set_sanitize(sanitize);
+                gen.set_time_execution(time_execution);
+                gen.set_verbose_level(verbose_level);
+
+                // Makefile
+
+                str makefile;
+
+                if (auto opt = opts.option('f'); opt.is_set())
+                {
+                    makefile = opt.values().back().value_or_default();
+                }
+                else
+                {
+                    makefile = "makefile";
+                }
+
+                if (!app::validator::is_file_path(makefile))
+                {
+                    fmt::print_error_line("Error: Invalid makefile name: {}", makefile);
+                    return constant::exit::failure;
+                }
+
+                if (file::is_something(makefile))
+                {
+                    fmt::print_error_line("Error: Makefile already exists: {}", makefile);
+                    return constant::exit::failure;
+                }
+
+                // Compiler & macros.
+
+                const cstrview compiler = opts.option('c').values().back().value_or_default();
+                const cstrview macros   = opts.option('d').values().back().value_or_default();
+                if (!gen.setup_compiler_and_macros(compiler, macros))
+                {
+                    return constant::exit::failure;
+                }
+
+                // Sources
+
+                for (const auto arg : args)
+                {
+                    if (!gen.add_application(arg.to<str>()))
+                    {
+                        return constant::exit::failure;
+                    }
+                }
+
+                if (gen.applications().is_empty())
+                {
+                    fmt::print_error_line("Error: No application source files to process");
+                    return constant::exit::failure;
+                }
+
+                // Parse & generate.
+
+                if (gen.parse())
+                {
+                    const str makefile_depend = concat(makefile, ".depend");
+
+                    if (gen.generate(makefile, makefile_depend))
+                    {
+                        return constant::exit::success;
+                    }
+                }
+            }
+            else
+            {
+                strbuf usage{container::reserve, 600};
+
+                usage << "Usage: " << program_name << " gen [options] [--] app.cc [...]\n";
+
+                usage << '\n';
+
+                usage << "Options:\n";
+                usage << "-f --makefile file       Write to file instead of \"makefile\"\n";
+                usage << "-o --optimize            Optimize (-O2)\n";
+                usage << "-t --time-execution      Time command execution (implies verbose)\n";
+                usage << "-s --sanitize            Enable sanitizers (Address & "
+                         "UndefinedBehavior)\n";
+                usage << "-z --fuzz                Build libFuzzer binary (implies sanitizers)\n";
+                usage << "-y --zstd                Compress fuzz corpora with zstd (with --fuzz)\n";
+                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
+                      << ")\n";
+                usage << "-d --define MACRO[,...]  Define macro(s)\n";
+                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+
+                usage << '\n';
+
+                usage << "Verbosity levels:\n";
+                usage << "1. Show compile/run commands\n";
+                usage << "2. Show all commands\n";
+                usage << "3. Debug\n";
+
+                file::standard::error{} << usage;
+            }
+
+            return constant::exit::failure;
+        }
+
+        int impact(const cstrview program_name, const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"compiler", 'c', env::option::takes_values},
+                                  {"define", 'd', env::option::takes_values},
+                                  {"jobs", 'j', env::option::takes_values},
+                                  {"max-cpu", 'm', env::option::takes_values},
+                                  {"optimize", 'o'},
+                                  {"verbose", 'v'},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            app::generator gen;
+
+            const auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool optimize      = opts.option('o').is_set();
+                const auto verbose_level = opts.option('v').count();
+
+                usize concurrency        = jobs::processors();
+                const cstrview job_count = opts.option('j').values().back().value_or_default();
+                if (job_count)
+                {
+                    const auto n = number::parse(job_count);
+                    if (!n || n.value() == 0)
+                    {
+                        fmt::print_error_line("Error: Invalid number of jobs: {}", job_count);
+                        return constant::exit::failure;
+                    }
+                    concurrency = n.value();
+                }
+
+                optional<u64> max_cpu_ns;
+                const cstrview max_cpu = opts.option('m').values().back().value_or_default();
+                if (max_cpu)
+                {
+                    const auto n = number::parse(max_cpu);
+                    if (!n)
+                    {
+                        fmt::print_error_line("Error: Invalid number of seconds: {}", max_cpu);
+                        return constant::exit::failure;
+                    }
+                    max_cpu_ns = n.value() * 1'000'000'000;
+                }
+
+                const str changed_file = args.front().value().to<str>();
+                if (!file::is_regular(changed_file))
+                {
+                    fmt::print_error_line("Error: No such file: {}", changed_file);
+                    return constant::exit::failure;
+                }
+
+                gen.set_optimize(optimize);
+                gen.set_verbose_level(verbose_level);
+
+                // Compiler & macros.
+
+                const cstrview compiler = opts.option('c').values().back().value_or_default();
+                const cstrview macros   = opts.option('d').values().back().value_or_default();
+                if (!gen.setup_compiler_and_macros(compiler, macros))
+                {
+                    return constant::exit::failure;
+                }
+
+                // Compile times.
+
+                const auto times =
+                    app::read_timings<timings::durations>(app::compile_times_file(gen));
+                const auto keys  = app::timing_keys(gen);
+
+                // Applications: the arguments or, without arguments, every application with a
+                // recorded link time (built in this workspace) that still exists.
+
+                if (args.count() > 1)
+                {
+                    bool first = true;
+                    for (const auto arg : args)
+                    {
+                        if (!first && !gen.add_application(arg.to<str>()))
+                        {
+                            return constant::exit::failure;
+                        }
+                        first = false;
+                    }
+                }
+                else
+                {
+                    for (const auto& p : times.targets())
+                    {
+                        if (!p.first.has_back(".o"))
+                        {
+                            str source = keys.path(p.first);
+                            source << ".cc";
+                            if (file::is_regular(source) && !gen.add_application(source))
+                            {
+                                return constant::exit::failure;
+                            }
+                        }
+                    }
+                }
+
+                if (gen.applications().is_empty())
+                {
+                    fmt::print_error_line("Error: No application source files to process (build"
+                                          " applications first or list them)");
+                    return constant::exit::failure;
+                }
+
+                // Parse & query.
+
+                if (gen.parse())
+                {
+                    vec<str> changed;
+                    changed.append(changed_file);
+
+                    const auto sources      = gen.affected_sources(changed);
+                    const auto applications = gen.affected_applications(changed);
+
+                    usize unknown = 0;
+
+                    const auto add = [&](report::table& t, vec<u64>& durations, u64& cpu,
+                                         const str& target) {
+                        if (const auto d = times.get(keys.key(target)))
+                        {
+                            durations.append(d.value());
+                            cpu += d.value();
+                            t.add_row(report::duration(d.value()), target);
+                        }
+                        else
+                        {
+                            ++unknown;
+                            t.add_row("-", target);
+                        }
+                    };
+
+                    report::table objects;
+                    objects.add_row("Compile", "Object");
+                    vec<u64> compile_durations;
+                    u64 compile_cpu = 0;
+                    for (const auto& source : sources)
+                    {
+                        add(objects, compile_durations, compile_cpu,
+                            concat(source.view_offset(0, -3), ".o"));
+                    }
+
+                    report::table executables;
+                    executables.add_row("Link", "Application");
+                    vec<u64> link_durations;
+                    u64 link_cpu = 0;
+                    for (const auto& app : applications)
+                    {
+                        add(executables, link_durations, link_cpu, str{app.view_offset(0, -3)});
+                    }
+
+                    // Linking starts when the objects are compiled (approximately).
+                    const u64 cpu  = compile_cpu + link_cpu;
+                    const u64 wall = timings::makespan(std::move(compile_durations), concurrency) +
+                                     timings::makespan(std::move(link_durations), concurrency);
+
+                    strbuf out{container::reserve, 1024};
+                    fmt::format_append("Impact: {}\n\n", out, promise::no_overlap, changed_file);
+                    out << objects.format();
+                    out << '\n';
+                    out << executables.format();
+                    out << '\n';
+                    fmt::format_append("Objects: {}, applications: {} (of {})\n", out,
+                                       promise::no_overlap, sources.count(),
+                                       applications.count(), gen.applications().count());
+                    fmt::format_append("Rebuild estimate: {} CPU, {} wall at -j{}", out,
+                                       promise::no_overlap, report::duration(cpu),
+                                       report::duration(wall), concurrency);
+                    if (unknown > 0)
+                    {
+                        fmt::format_append(" ({} without recorded times)", out,
+                                           promise::no_overlap, unknown);
+                    }
+                    out << '\n';
+                    file::standard::out{} << out;
+
+                    if (max_cpu_ns && cpu > max_cpu_ns.value())
+                    {
+                        fmt::print_error_line("Error: Estimated rebuild CPU time exceeds"
+                                              " --max-cpu {} (seconds)",
+                                              max_cpu);
+                        return constant::exit::failure;
+                    }
+
+                    return constant::exit::success;
+                }
+            }
+            else
+            {
+                strbuf usage{container::reserve, 800};
+
+                usage << "Usage: " << program_name
+                      << " impact [options] [--] file [app.cc ...]\n";
+
+                usage << '\n';
+
+                usage << "List the objects and applications that depend on a file and estimate the"
+                         " rebuild\n";
+                usage << "time from recorded compile times (recorded by build, run and runall"
+                         " with\n";
+                usage << "SNN_COMPILE_TIMES=1). Without applications, all applications built in"
+                         " the workspace\n";
+                usage << "are used.\n";
+
+                usage << '\n';
+
+                usage << "Options:\n";
+                usage << "-o --optimize            Optimize (-O2)\n";
+                usage << "-j --jobs N              Parallel jobs for the wall time estimate"
+                         " (default: " << jobs::processors() << ")\n";
+                usage << "-m --max-cpu seconds     Fail if the estimated rebuild CPU time is"
+                         " higher\n";
+                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
+                      << ")\n";
+                usage << "-d --define MACRO[,...]  Define macro(s)\n";
+                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+
+                file::standard::error{} << usage;
+            }
+
+            return constant::exit::failure;
+        }
+
+        int results_report(const cstrview program_name,
+                           const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"all", 'a'},
+                                  {"write", 'w', env::option::takes_values},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            const auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool all       = opts.option('a').is_set();
+                const cstrview write = opts.option('w').values().back().value_or_default();
+
+                results::merged merged;
+                for (const auto arg : args)
+                {
+                    const str path = arg.to<str>();
+
+                    strbuf contents;
+                    if (!file::read(path, contents) || !merged.parse(contents))
+                    {
+                        fmt::print_error_line("Error: Invalid results file: {}", path);
+                        return constant::exit::failure;
+                    }
+                }
+
+                file::standard::out{} << merged.format(all);
+
+                if (write && !app::write_results(write, merged))
+                {
+                    return constant::exit::failure;
+                }
+
+                return merged.is_success() ? constant::exit::success : constant::exit::failure;
+            }
+            else
+            {
+                strbuf usage{container::reserve, 600};
+
+                usage << "Usage: " << program_name << " results [options] [--] file.json [...]\n";
+
+                usage << '\n';
+
+                usage << "Merge and summarize results written with: " << program_name
+                      << " runall --json file\n";
+                usage << "Fails unless every application passed (or was cached) exactly once.\n";
+
+                usage << '\n';
+
+                usage << "Options:\n";
+                usage << "-a --all                 List all applications (not only failures)\n";
+                usage << "-w --write file          Write the merged results to a file\n";
+
+                file::standard::error{} << usage;
+            }
+
+            return constant::exit::failure;
+        }
+
+        int run(const cstrview program_name, const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"compiler", 'c', env::option::takes_values},
+                                  {"define", 'd', env::option::takes_values},
+                                  {"heap", 'h'},
+                                  {"optimize", 'o'},
+                                  {"profile", 'p'},
+                                  {"resources", 'e'},
+                                  {"sanitize", 's'},
+                                  {"scratch", 'a'},
+                                  {"startup", 'u'},
+                                  {"time-execution", 't'},
+                                  {"timeout", 'x', env::option::takes_values},
+                                  {"verbose", 'v'},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            app::generator gen;
+
+            auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool heap           = opts.option('h').is_set();
+                const bool optimize       = opts.option('o').is_set();
+                const bool profile        = opts.option('p').is_set();
+                const bool resource_usage = opts.option('e').is_set();
+                const bool sanitize       = opts.option('s').is_set();
+                const bool startup        = opts.option('u').is_set();
+                const bool time_execution = opts.option('t').is_set();
+                auto verbose_level        = opts.option('v').count();
+
+                if (time_execution)
+                {
+                    verbose_level = math::max(verbose_level, 1);
+                }
+
+#if !defined(__linux__)
+                if (profile)
+                {
+                    fmt::print_error_line("Error: Profiling is only supported on Linux");
+                    return constant::exit::failure;
+                }
+#endif
+
+                if (int{heap} + int{profile} + int{startup} + int{resource_usage} > 1)
+                {
+                    fmt::print_error_line(
+                        "Error: --heap, --profile, --resources and --startup can't be combined");
+                    return constant::exit::failure;
+                }
+
+                const cstrview timeout_seconds =
+                    opts.option('x').values().back().value_or_default();
+                const auto timeout = app::timeout_ns(timeout_seconds);
+                if (!timeout)
+                {
+                    return constant::exit::failure;
+                }
+
+                // The sanitizer runtime must be first in the initial library list.
+                if ((heap || startup) && sanitize)
+                {
+                    fmt::print_error_line("Error: --heap and --startup can't be combined with"
+                                          " --sanitize");
+                    return constant::exit::failure;
+                }
+
+                if (timeout_seconds && (heap || profile || startup))
+                {
+                    fmt::print_error_line(
+                        "Error: --timeout can't be combined with --heap, --profile or --startup");
+                    return constant::exit::failure;
+                }
+
+                const bool use_scratch = opts.option('a').is_set();
+                if (use_scratch && (heap || profile || startup))
+                {
+                    fmt::print_error_line(
+                        "Error: --scratch can't be combined with --heap, --profile or --startup");
+                    return constant::exit::failure;
+                }
+
+                gen.set_frame_pointers(heap || profile);
+                gen.set_optimize(optimize);
+                gen.set_sanitize(sanitize);
+                gen.set_time_execution(time_execution);
+                gen.set_verbose_level(verbose_level);
+
+                // Makefile
+
+                const str makefile = app::temporary_file_name(".mk");
+
+                // Compiler & macros.
+
+                const cstrview compiler = opts.option('c').values().back().value_or_default();
+                const cstrview macros   = opts.option('d').values().back().value_or_default();
+                if (!gen.setup_compiler_and_macros(compiler, macros))
+                {
+                    return constant::exit::failure;
+                }
+
+                app::record_compile_times(gen, program_name);
+
+                // Source
+
+                auto app_src         = args.front().value().to<str>();
+                const str spawn_path = concat("./", app_src.view_offset(0, -3)); // Drop ".cc".
+
+                if (!gen.add_application(app_src))
+                {
+                    return constant::exit::failure;
+                }
+
+                args.drop_front_n(1);
+
+                // Make sure that the application wasn't ignored.
+                if (gen.applications().is_empty())
+                {
+                    fmt::print_error_line("Error: No application source files to process");
+                    return constant::exit::failure;
+                }
+
+                // Parse, generate & run.
+
+                if (gen.parse())
+                {
+                    const str makefile_depend; // Empty (don't generate).
+
+                    if (gen.generate(makefile, makefile_depend))
+                    {
+                        app::make(makefile, "clean", verbose_level);
+
+                        int exit_status = app::make(makefile, "all", verbose_level);
+
+                        if (exit_status == constant::exit::success)
+                        {
+                            vec<str> spawn_args{container::reserve, args.count()};
+
+                            for (const auto& arg : args)
+                            {
+                                spawn_args.append(arg.to<str>());
+                            }
+
+                            if (verbose_level >= 1)
+                            {
+                                if (spawn_args)
+                                {
+                                    fmt::print_error_line("{} ...", spawn_path);
+                                }
+                                else
+                                {
+                                    fmt::print_error_line("{}", spawn_path);
+                                }
+                            }
+
+                            if (profile)
+                            {
+                                exit_status = app::profile(spawn_path, spawn_args);
+                            }
+                            else if (heap)
+                            {
+                                const str library = app::temporary_file_name(".so");
+                                if (preload::build(gen.compiler(), preload::heap_source, library,
+                                                   verbose_level))
+                                {
+                                    exit_status = app::spawn_with_heap_report(spawn_path,
+                                                                              spawn_args, library);
+                                    file::remove(library).or_throw();
+                                }
+                                else
+                                {
+                                    exit_status = constant::exit::failure;
+                                }
+                            }
+                            else if (startup)
+                            {
+                                const str library = app::temporary_file_name(".so");
+                                if (preload::build(gen.compiler(), preload::startup_source,
+                                                   library, verbose_level))
+                                {
+                                    exit_status = app::spawn_with_startup_report(
+                                        spawn_path, spawn_args, library, gen.libraries(app_src));
+                                    file::remove(library).or_throw();
+                                }
+                                else
+                                {
+                                    exit_status = constant::exit::failure;
+                                }
+                            }
+                            else
+                            {
+                                // An annotation (`[#test:timeout=seconds]`) overrides `--timeout`.
+                                u64 timeout_ns = gen.test_annotations(app_src).timeout_ns;
+                                if (timeout_ns == 0)
+                                {
+                                    timeout_ns = timeout.value();
+                                }
+
+                                str scratch_dir;
+                                vec<str> environment;
+                                if (use_scratch)
+                                {
+                                    environment = app::create_scratch(scratch::base_directory(),
+                                                                      scratch_dir);
+                                }
+
+                                resources::usage usage;
+                                if (timeout_ns > 0)
+                                {
+                                    exit_status = app::spawn_with_timeout(
+                                        spawn_path, spawn_args, environment, timeout_ns, usage);
+                                }
+                                else
+                                {
+                                    exit_status =
+                                        app::spawn(spawn_path, spawn_args, environment, usage);
+                                }
+
+                                app::finish_scratch(scratch_dir,
+                                                    exit_status == constant::exit::success);
+
+                                if (resource_usage)
+                                {
+                                    resources::table table;
+                                    table.add(spawn_path, usage);
+                                    file::standard::error{}
+                                        << table.format(resources::column::wall);
+                                }
+                            }
+                        }
+
+                        app::make(makefile, "clean", verbose_level);
+
+                        if (verbose_level >= 3)
+                        {
+                            fmt::print_error_line("Deleting: {}", makefile);
+                        }
+                        file::remove(makefile).or_throw();
+
+                        return exit_status;
+                    }
+                }
+            }
+            else
+            {
+                strbuf usage{container::reserve, 600};
+
+                usage << "Usage: " << program_name << " run [options] [--] app.cc [arguments]\n";
+
+                usage << '\n';
+
+                usage << "Options:\n";
+                usage << "-o --optimize            Optimize (-O2)\n";
+                usage << "-h --heap                Count allocations and report top allocation"
+                         " sites\n";
+                usage << "-p --profile             Sample the application and write folded stacks"
+                         " (Linux)\n";
+                usage << "-u --startup             Measure loader, static initializer and exit"
+                         " time\n";
+                usage << "-e --resources           Report resource usage (CPU, memory, faults,"
+                         " context switches, I/O)\n";
+                usage << "-x --timeout seconds     Kill the application (after a stack dump) if it"
+                         " runs longer\n";
+                usage << "-a --scratch             Private TMPDIR (on tmpfs if available), kept if"
+                         " it fails\n";
+                usage << "-t --time-execution      Time command execution (implies verbose)\n";
+                usage << "-s --sanitize            Enable sanitizers (Address & "
+                         "UndefinedBehavior)\n";
+                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
+                      << ")\n";
+                usage << "-d --define MACRO[,...]  Define macro(s)\n";
+                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+
+                usage << '\n';
+
+                usage << "Verbosity levels:\n";
+                usage << "1. Show compile/run commands\n";
+                usage << "2. Show all commands\n";
+                usage << "3. Debug\n";
+
+                file::standard::error{} << usage;
+            }
+
+            return constant::exit::failure;
+        }
+
+        int runall(const cstrview program_name, const array_view<const env::argument> arguments)
+        {
+            env::options opts{arguments,
+                              {
+                                  {"bundle", 'b', env::option::takes_values},
+                                  {"cgroup", 'i', env::option::takes_values},
+                                  {"changed-files", 'f', env::option::takes_values},
+                                  {"changed-since", 'r', env::option::takes_values},
+                                  {"compiler", 'c', env::option::takes_values},
+                                  {"define", 'd', env::option::takes_values},
+                                  {"heap", 'h'},
+                                  {"jobs", 'j', env::option::takes_values},
+                                  {"json", 'w', env::option::takes_values},
+                                  {"no-cache", 'n'},
+                                  {"optimize", 'o'},
+                                  {"resources", 'e'},
+                                  {"sanitize", 's'},
+                                  {"scratch", 'a'},
+                                  {"shard", 'k', env::option::takes_values},
+                                  {"slowdown", 'l', env::option::takes_values},
+                                  {"sort", 'y', env::option::takes_values},
+                                  {"time-execution", 't'},
+                                  {"timeout", 'x', env::option::takes_values},
+                                  {"total-timeout", 'g', env::option::takes_values},
+                                  {"verbose", 'v'},
+                              },
+                              promise::is_sorted};
+
+            if (!opts)
+            {
+                fmt::print_error_line("Error: {}", opts.error_message());
+                return constant::exit::failure;
+            }
+
+            app::generator gen;
+
+            const auto args = opts.arguments();
+            if (args.count() >= 1)
+            {
+                const bool heap           = opts.option('h').is_set();
+                const bool no_cache       = opts.option('n').is_set();
+                const bool optimize       = opts.option('o').is_set();
+                const bool sanitize       = opts.option('s').is_set();
+                const bool time_execution = opts.option('t').is_set();
+                auto verbose_level        = opts.option('v').count();
+
+                if (time_execution)
+                {
+                    verbose_level = math::max(verbose_level, 1);
+                }
+
+                const cstrview since = opts.option('r').values().back().value_or_default();
+                const bool select    = opts.option('f').is_set() || opts.option('r').is_set();
+
+                if (opts.option('r').is_set() && !validator::is_git_revision(since))
+                {
+                    fmt::print_error_line("Error: Invalid git revision: {}", since);
+                    return constant::exit::failure;
+                }
+
+                usize concurrency        = 1;
+                const cstrview job_count = opts.option('j').values().back().value_or_default();
+                if (job_count)
+                {
+                    const auto n = number::parse(job_count);
+                    if (!n || n.value() == 0)
+                    {
+                        fmt::print_error_line("Error: Invalid number of jobs: {}", job_count);
+                        return constant::exit::failure;
+                    }
+                    concurrency = n.value();
+                }
+
+                usize bundle_size           = 0; // Not bundled.
+                const cstrview bundle_count = opts.option('b').values().back().value_or_default();
+                if (opts.option('b').is_set())
+                {
+                    const auto n = number::parse(bundle_count);
+                    if (!n || n.value() == 0)
+                    {
+                        fmt::print_error_line("Error: Invalid bundle size: {}", bundle_count);
+                        return constant::exit::failure;
+                    }
+                    bundle_size = n.value();
+                }
+
+                if (heap && bundle_size > 0)
+                {
+                    fmt::print_error_line("Error: --heap can't be combined with --bundle");
+                    return constant::exit::failure;
+                }
+
+                // The sanitizer runtime must be first in the initial library list.
+                if (heap && sanitize)
+                {
+                    fmt::print_error_line("Error: --heap can't be combined with --sanitize");
+                    return constant::exit::failure;
+                }
+
+                // `--sort` implies `--resources`.
+                optional<resources::column> resources_sort;
+                if (opts.option('e').is_set() || opts.option('y').is_set())
+                {
+                    resources_sort = app::resources_column(
+                        opts.option('y').values().back().value_or(cstrview{"wall"}));
+                    if (!resources_sort)
+                    {
+                        return constant::exit::failure;
+                    }
+
+                    // Interposed allocations distort the numbers.
+                    if (heap)
+                    {
+                        fmt::print_error_line("Error: --heap can't be combined with --resources");
+                        return constant::exit::failure;
+                    }
+                }
+
+                const auto timeout =
+                    app::timeout_ns(opts.option('x').values().back().value_or_default());
+                const auto total_timeout =
+                    app::timeout_ns(opts.option('g').values().back().value_or_default());
+                if (!timeout || !total_timeout)
+                {
+                    return constant::exit::failure;
+                }
+
+                // Applications are run one at a time with the heap report.
+                if (heap && (timeout.value() > 0 || total_timeout.value() > 0))
+                {
+                    fmt::print_error_line(
+                        "Error: --heap can't be combined with --timeout or --total-timeout");
+                    return constant::exit::failure;
+                }
+
+                const bool use_scratch = opts.option('a').is_set();
+                if (heap && use_scratch)
+                {
+                    fmt::print_error_line("Error: --heap can't be combined with --scratch");
+                    return constant::exit::failure;
+                }
+
+                u64 slowdown = 50; // Percent.
+                const cstrview slowdown_percent =
+                    opts.option('l').values().back().value_or_default();
+                if (slowdown_percent)
+                {
+                    const auto n = number::parse(slowdown_percent);
+                    if (!n)
+                    {
+                        fmt::print_error_line("Error: Invalid slowdown percent: {}",
+                                              slowdown_percent);
+                        return constant::exit::failure;
+                    }
+                    slowdown = n.value();
+                }
+
+                const cstrview json_file  = opts.option('w').values().back().value_or_default();
+                const cstrview shard_spec = opts.option('k').values().back().value_or_default();
+
+                optional<shard::spec> sharding;
+                if (opts.option('k').is_set())
+                {
+                    sharding = shard::parse(shard_spec);
+                    if (!sharding)
+                    {
+                        fmt::print_error_line("Error: Invalid shard (expected K/N): {}",
+                                              shard_spec);
+                        return constant::exit::failure;
+                    }
+                }
+
+                gen.set_frame_pointers(heap);
+                gen.set_optimize(optimize);
+                gen.set_sanitize(sanitize);
+                gen.set_time_execution(time_execution);
+                gen.set_verbose_level(verbose_level);
+
+                // Makefile
+
+                const str makefile = app::temporary_file_name(".mk");
+
+                // Compiler & macros.
+
+                const cstrview compiler = opts.option('c').values().back().value_or_default();
+                const cstrview macros   = opts.option('d').values().back().value_or_default();
+                if (!gen.setup_compiler_and_macros(compiler, macros))
+                {
+                    return constant::exit::failure;
+                }
+
+                app::record_compile_times(gen, program_name);
+
+                cgroup::tree cgroups;
+                if (opts.option('i').is_set() &&
+                    !app::setup_cgroups(gen, cgroups, program_name,
+                                        opts.option('i').values().back().value_or_default()))
+                {
+                    return constant::exit::failure;
+                }
+
+                // Sources
+
+                for (const auto arg : args)
+                {
+                    if (!gen.add_application(arg.to<str>()))
+                    {
+                        return constant::exit::failure;
+                    }
+                }
+
+                if (gen.applications().is_empty())
+                {
+                    fmt::print_error_line("Error: No application source files to process");
+                    return constant::exit::failure;
+                }
+
+                // Changed files (before parsing, no need to parse if git fails).
+
+                vec<str> changed;
+                for (const auto value : opts.option('f').values())
+                {
+                    for (const cstrview path : string::range::split{value, ','})
+                    {
+                        if (path)
+                        {
+                            changed.append(str{path});
+                        }
+                    }
+                }
+
+                if (since && !app::git_changed_files(since, verbose_level, changed))
+                {
+                    return constant::exit::failure;
+                }
+
+                // Parse, select, generate & run.
+
+                if (gen.parse())
+                {
+                    if (select)
+                    {
+                        const usize total = gen.applications().count();
+                        auto selection    = gen.affected_applications(changed);
+
+                        if (verbose_level >= 1)
+                        {
+                            fmt::print_error_line("Selected: {} of {} (changed files: {})",
+                                                  selection.count(), total, changed.count());
+                            for (const auto& source : selection)
+                            {
+                                fmt::print_error_line("  {}", source);
+                            }
+                        }
+
+                        gen.select_applications(std::move(selection));
+                    }
+
+                    // Only build the objects that the applications in this shard need. The
+                    // applications the shards are selected from are written with the results, so
+                    // that `results` can tell if the shards together ran them all.
+                    results::merged run_results;
+                    if (sharding)
+                    {
+                        run_results.select(str{shard_spec}, gen.applications());
+
+                        const usize total = gen.applications().count();
+                        auto selection    = app::shard_applications(gen, sharding.value());
+
+                        fmt::print_error_line("Shard: {}, {} of {} applications", shard_spec,
+                                              selection.count(), total);
+
+                        if (verbose_level >= 1)
+                        {
+                            for (const auto& source : selection)
+                            {
+                                fmt::print_error_line("  {}", source);
+                            }
+                        }
+
+                        gen.select_applications(std::move(selection));
+                    }
+
+                    if (gen.applications().is_empty())
+                    {
+                        // Nothing affected or an empty shard.
+                        if (json_file && !app::write_results(json_file, run_results))
+                        {
+                            return constant::exit::failure;
+                        }
+                        return constant::exit::success;
+                    }
+
+                    if (bundle_size > 0)
+                    {
+                        auto groups = bundle::partition(gen.applications(), bundle_size);
+
+                        usize bundled = 0;
+                        for (const auto& g : groups)
+                        {
+                            bundled += g.tests.count();
+                        }
+                        fmt::print_error_line("Bundles: {} (tests: {} of {})", groups.count(),
+                                              bundled, gen.applications().count());
+
+                        gen.set_bundles(std::move(groups));
+                    }
+
+                    const str makefile_depend; // Empty (don't generate).
+
+                    if (gen.generate(makefile, makefile_depend))
+                    {
+                        // An annotation (`[#test:timeout=seconds]`) overrides `--timeout`.
+                        const auto timeout_of = [&](const cstrview source) {
+                            const u64 annotated = gen.test_annotations(source).timeout_ns;
+                            return annotated > 0 ? annotated : timeout.value();
+                        };
+
+                        // The driver of a bundle enforces the timeouts of its tests.
+                        int exit_status = constant::exit::success;
+                        for (const auto& b : gen.bundles())
+                        {
+                            if (verbose_level >= 3)
+                            {
+                                fmt::print_error_line("Generating: {}", b.driver);
+                            }
+
+                            vec<u64> timeouts{container::reserve, b.tests.count()};
+                            for (const auto& test : b.tests)
+                            {
+                                timeouts.append(timeout_of(test));
+                            }
+
+                            if (!file::write(b.driver, bundle::driver_source(timeouts)))
+                            {
+                                fmt::print_error_line("Error: Failed to write to: {}", b.driver);
+                                exit_status = constant::exit::failure;
+                            }
+                        }
+
+                        app::make(makefile, "clean", verbose_level);
+
+                        if (exit_status == constant::exit::success)
+                        {
+                            exit_status = app::make(makefile, "all", verbose_level);
+                        }
+
+                        str library;
+                        if (exit_status == constant::exit::success && heap)
+                        {
+                            library = app::temporary_file_name(".so");
+                            if (!preload::build(gen.compiler(), preload::heap_source, library,
+                                                verbose_level))
+                            {
+                                exit_status = constant::exit::failure;
+                            }
+                        }
+
+                        const auto keys        = app::timing_keys(gen);
+                        const str history_file = app::test_history_file(gen);
+                        auto history = app::read_timings<timings::test_history>(history_file);
+
+                        // Passing runs are cached (not with --heap, the report is the output, and
+                        // not with --bundle, the tests don't have executables of their own).
+                        const bool use_cache  = !heap && gen.bundles().is_empty();
+                        const str cache_file  = concat(gen.workspace_directory(), "/test-cache");
+                        const u64 environment = app::environment_digest();
+                        usize cached          = 0;
+                        cache::test_results cache_results;
+                        if (use_cache)
+                        {
+                            strbuf contents;
+                            if (file::read(cache_file, contents) && !cache_results.parse(contents))
+                            {
+                                fmt::print_error_line("Warning: Ignoring invalid test cache: {}",
+                                                      cache_file);
+                                cache_results = cache::test_results{};
+                            }
+                        }
+
+                        // Applications to run (without a cached passing run), in the same order
+                        // as the "run" target.
+                        struct pending final
+                        {
+                            cstrview source;
+                            str spawn_path;
+                            str key;
+                            optional<u64> digest;
+                            optional<timings::test_history::entry> usual;
+                        };
+
+                        // A job runs an application or a bundle of tests (with a report file).
+                        struct unit final
+                        {
+                            vec<usize> members; // Indexes in `to_run`.
+                            str report;
+                        };
+
+                        set::unsorted<cstrview> bundled;
+                        for (const auto& b : gen.bundles())
+                        {
+                            for (const auto& test : b.tests)
+                            {
+                                bundled.insert(test.view());
+                            }
+                        }
+
+                        // Scheduling hints (`[#test:threads=N]`, `[#test:memory=size]` and
+                        // `[#test:serial]`), a bundle needs what its most demanding test needs.
+                        const auto add_hints = [&](const cstrview source, jobs::job& job) {
+                            const auto t = gen.test_annotations(source);
+                            job.threads  = math::max(job.threads, t.threads);
+                            job.memory   = math::max(job.memory, t.memory);
+                            job.serial   = job.serial || t.serial;
+                        };
+
+                        vec<pending> to_run;
+                        vec<unit> units;
+                        vec<jobs::job> run_jobs;
+                        if (exit_status == constant::exit::success)
+                        {
+                            map::unsorted<cstrview, usize> positions;
+
+                            for (const auto& source : gen.applications())
+                            {
+                                str spawn_path = concat("./", source.view_offset(0, -3));
+
+                                optional<u64> digest;
+                                if (use_cache)
+                                {
+                                    digest = app::run_digest(spawn_path, {}, environment);
+                                }
+
+                                if (digest && !no_cache &&
+                                    cache_results.contains(digest.value(promise::has_value)))
+                                {
+                                    if (verbose_level >= 1)
+                                    {
+                                        fmt::print_error_line("{} (cached)", spawn_path);
+                                    }
+                                    run_results.add(results::entry{source, str{shard_spec},
+                                                                   str{results::cached}, 0});
+                                    ++cached;
+                                    continue;
+                                }
+
+                                str key          = keys.key(spawn_path);
+                                const auto usual = history.get(key);
+
+                                const usize position = to_run.count();
+                                if (bundled.contains(source.view()))
+                                {
+                                    positions.insert(source.view(), position);
+                                }
+                                else
+                                {
+                                    vec<usize> members;
+                                    members.append(position);
+                                    units.append(unit{std::move(members), str{}});
+
+                                    jobs::job job{spawn_path, {}, {}, timeout_of(source)};
+                                    add_hints(source, job);
+                                    run_jobs.append(std::move(job));
+                                }
+                                to_run.append(pending{source.view(), std::move(spawn_path),
+                                                      std::move(key), digest, usual});
+                            }
+
+                            for (const auto& b : gen.bundles())
+                            {
+                                // The driver times out each test, the bundle gets the sum of the
+                                // timeouts of its tests and some slack as a backstop, e.g. if the
+                                // driver itself hangs (none if a test has no timeout).
+                                unit u;
+                                u64 bundle_timeout = 0;
+                                bool all_timed     = true;
+                                for (const auto& test : b.tests)
+                                {
+                                    u.members.append(positions.get(test).value());
+
+                                    const u64 test_timeout = timeout_of(test);
+                                    bundle_timeout += test_timeout;
+                                    all_timed = all_timed && test_timeout > 0;
+                                }
+                                u.report = app::temporary_file_name(".bundle");
+
+                                vec<str> job_arguments;
+                                job_arguments.append(u.report);
+
+                                constexpr u64 slack_ns = 10'000'000'000;
+                                jobs::job job{concat("./", b.executable), std::move(job_arguments),
+                                              {}, all_timed ? bundle_timeout + slack_ns : 0};
+                                for (const auto& test : b.tests)
+                                {
+                                    add_hints(test, job);
+                                }
+                                run_jobs.append(std::move(job));
+                                units.append(std::move(u));
+                            }
+                        }
+
+                        // Estimates for the ETA (the average for applications without history).
+                        u64 known_total = 0;
+                        usize known     = 0;
+                        for (const auto& p : to_run)
+                        {
+                            if (p.usual)
+                            {
+                                known_total += p.usual.value().wall_ns;
+                                ++known;
+                            }
+                        }
+                        const u64 average_ns = known > 0 ? known_total / known : 0;
+
+                        vec<u64> estimates{container::reserve, to_run.count()};
+                        u64 remaining_ns = 0;
+                        for (const auto& p : to_run)
+                        {
+                            estimates.append(p.usual ? p.usual.value().wall_ns : average_ns);
+                            remaining_ns += estimates.back().value();
+                        }
+
+                        // Longest first (LPT) when running in parallel, jobs with applications
+                        // without history first (they could be long).
+                        if (concurrency > 1)
+                        {
+                            const auto is_known = [&](const usize job) {
+                                for (const usize m : units.at(job, promise::within_bounds).members)
+                                {
+                                    if (!to_run.at(m, promise::within_bounds).usual)
+                                    {
+                                        return false;
+                                    }
+                                }
+                                return true;
+                            };
+
+                            const auto estimate = [&](const usize job) {
+                                u64 total = 0;
+                                for (const usize m : units.at(job, promise::within_bounds).members)
+                                {
+                                    total += estimates.at(m, promise::within_bounds);
+                                }
+                                return total;
+                            };
+
+                            vec<usize> order{container::reserve, units.count()};
+                            for (usize i = 0; i < units.count(); ++i)
+                            {
+                                order.append(i);
+                            }
+
+                            algo::sort(order.range(), [&](const usize a, const usize b) {
+                                const bool x_known = is_known(a);
+                                const bool y_known = is_known(b);
+                                if (x_known != y_known)
+                                {
+                                    return !x_known;
+                                }
+                                const u64 x = estimate(a);
+                                const u64 y = estimate(b);
+                                if (x != y)
+                                {
+                                    return x > y;
+                                }
+                                return a < b;
+                            });
+
+                            vec<unit> ordered{container::reserve, units.count()};
+                            vec<jobs::job> ordered_jobs{container::reserve, run_jobs.count()};
+                            for (const usize i : order)
+                            {
+                                ordered.append(std::move(units.at(i, promise::within_bounds)));
+                                ordered_jobs.append(
+                                    std::move(run_jobs.at(i, promise::within_bounds)));
+                            }
+                            units    = std::move(ordered);
+                            run_jobs = std::move(ordered_jobs);
+                        }
+
+                        // A cgroup per job (`--cgroup`), not with --heap (run one at a time).
+                        if (cgroups.is_active() && !heap)
+                        {
+                            for (usize i = 0; i < run_jobs.count(); ++i)
+                            {
+                                str name = "job-";
+                                name << as_num(i);
+
+                                jobs::job& job = run_jobs.at(i, promise::within_bounds);
+                                job.cgroup     = cgroups.create(name);
+                                if (job.cgroup.is_empty())
+                                {
+                                    fmt::print_error_line("Warning: Failed to create cgroup: {}",
+                                                          name);
+                                    break;
+                                }
+                            }
+                        }
+
+                        // A scratch directory per job (`--scratch`), shared by the tests of a
+                        // bundle.
+                        vec<str> scratch_dirs;
+                        if (use_scratch)
+                        {
+                            const str base = scratch::base_directory();
+                            for (auto& job : run_jobs)
+                            {
+                                str dir;
+                                job.environment = app::create_scratch(base, dir);
+                                scratch_dirs.append(std::move(dir));
+                            }
+                        }
+
+                        if (verbose_level >= 1 && known > 0 && to_run.count() > 1)
+                        {
+                            fmt::print_error_line("Running {} (estimated: {} at -j{})",
+                                                  to_run.count(),
+                                                  report::duration(timings::makespan(
+                                                      estimates, concurrency)),
+                                                  concurrency);
+                        }
+
+                        vec<str> slower;
+                        usize finished = 0;
+                        resources::table resource_table;
+
+                        // Returns false on failure (no more applications are started). `start_ns`
+                        // is when the application (or bundled test) was started.
+                        const auto finish = [&](const usize index, const int status,
+                                                const u64 start_ns, const resources::usage& usage,
+                                                const bool timed_out) {
+                            const pending& p      = to_run.at(index, promise::within_bounds);
+                            const str& spawn_path = p.spawn_path;
+                            const bool passed     = status == constant::exit::success && !timed_out;
+
+                            cstrview result_status = passed ? results::passed : results::failed;
+                            if (timed_out)
+                            {
+                                result_status = results::timed_out;
+                            }
+
+                            trace::global().add("test", "test", spawn_path, start_ns,
+                                                usage.wall_ns);
+                            run_results.add(results::entry{str{p.source}, str{shard_spec},
+                                                           str{result_status}, usage.wall_ns,
+                                                           usage});
+
+                            if (resources_sort)
+                            {
+                                resource_table.add(spawn_path, usage);
+                            }
+
+                            if (!passed)
+                            {
+                                if (exit_status == constant::exit::success)
+                                {
+                                    exit_status = timed_out ? constant::exit::failure : status;
+                                }
+                                return false;
+                            }
+
+                            ++finished;
+                            remaining_ns -= math::min(remaining_ns,
+                                                      estimates.at(index, promise::within_bounds));
+
+                            if (verbose_level >= 1)
+                            {
+                                str eta;
+                                if (known > 0 && finished < to_run.count())
+                                {
+                                    eta << ", ETA " << report::duration(remaining_ns / concurrency);
+                                }
+                                fmt::print_error_line("{} ({}{})", spawn_path,
+                                                      report::duration(usage.wall_ns), eta);
+                            }
+
+                            // Not with --heap (interposed allocations are slower).
+                            if (!heap)
+                            {
+                                if (p.usual && timings::is_slower(p.usual.value().wall_ns,
+                                                                  usage.wall_ns, slowdown))
+                                {
+                                    str line;
+                                    line << spawn_path << ' ' << report::duration(usage.wall_ns)
+                                         << " (usual: " << report::duration(p.usual.value().wall_ns)
+                                         << ')';
+                                    slower.append(std::move(line));
+                                }
+
+                                history.add(p.key, timings::test_history::entry{
+                                                       usage.wall_ns, usage.cpu_ns(),
+                                                       usage.max_rss, 0});
+                            }
+
+                            if (p.digest)
+                            {
+                                cache_results.add(p.digest.value(promise::has_value),
+                                                  static_cast<u64>(std::time(nullptr)),
+                                                  spawn_path);
+                            }
+
+                            return true;
+                        };
+
+                        // Returns false on failure. A bundle has a result for each of its tests
+                        // that ran (it stops at the first failure, the driver times out its
+                        // tests), if the bundle itself timed out the test that was running timed
+                        // out.
+                        const auto finish_job = [&](const usize index, const int status,
+                                                    const resources::usage& usage,
+                                                    const bool timed_out) {
+                            const unit& u = units.at(index, promise::within_bounds);
+                            if (u.report.is_empty())
+                            {
+                                return finish(u.members.at(0, promise::within_bounds), status,
+                                              clock::monotonic() - usage.wall_ns, usage,
+                                              timed_out);
+                            }
+
+                            strbuf contents;
+                            optional<vec<bundle::outcome>> outcomes;
+                            optional<bundle::running_test> hung;
+                            if (file::read(u.report, contents))
+                            {
+                                outcomes = bundle::parse_report(contents, u.members.count());
+                                if (timed_out)
+                                {
+                                    hung = bundle::running(contents);
+                                }
+                            }
+                            if (file::is_something(u.report))
+                            {
+                                file::remove(u.report).or_throw();
+                            }
+
+                            const str& path = run_jobs.at(index, promise::within_bounds).path;
+                            if (!outcomes)
+                            {
+                                fmt::print_error_line("Error: No valid report from: {}", path);
+                                if (exit_status == constant::exit::success)
+                                {
+                                    exit_status = constant::exit::failure;
+                                }
+                                return false;
+                            }
+
+                            bool ok = true;
+                            for (const auto& o : outcomes.value())
+                            {
+                                const usize member = u.members.at(o.index, promise::within_bounds);
+                                const str& spawn_path =
+                                    to_run.at(member, promise::within_bounds).spawn_path;
+                                if (o.timed_out)
+                                {
+                                    fmt::print_error_line("Error: Timed out after {}: {}",
+                                                          report::duration(o.usage.wall_ns),
+                                                          spawn_path);
+                                }
+                                else if (o.signal != 0)
+                                {
+                                    fmt::print_error_line(
+                                        "Error: Exited abnormally: {} (signal {})", spawn_path,
+                                        o.signal);
+                                }
+
+                                int test_status = constant::exit::success;
+                                if (!o.passed())
+                                {
+                                    test_status = o.exit_status != 0 ? o.exit_status
+                                                                     : constant::exit::failure;
+                                }
+                                ok = finish(member, test_status, o.start_ns, o.usage,
+                                            o.timed_out) &&
+                                     ok;
+                            }
+
+                            if (hung && hung.value().index < u.members.count())
+                            {
+                                const usize member =
+                                    u.members.at(hung.value().index, promise::within_bounds);
+                                const u64 start_ns = hung.value().start_ns;
+                                const u64 now      = clock::monotonic();
+
+                                resources::usage usage;
+                                usage.wall_ns = now - math::min(start_ns, now);
+                                ok = finish(member, constant::exit::failure, start_ns, usage,
+                                            true) &&
+                                     ok;
+                            }
+
+                            // E.g. the report file couldn't be written.
+                            if (ok && status != constant::exit::success)
+                            {
+                                fmt::print_error_line("Error: Bundle failed: {}", path);
+                                if (exit_status == constant::exit::success)
+                                {
+                                    exit_status = status;
+                                }
+                                return false;
+                            }
+
+                            return ok;
+                        };
+
+                        if (heap)
+                        {
+                            // One at a time, each report is printed when the application exits.
+                            for (const auto [index, job] : run_jobs.range() | range::v::enumerate{})
+                            {
+                                if (verbose_level >= 1)
+                                {
+                                    fmt::print_error_line("{}", job.path);
+                                }
+
+                                const u64 start  = clock::monotonic();
+                                const int status = app::spawn_with_heap_report(
+                                    job.path, job.arguments, library);
+
+                                resources::usage usage;
+                                usage.wall_ns = clock::monotonic() - start;
+                                if (!finish_job(index, status, usage, false))
+                                {
+                                    break;
+                                }
+                            }
+                        }
+                        else
+                        {
+                            // A hung test in a bundle is found from the report of the bundle.
+                            const auto on_timeout = [&](const usize index, const pid_t pid,
+                                                        const u64 elapsed_ns) {
+                                const unit& u = units.at(index, promise::within_bounds);
+                                strbuf contents;
+                                if (u.report && file::read(u.report, contents))
+                                {
+                                    const auto hung = bundle::running(contents);
+                                    if (hung && hung.value().index < u.members.count())
+                                    {
+                                        const usize member = u.members.at(
+                                            hung.value().index, promise::within_bounds);
+                                        app::report_timeout(
+                                            to_run.at(member, promise::within_bounds).spawn_path,
+                                            hung.value().pid, elapsed_ns);
+                                        return;
+                                    }
+                                }
+                                app::report_timeout(run_jobs.at(index, promise::within_bounds).path,
+                                                    pid, elapsed_ns);
+                            };
+
+                            const u64 deadline_ns =
+                                total_timeout.value() > 0
+                                    ? clock::monotonic() + total_timeout.value()
+                                    : 0;
+
+                            const auto job_results = jobs::run(
+                                run_jobs, concurrency, deadline_ns,
+                                [&](const usize index, const jobs::result& r) {
+                                    const str& path =
+                                        run_jobs.at(index, promise::within_bounds).path;
+                                    if (r.error_number != 0)
+                                    {
+                                        fmt::print_error_line("Error: Failed to execute: {}"
+                                                              " (errno {})",
+                                                              path, r.error_number);
+                                    }
+                                    else if (r.out_of_memory)
+                                    {
+                                        fmt::print_error_line("Error: Out of memory (cgroup"
+                                                              " memory.max): {}",
+                                                              path);
+                                    }
+                                    else if (!r.exited_normally && !r.timed_out)
+                                    {
+                                        fmt::print_error_line("Error: Exited abnormally: {}",
+                                                              path);
+                                    }
+                                    const bool ok = finish_job(index, r.exit_status, r.usage,
+                                                               r.timed_out);
+                                    if (use_scratch)
+                                    {
+                                        app::finish_scratch(
+                                            scratch_dirs.at(index, promise::within_bounds), ok);
+                                    }
+                                    return ok;
+                                },
+                                on_timeout);
+
+                            // Jobs that were never started.
+                            for (usize i = 0; i < scratch_dirs.count(); ++i)
+                            {
+                                if (job_results.at(i, promise::within_bounds).error_number ==
+                                    ECANCELED)
+                                {
+                                    app::finish_scratch(scratch_dirs.at(i, promise::within_bounds),
+                                                        true);
+                                }
+                            }
+
+                            if (deadline_ns > 0 && clock::monotonic() >= deadline_ns &&
+                                run_results.count() < gen.applications().count())
+                            {
+                                fmt::print_error_line("Error: Total timeout ({}) exceeded, not"
+                                                      " run: {}",
+                                                      report::duration(total_timeout.value()),
+                                                      gen.applications().count() -
+                                                          run_results.count());
+                                exit_status = constant::exit::failure;
+                            }
+                        }
+
+                        if (resource_table.count() > 0)
+                        {
+                            file::standard::error{}
+                                << resource_table.format(resources_sort.value());
+                        }
+
+                        if (!slower.is_empty())
+                        {
+                            fmt::print_error_line("Slower than usual (by more than {}%):",
+                                                  slowdown);
+                            for (const auto& line : slower)
+                            {
+                                fmt::print_error_line("  {}", line);
+                            }
+                        }
+
+                        if (cached > 0)
+                        {
+                            fmt::print_error_line("Cached: {} of {} (--no-cache runs all)", cached,
+                                                  gen.applications().count());
+                        }
+
+                        if (json_file)
+                        {
+                            // Build failure or stopped at the first failure.
+                            for (const auto& source : gen.applications())
+                            {
+                                if (!run_results.contains(source))
+                                {
+                                    run_results.add(results::entry{source, str{shard_spec},
+                                                                   str{results::not_run}, 0});
+                                }
+                            }
+
+                            if (!app::write_results(json_file, run_results))
+                            {
+                                exit_status = constant::exit::failure;
+                            }
+                        }
+
+                        if (history.is_modified() &&
+                            (!app::create_directory(gen.workspace_directory()) ||
+                             !file::write(history_file, history.serialize())))
+                        {
+                            fmt::print_error_line("Warning: Failed to write test history: {}",
+                                                  history_file);
+                        }
+
+                        if (cache_results.is_modified())
+                        {
+                            constexpr usize max_entries = 10'000;
+
+                            if (!app::create_directory(gen.workspace_directory()) ||
+                                !file::write(cache_file, cache_results.serialize(max_entries)))
+                            {
+                                fmt::print_error_line("Warning: Failed to write test cache: {}",
+                                                      cache_file);
+                            }
+                        }
+
+                        if (library && file::is_something(library))
+                        {
+                            file::remove(library).or_throw();
+                        }
 
-                if (gen.applications().is_empty())
-                {
-                    fmt::print_error_line("Error: No application source files to process");
-                    return constant::exit::failure;
-                }
+                        app::make(makefile, "clean", verbose_level);
 
-                // Parse & generate.
+                        for (const auto& b : gen.bundles())
+                        {
+                            if (file::is_something(b.driver))
+                            {
+                                file::remove(b.driver).or_throw();
+                            }
+                        }
 
-                if (gen.parse())
-                {
-                    const str makefile_depend = concat(makefile, ".depend");
+                        if (verbose_level >= 3)
+                        {
+                            fmt::print_error_line("Deleting: {}", makefile);
+                        }
+                        file::remove(makefile).or_throw();
 
-                    if (gen.generate(makefile, makefile_depend))
-                    {
-                        return constant::exit::success;
+                        return exit_status;
                     }
                 }
             }
@@ -1414,17 +5987,45 @@ namespace snn::app
             {
                 strbuf usage{container::reserve, 600};
 
-                usage << "Usage: " << program_name << " gen [options] [--] app.cc [...]\n";
+                usage << "Usage: " << program_name << " runall [options] [--] app.cc [...]\n";
 
                 usage << '\n';
 
                 usage << "Options:\n";
-                usage << "-f --makefile file       Write to file instead of \"makefile\"\n";
                 usage << "-o --optimize            Optimize (-O2)\n";
+                usage << "-h --heap                Count allocations and report top allocation"
+                         " sites\n";
+                usage << "-n --no-cache            Run all applications (ignore cached passing"
+                         " runs)\n";
+                usage << "-j --jobs N              Run N applications in parallel, longest first"
+                         " (default: 1)\n";
+                usage << "-b --bundle N            Link up to N tests (*.test.cc) of a directory"
+                         " into one executable\n";
+                usage << "-l --slowdown percent    Report applications that are slower than usual"
+                         " (default: 50)\n";
+                usage << "-e --resources           Report resource usage (CPU, memory, faults,"
+                         " context switches, I/O)\n";
+                usage << "-y --sort column         Sort resource usage by: wall (default), cpu,"
+                         " rss, faults, switches, io\n";
+                usage << "-x --timeout seconds     Kill an application (after a stack dump) if it"
+                         " runs longer\n";
+                usage << "-g --total-timeout sec   Stop running applications after this many"
+                         " seconds\n";
+                usage << "-i --cgroup limits       Run each job in a cgroup with limits, e.g."
+                         " memory=2G,cpu=150 (Linux)\n";
+                usage << "-a --scratch             Private TMPDIR per job (on tmpfs if available),"
+                         " kept on failure\n";
+                usage << "-k --shard K/N           Only build and run shard K of N (balanced by"
+                         " recorded times)\n";
+                usage << "-w --json file           Write results as JSON Lines (see: "
+                      << program_name << " results)\n";
+                usage << "-r --changed-since rev   Only run applications affected by files changed"
+                         " since a git revision\n";
+                usage << "-f --changed-files list  Only run applications affected by the files"
+                         " (comma-separated)\n";
                 usage << "-t --time-execution      Time command execution (implies verbose)\n";
                 usage << "-s --sanitize            Enable sanitizers (Address & "
                          "UndefinedBehavior)\n";
-                usage << "-z --fuzz                Build libFuzzer binary (implies sanitizers)\n";
                 usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
                       << ")\n";
                 usage << "-d --define MACRO[,...]  Define macro(s)\n";
@@ -1443,16 +6044,17 @@ namespace snn::app
             return constant::exit::failure;
         }
 
-        int run(const cstrview program_name, const array_view<const env::argument> arguments)
+        int size_report(const cstrview program_name,
+                        const array_view<const env::argument> arguments)
         {
             env::options opts{arguments,
                               {
+                                  {"base", 'b', env::option::takes_values},
                                   {"compiler", 'c', env::option::takes_values},
                                   {"define", 'd', env::option::takes_values},
                                   {"optimize", 'o'},
-                                  {"sanitize", 's'},
-                                  {"time-execution", 't'},
                                   {"verbose", 'v'},
+                                  {"write", 'w', env::option::takes_values},
                               },
                               promise::is_sorted};
 
@@ -1464,27 +6066,34 @@ namespace snn::app
 
             app::generator gen;
 
-            auto args = opts.arguments();
-            if (args.count() >= 1)
+            const auto args = opts.arguments();
+            if (args.count() == 1)
             {
-                const bool optimize       = opts.option('o').is_set();
-                const bool sanitize       = opts.option('s').is_set();
-                const bool time_execution = opts.option('t').is_set();
-                auto verbose_level        = opts.option('v').count();
+                constexpr usize top = 20;
 
-                if (time_execution)
-                {
-                    verbose_level = math::max(verbose_level, 1);
-                }
+                const bool optimize      = opts.option('o').is_set();
+                const auto verbose_level = opts.option('v').count();
+                const cstrview base      = opts.option('b').values().back().value_or_default();
+                const cstrview write     = opts.option('w').values().back().value_or_default();
 
                 gen.set_optimize(optimize);
-                gen.set_sanitize(sanitize);
-                gen.set_time_execution(time_execution);
                 gen.set_verbose_level(verbose_level);
 
+                // Read the base first, no need to build if it's invalid.
+                size::breakdown base_breakdown;
+                if (base)
+                {
+                    strbuf contents;
+                    if (!file::read(base, contents) || !base_breakdown.parse(contents))
+                    {
+                        fmt::print_error_line("Error: Invalid size file: {}", base);
+                        return constant::exit::failure;
+                    }
+                }
+
                 // Makefile
 
-                const str makefile = app::temporary_makefile_name();
+                const str makefile = app::temporary_file_name(".mk");
 
                 // Compiler & macros.
 
@@ -1497,24 +6106,21 @@ namespace snn::app
 
                 // Source
 
-                auto app_src         = args.front().value().to<str>();
-                const str spawn_path = concat("./", app_src.view_offset(0, -3)); // Drop ".cc".
+                const auto app_src   = args.front().value().to<str>();
+                const str executable = app_src.view_offset(0, -3); // Drop ".cc".
 
-                if (!gen.add_application(std::move(app_src)))
+                if (!gen.add_application(app_src))
                 {
                     return constant::exit::failure;
                 }
 
-                args.drop_front_n(1);
-
-                // Make sure that the application wasn't ignored.
                 if (gen.applications().is_empty())
                 {
                     fmt::print_error_line("Error: No application source files to process");
                     return constant::exit::failure;
                 }
 
-                // Parse, generate & run.
+                // Parse, generate, build & analyze (before the object files are deleted).
 
                 if (gen.parse())
                 {
@@ -1528,29 +6134,43 @@ namespace snn::app
 
                         if (exit_status == constant::exit::success)
                         {
-                            vec<str> spawn_args{container::reserve, args.count()};
-
-                            for (const auto& arg : args)
+                            size::breakdown breakdown;
+                            if (app::size_breakdown(executable, gen.sources(app_src),
+                                                    gen.headers(app_src), breakdown))
                             {
-                                spawn_args.append(arg.to<str>());
-                            }
+                                strbuf out;
+                                fmt::format_append("Size: {}", out, promise::no_overlap,
+                                                   executable);
+                                if (base)
+                                {
+                                    fmt::format_append(" (compared with {})", out,
+                                                       promise::no_overlap, base);
+                                }
+                                out << "\n\n";
 
-                            if (verbose_level >= 1)
-                            {
-                                if (spawn_args)
+                                if (base)
                                 {
-                                    fmt::print_error_line("{} ...", spawn_path);
+                                    out << breakdown.format_diff(base_breakdown, top);
                                 }
                                 else
                                 {
-                                    fmt::print_error_line("{}", spawn_path);
+                                    out << breakdown.format(top);
                                 }
-                            }
+                                file::standard::out{} << out;
 
-                            exit_status = app::spawn(spawn_path, std::move(spawn_args));
+                                if (write && !file::write(write, breakdown.serialize()))
+                                {
+                                    fmt::print_error_line("Error: Failed to write to: {}", write);
+                                    exit_status = constant::exit::failure;
+                                }
+                            }
+                            else
+                            {
+                                exit_status = constant::exit::failure;
+                            }
                         }
 
-                        app::make(makefile, "clean", verbose_level);
+                        app::make(makefile, "clean-object-files", verbose_level);
 
                         if (verbose_level >= 3)
                         {
@@ -1566,15 +6186,14 @@ namespace snn::app
             {
                 strbuf usage{container::reserve, 600};
 
-                usage << "Usage: " << program_name << " run [options] [--] app.cc [arguments]\n";
+                usage << "Usage: " << program_name << " size [options] [--] app.cc\n";
 
                 usage << '\n';
 
                 usage << "Options:\n";
                 usage << "-o --optimize            Optimize (-O2)\n";
-                usage << "-t --time-execution      Time command execution (implies verbose)\n";
-                usage << "-s --sanitize            Enable sanitizers (Address & "
-                         "UndefinedBehavior)\n";
+                usage << "-w --write file          Write the size breakdown to a file\n";
+                usage << "-b --base file           Compare with a breakdown written with --write\n";
                 usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
                       << ")\n";
                 usage << "-d --define MACRO[,...]  Define macro(s)\n";
@@ -1583,7 +6202,7 @@ namespace snn::app
                 usage << '\n';
 
                 usage << "Verbosity levels:\n";
-                usage << "1. Show compile/run commands\n";
+                usage << "1. Show compile commands\n";
                 usage << "2. Show all commands\n";
                 usage << "3. Debug\n";
 
@@ -1593,128 +6212,298 @@ namespace snn::app
             return constant::exit::failure;
         }
 
-        int runall(const cstrview program_name, const array_view<const env::argument> arguments)
+        // Internal command used by generated makefiles (see `record_compile_times()`): run a
+        // compile or link command and append its duration and output file to a timings file
+        // (unless it is "-").
+        int timed(const cstrview program_name, const array_view<const env::argument> arguments)
         {
-            env::options opts{arguments,
-                              {
-                                  {"compiler", 'c', env::option::takes_values},
-                                  {"define", 'd', env::option::takes_values},
-                                  {"optimize", 'o'},
-                                  {"sanitize", 's'},
-                                  {"time-execution", 't'},
-                                  {"verbose", 'v'},
-                              },
-                              promise::is_sorted};
+            // "timed" <file> <command> [arguments...]
+            if (arguments.count() < 3)
+            {
+                fmt::print_error_line("Usage: {} timed <file> <command> [arguments...]",
+                                      program_name);
+                return constant::exit::failure;
+            }
 
-            if (!opts)
+            auto rest = arguments;
+            rest.drop_front_n(1);
+            const str times_file = rest.front().value().to<str>();
+            rest.drop_front_n(1);
+            const str command = rest.front().value().to<str>();
+            rest.drop_front_n(1);
+
+            vec<str> spawn_args{container::reserve, rest.count()};
+            str target;
+            bool is_target = false;
+            for (const auto arg : rest)
             {
-                fmt::print_error_line("Error: {}", opts.error_message());
+                str a = arg.to<str>();
+                if (is_target)
+                {
+                    target = a;
+                }
+                is_target = a == "-o";
+                spawn_args.append(std::move(a));
+            }
+
+            const u64 start       = clock::monotonic();
+            const int exit_status = app::spawn(command, spawn_args);
+            const u64 duration    = clock::monotonic() - start;
+
+            // A single append, make can run several commands in parallel.
+            const auto append = [](const str& path, const str& line) {
+                const int fd = ::open(path.null_terminated().get(),
+                                      O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+                if (fd != -1)
+                {
+                    [[maybe_unused]] const auto written =
+                        ::write(fd, line.null_terminated().get(), line.size());
+                    ::close(fd);
+                }
+            };
+
+            if (exit_status == constant::exit::success && target && times_file != "-")
+            {
+                // The file is in "<workspace>/.snn/".
+                const timings::keys keys{app::current_directory(), concat(times_file, "/../..")};
+
+                str line;
+                line << as_num(duration) << '\t' << keys.key(target) << '\n';
+                append(times_file, line);
+            }
+
+            // Set by `snn --trace=file` (see `main()`).
+            if (const char* const events = std::getenv("SNN_TRACE_EVENTS"); events != nullptr)
+            {
+                const cstrview category = target.has_back(".o") ? "compile" : "link";
+                append(str{cstrview{events, std::strlen(events)}},
+                       trace::line("make", category, target ? target.view() : command.view(),
+                                   start, duration));
+            }
+
+            return exit_status;
+        }
+
+        // Internal command used by generated makefiles (see `setup_cgroups()`): run a compile or
+        // link command in a cgroup of its own with limits. The cgroup is a sibling of the leaf
+        // cgroup that snn moved itself (and `make`) into.
+        int cgroup_exec(const cstrview program_name,
+                        const array_view<const env::argument> arguments)
+        {
+            // "cgroup-exec" <limits> <command> [arguments...]
+            if (arguments.count() < 3)
+            {
+                fmt::print_error_line("Usage: {} cgroup-exec <limits> <command> [arguments...]",
+                                      program_name);
                 return constant::exit::failure;
             }
 
-            app::generator gen;
+            auto rest = arguments;
+            rest.drop_front_n(1);
+            const auto limits = cgroup::parse_limits(rest.front().value().to<cstrview>());
+            rest.drop_front_n(1);
+            const str command = rest.front().value().to<str>();
+            rest.drop_front_n(1);
 
-            const auto args = opts.arguments();
-            if (args.count() >= 1)
+            vec<str> spawn_args{container::reserve, rest.count()};
+            for (const auto arg : rest)
             {
-                const bool optimize       = opts.option('o').is_set();
-                const bool sanitize       = opts.option('s').is_set();
-                const bool time_execution = opts.option('t').is_set();
-                auto verbose_level        = opts.option('v').count();
+                spawn_args.append(arg.to<str>());
+            }
 
-                if (time_execution)
+            const auto own = cgroup::own_directory();
+            if (!limits || !own)
+            {
+                // Not isolated, but not a reason to fail the build.
+                return app::spawn(command, spawn_args);
+            }
+
+            // The parent of the leaf.
+            usize slash = 0;
+            for (const auto [i, c] : own.value().range() | range::v::enumerate{})
+            {
+                if (c == '/')
                 {
-                    verbose_level = math::max(verbose_level, 1);
+                    slash = i;
                 }
+            }
 
-                gen.set_optimize(optimize);
-                gen.set_sanitize(sanitize);
-                gen.set_time_execution(time_execution);
-                gen.set_verbose_level(verbose_level);
+            str dir{own.value().view(0, slash)};
+            dir << "/compile-" << as_num(::getpid());
+            if (!cgroup::create(dir, limits.value()))
+            {
+                return app::spawn(command, spawn_args);
+            }
 
-                // Makefile
+            const int exit_status = app::spawn(
+                str{cgroup::wrapper_path}, cgroup::wrapper_arguments(dir, command, spawn_args));
 
-                const str makefile = app::temporary_makefile_name();
+            if (cgroup::oom_kills(dir) > 0)
+            {
+                fmt::print_error_line("Error: Out of memory (cgroup memory.max): {}", command);
+            }
 
-                // Compiler & macros.
+            cgroup::remove(dir);
 
-                const cstrview compiler = opts.option('c').values().back().value_or_default();
-                const cstrview macros   = opts.option('d').values().back().value_or_default();
-                if (!gen.setup_compiler_and_macros(compiler, macros))
+            return exit_status;
+        }
+
+        int dispatch(const cstrview program_name, const array_view<const env::argument> arguments)
+        {
+            if (arguments)
+            {
+                const auto command = arguments.front().value().to<cstrview>();
+
+                if (command == "build")
                 {
-                    return constant::exit::failure;
+                    return app::build(program_name, arguments);
                 }
 
-                // Sources
+                if (command == "cgroup-exec")
+                {
+                    return app::cgroup_exec(program_name, arguments);
+                }
 
-                for (const auto arg : args)
+                if (command == "cover")
                 {
-                    if (!gen.add_application(arg.to<str>()))
-                    {
-                        return constant::exit::failure;
-                    }
+                    return app::cover(program_name, arguments);
                 }
 
-                if (gen.applications().is_empty())
+                if (command == "fuzz")
                 {
-                    fmt::print_error_line("Error: No application source files to process");
-                    return constant::exit::failure;
+                    return app::fuzz_command(program_name, arguments);
                 }
 
-                // Parse, generate & run.
+                if (command == "gen")
+                {
+                    return app::gen(program_name, arguments);
+                }
 
-                if (gen.parse())
+                if (command == "impact")
                 {
-                    const str makefile_depend; // Empty (don't generate).
+                    return app::impact(program_name, arguments);
+                }
 
-                    if (gen.generate(makefile, makefile_depend))
-                    {
-                        app::make(makefile, "clean", verbose_level);
+                if (command == "results")
+                {
+                    return app::results_report(program_name, arguments);
+                }
 
-                        const int exit_status = app::make(makefile, "run", verbose_level);
+                if (command == "run")
+                {
+                    return app::run(program_name, arguments);
+                }
 
-                        app::make(makefile, "clean", verbose_level);
+                if (command == "runall")
+                {
+                    return app::runall(program_name, arguments);
+                }
 
-                        if (verbose_level >= 3)
-                        {
-                            fmt::print_error_line("Deleting: {}", makefile);
-                        }
-                        file::remove(makefile).or_throw();
+                if (command == "size")
+                {
+                    return app::size_report(program_name, arguments);
+                }
 
-                        return exit_status;
-                    }
+                if (command == "timed")
+                {
+                    return app::timed(program_name, arguments);
                 }
             }
-            else
-            {
-                strbuf usage{container::reserve, 600};
 
-                usage << "Usage: " << program_name << " runall [options] [--] app.cc [...]\n";
+            strbuf usage{container::reserve, 600};
 
-                usage << '\n';
+            usage << "Usage: " << program_name
+                  << " [--trace=file] [--stats] <command> [arguments]\n";
 
-                usage << "Options:\n";
-                usage << "-o --optimize            Optimize (-O2)\n";
-                usage << "-t --time-execution      Time command execution (implies verbose)\n";
-                usage << "-s --sanitize            Enable sanitizers (Address & "
-                         "UndefinedBehavior)\n";
-                usage << "-c --compiler compiler   Compiler (default: " << gen.compiler_default()
-                      << ")\n";
-                usage << "-d --define MACRO[,...]  Define macro(s)\n";
-                usage << "-v --verbose             Increase verbosity (up to three times)\n";
+            usage << "\n";
 
-                usage << '\n';
+            usage << "Commands:\n";
+            usage << "build   Build one or more applications\n";
+            usage << "cover   Build and run applications and report source-based coverage\n";
+            usage << "fuzz    Build and run libFuzzer targets in parallel\n";
+            usage << "gen     Generate a makefile for one or more applications\n";
+            usage << "impact  List what depends on a file and estimate its rebuild time\n";
+            usage << "results Merge and summarize runall JSON results (e.g. from shards)\n";
+            usage << "run     Build and run a single application with optional arguments\n";
+            usage << "runall  Build and run one or more applications\n";
+            usage << "size    Build a single application and break down its binary size\n";
 
-                usage << "Verbosity levels:\n";
-                usage << "1. Show compile/run commands\n";
-                usage << "2. Show all commands\n";
-                usage << "3. Debug\n";
+            usage << "\n";
 
-                file::standard::error{} << usage;
-            }
+            usage << "Options:\n";
+            usage << "--trace=file  Write a timeline of the command (scans, make, compiles, tests)"
+                     " to file\n";
+            usage << "              in the Chrome trace event format (chrome://tracing,"
+                     " ui.perfetto.dev)\n";
+            usage << "--stats       Print the time snn spent in each phase (compiler probe, scans,"
+                     " make, ...)\n"
+                     "              and counters of its own work (files, file checks, makefile"
+                     " size, ...)\n";
+
+            usage << "\n";
+
+            usage << "For more information run a command without arguments, e.g.:\n";
+            usage << program_name << " build\n";
+
+            file::standard::error{} << usage;
 
             return constant::exit::failure;
         }
+
+        // Run a command with the global options: `--trace=file` (spans of snn are recorded
+        // in-process, compiles and links are appended to an events file, set in the environment,
+        // by `snn timed`) and `--stats` (time per phase of snn and counters of its work).
+        int instrumented_command(const cstrview program_name,
+                                 const array_view<const env::argument> arguments,
+                                 const str& trace_file, const bool print_stats)
+        {
+            str events;
+            if (trace_file)
+            {
+                events = concat(app::current_directory(), "/", app::temporary_file_name(".trace"));
+                if (::setenv("SNN_TRACE_EVENTS", events.null_terminated().get(), 1) != 0)
+                {
+                    fmt::print_error_line("Error: Failed to set SNN_TRACE_EVENTS (errno {})",
+                                          errno);
+                    return constant::exit::failure;
+                }
+            }
+
+            trace::recorder& recorder = trace::global();
+            recorder.enable();
+
+            const u64 start       = clock::monotonic();
+            const int exit_status = app::dispatch(program_name, arguments);
+            const u64 total_ns    = clock::monotonic() - start;
+
+            if (print_stats)
+            {
+                fmt::print_error_line("Statistics of {}:", program_name);
+                file::standard::error{} << stats::format(stats::phases(recorder.spans()),
+                                                         stats::global(), total_ns);
+            }
+
+            if (trace_file)
+            {
+                strbuf contents;
+                if (file::read(events, contents))
+                {
+                    if (!recorder.parse(contents))
+                    {
+                        fmt::print_error_line("Warning: Ignoring invalid trace events: {}", events);
+                    }
+                    file::remove(events).or_throw();
+                }
+
+                if (!file::write(trace_file, recorder.json()))
+                {
+                    fmt::print_error_line("Error: Failed to write trace: {}", trace_file);
+                    return constant::exit::failure;
+                }
+            }
+
+            return exit_status;
+        }
     }
 }
 
@@ -1725,50 +6514,37 @@ namespace snn
         const auto program_name = arguments.front().value_or_default().to<cstrview>();
         arguments.drop_front_n(1);
 
-        if (arguments)
+        // Global options (before the command).
+        str trace_file;
+        bool print_stats = false;
+        while (arguments)
         {
-            const auto command = arguments.front().value().to<cstrview>();
-
-            if (command == "build")
-            {
-                return app::build(program_name, arguments);
-            }
-
-            if (command == "gen")
+            const auto option = arguments.front().value().to<cstrview>();
+            if (option.has_front("--trace="))
             {
-                return app::gen(program_name, arguments);
+                trace_file = str{option.view(string_size("--trace="))};
+                if (!app::validator::is_file_path(trace_file))
+                {
+                    fmt::print_error_line("Error: Invalid trace file name: {}", trace_file);
+                    return constant::exit::failure;
+                }
             }
-
-            if (command == "run")
+            else if (option == "--stats")
             {
-                return app::run(program_name, arguments);
+                print_stats = true;
             }
-
-            if (command == "runall")
+            else
             {
-                return app::runall(program_name, arguments);
+                break;
             }
+            arguments.drop_front_n(1);
         }
 
-        strbuf usage{container::reserve, 300};
-
-        usage << "Usage: " << program_name << " <command> [arguments]\n";
-
-        usage << "\n";
-
-        usage << "Commands:\n";
-        usage << "build   Build one or more applications\n";
-        usage << "gen     Generate a makefile for one or more applications\n";
-        usage << "run     Build and run a single application with optional arguments\n";
-        usage << "runall  Build and run one or more applications\n";
-
-        usage << "\n";
-
-        usage << "For more information run a command without arguments, e.g.:\n";
-        usage << program_name << " build\n";
-
-        file::standard::error{} << usage;
+        if (trace_file || print_stats)
+        {
+            return app::instrumented_command(program_name, arguments, trace_file, print_stats);
+        }
 
-        return constant::exit::failure;
+        return app::dispatch(program_name, arguments);
     }
 }
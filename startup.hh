@@ -0,0 +1,301 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/ascii/trim.hh"
+#include "snn-core/set/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+#include "build-tool/report.hh"
+
+namespace snn::app::startup
+{
+    // Startup cost of a single run, from the startup probe report (see
+    // `preload::startup_source`) and the dynamic loader statistics (glibc `LD_DEBUG=statistics`).
+    class report final
+    {
+      public:
+        [[nodiscard]] bool parse_probe(const cstrview contents)
+        {
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                const usize pos = line.find('\t').value_or_npos();
+                if (pos == constant::npos)
+                {
+                    return false;
+                }
+
+                const cstrview key = line.view(0, pos);
+                const auto value   = number::parse(line.view(pos + 1));
+                if (!value)
+                {
+                    return false;
+                }
+
+                if (key == "constructor")
+                {
+                    constructor_ns_ = value.value(promise::has_value);
+                }
+                else if (key == "main")
+                {
+                    main_ns_ = value.value(promise::has_value);
+                }
+                else if (key == "exit")
+                {
+                    exit_ns_ = value.value(promise::has_value);
+                }
+                else if (key == "objects")
+                {
+                    objects_ = value.value(promise::has_value);
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Lines look like: "   4711:\t  number of relocations: 123". Unknown lines are ignored.
+        void parse_loader_statistics(const cstrview contents)
+        {
+            for (cstrview line : string::range::split{contents, '\n'})
+            {
+                const usize pid_end = line.find(':').value_or_npos();
+                if (pid_end == constant::npos)
+                {
+                    continue;
+                }
+                line = line.view(pid_end + 1);
+                ascii::trim_inplace(line);
+
+                const usize pos = line.find(": ").value_or_npos();
+                if (pos == constant::npos)
+                {
+                    continue;
+                }
+
+                const cstrview key = line.view(0, pos);
+                cstrview value     = line.view(pos + 2);
+                ascii::trim_inplace(value);
+
+                if (key == "total startup time in dynamic loader")
+                {
+                    loader_time_ = value;
+                }
+                else if (key == "time needed for relocation")
+                {
+                    relocation_share_ = share_(value);
+                }
+                else if (key == "time needed to load objects")
+                {
+                    load_share_ = share_(value);
+                }
+                else if (key == "number of relocations")
+                {
+                    relocations_ = number::parse(value).value_or(0);
+                }
+                else if (key == "number of relocations from cache")
+                {
+                    cached_relocations_ = number::parse(value).value_or(0);
+                }
+                else if (key == "number of relative relocations")
+                {
+                    relative_relocations_ = number::parse(value).value_or(0);
+                }
+                else if (key == "final number of relocations")
+                {
+                    final_relocations_ = number::parse(value).value_or(0);
+                }
+            }
+        }
+
+        [[nodiscard]] bool has_loader_statistics() const noexcept
+        {
+            return !loader_time_.is_empty();
+        }
+
+        // `spawn_ns` and `end_ns` are CLOCK_MONOTONIC times taken just before spawning and just
+        // after reaping the process. `libraries` are the `LIBn` libraries of the application.
+        [[nodiscard]] strbuf format(const u64 spawn_ns, const u64 end_ns,
+                                    const set::sorted<str>& libraries) const
+        {
+            strbuf out{container::reserve, constant::size::kibibyte<usize>};
+
+            const u64 total = span_(spawn_ns, end_ns);
+            if (constructor_ns_ == 0)
+            {
+                fmt::format_append("Startup probe was not loaded (statically linked?), total: {}\n",
+                                   out, promise::no_overlap, report::duration(total));
+                return out;
+            }
+
+            const u64 loading = span_(spawn_ns, constructor_ns_);
+            const u64 initializers = main_ns_ > 0 ? span_(constructor_ns_, main_ns_) : 0;
+
+            report::table t;
+            t.add_row("Time", "Share", "Phase");
+            t.add_row(report::duration(loading), report::percent(loading, total),
+                      "exec, loading and relocation");
+            if (main_ns_ > 0)
+            {
+                const u64 in_main = span_(main_ns_, exit_ns_);
+                t.add_row(report::duration(initializers), report::percent(initializers, total),
+                          "static initializers");
+                t.add_row(report::duration(in_main), report::percent(in_main, total), "main");
+            }
+            else
+            {
+                const u64 in_main = span_(constructor_ns_, exit_ns_);
+                t.add_row(report::duration(in_main), report::percent(in_main, total),
+                          "static initializers and main");
+            }
+            const u64 exiting = span_(exit_ns_, end_ns);
+            t.add_row(report::duration(exiting), report::percent(exiting, total),
+                      "exit (destructors, teardown)");
+            t.add_row(report::duration(total), "", "total");
+            out << t.format();
+
+            if (has_loader_statistics())
+            {
+                fmt::format_append("Loader: {} (relocation {}, loading objects {})\n", out,
+                                   promise::no_overlap, loader_time_,
+                                   tenths_(relocation_share_), tenths_(load_share_));
+                fmt::format_append("Relocations: {} (relative {}, from cache {}", out,
+                                   promise::no_overlap, relocations_, relative_relocations_,
+                                   cached_relocations_);
+                if (final_relocations_ > 0)
+                {
+                    fmt::format_append(", final {}", out, promise::no_overlap,
+                                       final_relocations_);
+                }
+                out << ")\n";
+            }
+
+            fmt::format_append("Loaded objects: {}, libraries (LIBn):", out, promise::no_overlap,
+                               objects_);
+            if (libraries)
+            {
+                for (const auto& lib : libraries)
+                {
+                    out << " -l" << lib;
+                }
+            }
+            else
+            {
+                out << " none";
+            }
+            out << '\n';
+
+            out << "Suggestions:\n";
+            bool suggested = false;
+
+            if (is_at_least_(loading, total, 500))
+            {
+                fmt::format_append("- Loading and relocation take {} of the run time, link "
+                                   "statically (-static) to skip the dynamic loader",
+                                   out, promise::no_overlap, report::percent(loading, total));
+                if (libraries)
+                {
+                    out << " or drop libraries that are not needed";
+                }
+                out << ".\n";
+                suggested = true;
+            }
+
+            if (relocation_share_ >= 300)
+            {
+                fmt::format_append("- Symbol relocation takes {} of the loader time, reduce "
+                                   "exported symbols (-fvisibility=hidden) or link statically "
+                                   "(prelinking is unmaintained and does not apply to PIE).\n",
+                                   out, promise::no_overlap, tenths_(relocation_share_));
+                suggested = true;
+            }
+
+            if (final_relocations_ > relocations_)
+            {
+                fmt::format_append("- {} symbols were bound lazily after startup, -Wl,-z,now would "
+                                   "move that cost to startup (only worth it for long-running "
+                                   "processes).\n",
+                                   out, promise::no_overlap, final_relocations_ - relocations_);
+                suggested = true;
+            }
+
+            if (is_at_least_(initializers, total, 200))
+            {
+                fmt::format_append("- Static initializers take {} of the run time, avoid global "
+                                   "objects with dynamic initialization.\n",
+                                   out, promise::no_overlap, report::percent(initializers, total));
+                suggested = true;
+            }
+
+            if (!suggested)
+            {
+                out << "- None, no startup phase dominates.\n";
+            }
+
+            return out;
+        }
+
+      private:
+        u64 constructor_ns_ = 0;
+        u64 main_ns_        = 0;
+        u64 exit_ns_        = 0;
+        u64 objects_        = 0;
+
+        str loader_time_;
+        u64 relocation_share_     = 0; // Tenths of a percent.
+        u64 load_share_           = 0; // Tenths of a percent.
+        u64 relocations_          = 0;
+        u64 relative_relocations_ = 0;
+        u64 cached_relocations_   = 0;
+        u64 final_relocations_    = 0;
+
+        static bool is_at_least_(const u64 part, const u64 total, const u64 tenths) noexcept
+        {
+            return total > 0 && part * 1000 >= total * tenths;
+        }
+
+        // "123 cycles (37.0%)" -> 370
+        static u64 share_(const cstrview value) noexcept
+        {
+            const usize open  = value.find('(').value_or_npos();
+            const usize close = value.find("%)").value_or_npos();
+            if (open == constant::npos || close == constant::npos || close < open)
+            {
+                return 0;
+            }
+
+            const cstrview percent = value.view(open + 1, close - open - 1);
+            const usize point      = percent.find('.').value_or_npos();
+            if (point == constant::npos)
+            {
+                return number::parse(percent).value_or(0) * 10;
+            }
+
+            const u64 whole = number::parse(percent.view(0, point)).value_or(0);
+            const u64 tenth = number::parse(percent.view(point + 1, 1)).value_or(0);
+            return whole * 10 + tenth;
+        }
+
+        static u64 span_(const u64 from, const u64 to) noexcept
+        {
+            return to > from ? to - from : 0;
+        }
+
+        static str tenths_(const u64 tenths)
+        {
+            str s;
+            s << as_num(tenths / 10) << '.' << as_num(tenths % 10) << '%';
+            return s;
+        }
+    };
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/startup.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            app::startup::report r;
+            snn_require(r.parse_probe("constructor\t3000000\n"
+                                      "main\t3500000\n"
+                                      "exit\t4000000\n"
+                                      "objects\t6\n"));
+
+            snn_require(!r.has_loader_statistics());
+            r.parse_loader_statistics(
+                "     4711:\t\n"
+                "     4711:\truntime linker statistics:\n"
+                "     4711:\t  total startup time in dynamic loader: 1234567 cycles\n"
+                "     4711:\t            time needed for relocation: 617283 cycles (50.0%)\n"
+                "     4711:\t                 number of relocations: 120\n"
+                "     4711:\t      number of relocations from cache: 3\n"
+                "     4711:\t        number of relative relocations: 1500\n"
+                "     4711:\t           time needed to load objects: 370370 cycles (30.0%)\n"
+                "     4711:\t\n"
+                "     4711:\truntime linker statistics:\n"
+                "     4711:\t           final number of relocations: 150\n"
+                "     4711:\tfinal number of relocations from cache: 3\n");
+            snn_require(r.has_loader_statistics());
+
+            set::sorted<str> libraries;
+            libraries.insert("ssl");
+            libraries.insert("crypto");
+
+            snn_require(r.format(1'000'000, 5'000'000, libraries) ==
+                        "  Time  Share  Phase\n"
+                        "  2 ms  50.0%  exec, loading and relocation\n"
+                        "500 us  12.5%  static initializers\n"
+                        "500 us  12.5%  main\n"
+                        "  1 ms  25.0%  exit (destructors, teardown)\n"
+                        "  4 ms         total\n"
+                        "Loader: 1234567 cycles (relocation 50.0%, loading objects 30.0%)\n"
+                        "Relocations: 120 (relative 1500, from cache 3, final 150)\n"
+                        "Loaded objects: 6, libraries (LIBn): -lcrypto -lssl\n"
+                        "Suggestions:\n"
+                        "- Loading and relocation take 50.0% of the run time, link statically"
+                        " (-static) to skip the dynamic loader or drop libraries that are not"
+                        " needed.\n"
+                        "- Symbol relocation takes 50.0% of the loader time, reduce exported"
+                        " symbols (-fvisibility=hidden) or link statically (prelinking is"
+                        " unmaintained and does not apply to PIE).\n"
+                        "- 30 symbols were bound lazily after startup, -Wl,-z,now would move"
+                        " that cost to startup (only worth it for long-running processes).\n");
+        }
+        {
+            // No `main` timestamp (not glibc) and no loader statistics.
+            app::startup::report r;
+            snn_require(r.parse_probe("constructor\t1100\nmain\t0\nexit\t9000\nobjects\t2\n"));
+            snn_require(r.format(1000, 10'000, {}) ==
+                        "Time  Share  Phase\n"
+                        "0 us   1.1%  exec, loading and relocation\n"
+                        "7 us  87.8%  static initializers and main\n"
+                        "1 us  11.1%  exit (destructors, teardown)\n"
+                        "9 us         total\n"
+                        "Loaded objects: 2, libraries (LIBn): none\n"
+                        "Suggestions:\n"
+                        "- None, no startup phase dominates.\n");
+        }
+        {
+            app::startup::report r;
+            snn_require(r.format(0, 4'000'000, {}) ==
+                        "Startup probe was not loaded (statically linked?), total: 4 ms\n");
+            snn_require(!r.parse_probe("constructor\tabc\n"));
+            snn_require(!r.parse_probe("unknown\t1\n"));
+        }
+    }
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/map/sorted.hh"
+#include "build-tool/clock.hh"
+#include "build-tool/report.hh"
+#include "build-tool/trace.hh"
+
+namespace snn::app::stats
+{
+    // Statistics of snn's own work (`--stats`), to tell if snn or the compiler is the bottleneck.
+    // The time of each phase comes from the spans of snn itself (see `trace::scope`).
+
+    struct counters final
+    {
+        u64 files_scanned      = 0;
+        u64 bytes_read         = 0;
+        u64 file_checks        = 0; // Existence checks and path resolutions (`realpath()`).
+        u64 preprocessor_lines = 0; // Lines evaluated by `app::preprocessor`.
+        u64 graph_files        = 0; // Dependency graph when the makefile was generated.
+        u64 graph_edges        = 0; // Header and source file dependencies.
+        u64 closure_calls      = 0; // Transitive dependencies computed.
+        u64 closure_ns         = 0;
+        u64 makefile_bytes     = 0;
+    };
+
+    // The counters of this process.
+    [[nodiscard]] inline counters& global() noexcept
+    {
+        static counters c;
+        return c;
+    }
+
+    // Add the time from construction to destruction to `total` (and count it).
+    class timer final
+    {
+      public:
+        explicit timer(u64& total, u64& count) noexcept
+            : total_{total},
+              start_{clock::monotonic()}
+        {
+            ++count;
+        }
+
+        ~timer()
+        {
+            total_ += clock::monotonic() - start_;
+        }
+
+        // Non-copyable
+        timer(const timer&)            = delete;
+        timer& operator=(const timer&) = delete;
+
+        // Non-movable
+        timer(timer&&)            = delete;
+        timer& operator=(timer&&) = delete;
+
+      private:
+        u64& total_;
+        u64 start_;
+    };
+
+    struct phase final
+    {
+        str category;
+        u64 duration = 0; // Nanoseconds, spans nested in a span of the same category not included.
+        usize count  = 0; // Spans, including nested.
+    };
+
+    // Time per category of the spans of snn itself (spans in a group are not included), in order
+    // of first appearance.
+    [[nodiscard]] inline vec<phase> phases(const vec<trace::span>& spans)
+    {
+        vec<usize> order;
+        for (usize i = 0; i < spans.count(); ++i)
+        {
+            if (spans.at(i, promise::within_bounds).group.is_empty())
+            {
+                order.append(i);
+            }
+        }
+
+        // Outer spans first.
+        algo::sort(order.range(), [&](const usize a, const usize b) {
+            const trace::span& sa = spans.at(a, promise::within_bounds);
+            const trace::span& sb = spans.at(b, promise::within_bounds);
+            if (sa.start != sb.start)
+            {
+                return sa.start < sb.start;
+            }
+            return sa.duration > sb.duration;
+        });
+
+        vec<phase> result;
+        map::sorted<str, usize> index; // Category -> index in `result`.
+        map::sorted<str, u64> covered; // Category -> end of the last outermost span.
+        for (const usize i : order)
+        {
+            const trace::span& s = spans.at(i, promise::within_bounds);
+
+            usize pos = 0;
+            if (const auto existing = index.get(s.category))
+            {
+                pos = existing.value();
+            }
+            else
+            {
+                pos = result.count();
+                index.insert_or_assign(s.category, pos);
+                result.append(phase{s.category, 0, 0});
+            }
+
+            phase& p = result.at(pos, promise::within_bounds);
+            ++p.count;
+
+            if (s.start >= covered.get(s.category).value_or(0))
+            {
+                p.duration += s.duration;
+                covered.insert_or_assign(s.category, s.start + s.duration);
+            }
+        }
+        return result;
+    }
+
+    // Breakdown of a command that took `total_ns`, e.g.:
+    //   Time  Share  Count  Phase
+    //  48 ms   2.3%      1  probe
+    // 1.92 s  92.1%      3  make
+    [[nodiscard]] inline strbuf format(const vec<phase>& phases, const counters& c,
+                                       const u64 total_ns)
+    {
+        const auto number = [](const u64 n) {
+            str s;
+            s << as_num(n);
+            return s;
+        };
+
+        report::table table;
+        table.add_row("Time", "Share", "Count", "Phase");
+        for (const auto& p : phases)
+        {
+            table.add_row(report::duration(p.duration), report::percent(p.duration, total_ns),
+                          number(p.count), p.category);
+        }
+        table.add_row(report::duration(total_ns), report::percent(total_ns, total_ns), "",
+                      "total");
+
+        strbuf out{container::reserve, 1024};
+        out << table.format();
+        out << "Files scanned: " << as_num(c.files_scanned) << " (" << report::bytes(c.bytes_read)
+            << "), file checks: " << as_num(c.file_checks)
+            << ", preprocessor lines: " << as_num(c.preprocessor_lines) << '\n';
+        out << "Dependency graph: " << as_num(c.graph_files) << " files, "
+            << as_num(c.graph_edges) << " edges, " << as_num(c.closure_calls) << " closures in "
+            << report::duration(c.closure_ns) << '\n';
+        out << "Makefile: " << report::bytes(c.makefile_bytes) << '\n';
+        return out;
+    }
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/stats.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            vec<app::trace::span> spans;
+            // Nested scans (a.cc includes b.hh), recorded innermost first.
+            spans.append(app::trace::span{str{}, str{"scan"}, str{"b.hh"}, 120, 30});
+            spans.append(app::trace::span{str{}, str{"scan"}, str{"a.cc"}, 100, 100});
+            spans.append(app::trace::span{str{}, str{"probe"}, str{"clang++"}, 0, 50});
+            spans.append(app::trace::span{str{}, str{"scan"}, str{"c.cc"}, 300, 20});
+            spans.append(app::trace::span{str{"make"}, str{"compile"}, str{"a.o"}, 400, 900});
+
+            const auto phases = app::stats::phases(spans);
+            snn_require(phases.count() == 2);
+            snn_require(phases.at(0).value().category == "probe");
+            snn_require(phases.at(0).value().duration == 50);
+            snn_require(phases.at(0).value().count == 1);
+            snn_require(phases.at(1).value().category == "scan");
+            snn_require(phases.at(1).value().duration == 120);
+            snn_require(phases.at(1).value().count == 3);
+
+            app::stats::counters c;
+            c.files_scanned      = 3;
+            c.bytes_read         = 2048;
+            c.file_checks        = 7;
+            c.preprocessor_lines = 42;
+            c.graph_files        = 3;
+            c.graph_edges        = 2;
+            c.makefile_bytes     = 512;
+
+            const auto out = app::stats::format(phases, c, 2'000'000);
+            snn_require(out.view().has_front("Time   Share  Count  Phase\n"
+                                             "0 us    0.0%      1  probe\n"));
+            snn_require(out.view().contains("\n2 ms  100.0%         total\n"));
+            snn_require(out.view().contains("Files scanned: 3 (2.0 KiB), file checks: 7,"
+                                            " preprocessor lines: 42\n"));
+            snn_require(out.view().contains("Dependency graph: 3 files, 2 edges, 0 closures"));
+            snn_require(out.view().has_back("Makefile: 512 B\n"));
+        }
+        {
+            u64 total = 0;
+            u64 count = 0;
+            {
+                const app::stats::timer t{total, count};
+            }
+            snn_require(count == 1);
+        }
+    }
+}
@@ -0,0 +1,176 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/map/sorted.hh"
+#include "build-tool/json.hh"
+
+namespace snn::app::timetrace
+{
+    // Compile time breakdown aggregated from the `clang -ftime-trace` output (one JSON file in the
+    // Chrome trace event format per translation unit).
+
+    struct cost final
+    {
+        u64 microseconds = 0;
+        usize count      = 0; // Events, e.g. translation units that parsed a header.
+    };
+
+    struct ranked final
+    {
+        cstrview name;
+        cost total;
+    };
+
+    class aggregate final
+    {
+      public:
+        // Add the trace of a translation unit, false if it isn't valid JSON.
+        [[nodiscard]] bool add(const cstrview trace)
+        {
+            json::reader r{trace};
+            r.object([&](const cstrview key, json::reader& events) {
+                if (key != "traceEvents")
+                {
+                    return;
+                }
+
+                events.array([&](json::reader& event) {
+                    str name;
+                    str phase;
+                    str detail;
+                    u64 duration = 0;
+                    event.object([&](const cstrview k, json::reader& v) {
+                        if (k == "name")
+                        {
+                            name = v.string().value_or_default();
+                        }
+                        else if (k == "ph")
+                        {
+                            phase = v.string().value_or_default();
+                        }
+                        else if (k == "dur")
+                        {
+                            duration = v.integer().value_or(0);
+                        }
+                        else if (k == "args")
+                        {
+                            v.object([&](const cstrview ak, json::reader& av) {
+                                if (ak == "detail")
+                                {
+                                    detail = av.string().value_or_default();
+                                }
+                            });
+                        }
+                    });
+
+                    if (phase == "X")
+                    {
+                        add_event_(name, detail, duration);
+                    }
+                });
+            });
+
+            if (r.is_valid())
+            {
+                ++units_;
+                return true;
+            }
+            return false;
+        }
+
+        // Parse time of each header (including the headers it includes).
+        [[nodiscard]] const map::sorted<str, cost>& headers() const noexcept
+        {
+            return headers_;
+        }
+
+        // Time of each template instantiation (class or function, including nested
+        // instantiations).
+        [[nodiscard]] const map::sorted<str, cost>& templates() const noexcept
+        {
+            return templates_;
+        }
+
+        [[nodiscard]] u64 frontend_microseconds() const noexcept
+        {
+            return frontend_;
+        }
+
+        [[nodiscard]] u64 backend_microseconds() const noexcept
+        {
+            return backend_;
+        }
+
+        [[nodiscard]] usize units() const noexcept
+        {
+            return units_;
+        }
+
+      private:
+        map::sorted<str, cost> headers_;
+        map::sorted<str, cost> templates_;
+        u64 frontend_ = 0;
+        u64 backend_  = 0;
+        usize units_  = 0;
+
+        void add_event_(const cstrview name, const cstrview detail, const u64 duration)
+        {
+            if (name == "Frontend")
+            {
+                frontend_ += duration;
+            }
+            else if (name == "Backend")
+            {
+                backend_ += duration;
+            }
+            else if (!detail.is_empty() && name == "Source")
+            {
+                add_cost_(headers_, detail, duration);
+            }
+            else if (!detail.is_empty() &&
+                     (name == "InstantiateClass" || name == "InstantiateFunction"))
+            {
+                add_cost_(templates_, detail, duration);
+            }
+        }
+
+        static void add_cost_(map::sorted<str, cost>& costs, const cstrview key,
+                              const u64 duration)
+        {
+            cost& c = costs.insert_inplace(key).value();
+            c.microseconds += duration;
+            ++c.count;
+        }
+    };
+
+    // The (at most) `count` most expensive, by total time.
+    [[nodiscard]] inline vec<ranked> top(const map::sorted<str, cost>& costs, const usize count)
+    {
+        vec<ranked> all{container::reserve, costs.count()};
+        for (const auto& p : costs)
+        {
+            all.append(ranked{p.first.view(), p.second});
+        }
+
+        algo::sort(all.range(), [](const ranked& a, const ranked& b) {
+            return a.total.microseconds > b.total.microseconds ||
+                   (a.total.microseconds == b.total.microseconds && a.name < b.name);
+        });
+
+        vec<ranked> result{container::reserve, math::min(count, all.count())};
+        for (const auto& r : all)
+        {
+            if (result.count() == count)
+            {
+                break;
+            }
+            result.append(r);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/timetrace.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            app::timetrace::aggregate a;
+            snn_require(a.add(R"({"traceEvents":[
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":900,"name":"Source","args":{"detail":"a.hh"}},
+{"pid":1,"tid":1,"ph":"X","ts":10,"dur":300,"name":"Source","args":{"detail":"b.hh"}},
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":200,"name":"InstantiateClass",
+ "args":{"detail":"std::vector<int>"}},
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":1500,"name":"Frontend"},
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":700,"name":"Backend"},
+{"pid":1,"tid":2,"ph":"X","ts":0,"dur":900,"name":"Total Source","args":{"count":2}},
+{"pid":1,"tid":1,"ph":"M","ts":0,"name":"thread_name","args":{"name":"clang"}}
+],"beginningOfTime":1}
+)"));
+            snn_require(a.add(R"({"traceEvents":[
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":400,"name":"Source","args":{"detail":"b.hh"}},
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":50,"name":"InstantiateFunction",
+ "args":{"detail":"std::sort<int *>"}},
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":100,"name":"InstantiateClass",
+ "args":{"detail":"std::vector<int>"}},
+{"pid":1,"tid":1,"ph":"X","ts":0,"dur":800,"name":"Frontend"}
+]})"));
+            snn_require(!a.add(R"({"traceEvents":[)"));
+
+            snn_require(a.units() == 2);
+            snn_require(a.frontend_microseconds() == 2300);
+            snn_require(a.backend_microseconds() == 700);
+            snn_require(a.headers().count() == 2);
+            snn_require(a.templates().count() == 2);
+
+            const auto headers = app::timetrace::top(a.headers(), 10);
+            snn_require(headers.count() == 2);
+            snn_require(headers.at(0).value().name == "a.hh");
+            snn_require(headers.at(0).value().total.microseconds == 900);
+            snn_require(headers.at(0).value().total.count == 1);
+            snn_require(headers.at(1).value().name == "b.hh");
+            snn_require(headers.at(1).value().total.microseconds == 700);
+            snn_require(headers.at(1).value().total.count == 2);
+
+            const auto templates = app::timetrace::top(a.templates(), 1);
+            snn_require(templates.count() == 1);
+            snn_require(templates.at(0).value().name == "std::vector<int>");
+            snn_require(templates.at(0).value().total.microseconds == 300);
+        }
+        {
+            const app::timetrace::aggregate a;
+            snn_require(app::timetrace::top(a.headers(), 10).is_empty());
+        }
+    }
+}
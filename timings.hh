@@ -0,0 +1,383 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/map/sorted.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/number.hh"
+
+namespace snn::app::timings
+{
+    // Lexically normalized absolute path, "." and ".." components are removed, e.g.
+    // ("/a/b", "../c/./d.o") -> "/a/c/d.o". The directory must be absolute.
+    [[nodiscard]] inline str absolute(const cstrview directory, const cstrview path)
+    {
+        vec<cstrview> components;
+
+        const auto add = [&components](const cstrview p) {
+            for (const cstrview component : string::range::split{p, '/'})
+            {
+                if (component.is_empty() || component == ".")
+                {
+                    continue;
+                }
+
+                if (component == "..")
+                {
+                    if (!components.is_empty())
+                    {
+                        components.drop_back_n(1);
+                    }
+                    continue;
+                }
+
+                components.append(component);
+            }
+        };
+
+        if (!path.has_front('/'))
+        {
+            add(directory);
+        }
+        add(path);
+
+        str s;
+        for (const cstrview component : components)
+        {
+            s << '/' << component;
+        }
+        if (s.is_empty())
+        {
+            s << '/';
+        }
+        return s;
+    }
+
+    // Relative path from a directory to a path, both absolute and normalized (see `absolute()`),
+    // e.g. ("/a/b", "/a/c/d.cc") -> "../c/d.cc".
+    [[nodiscard]] inline str relative(const cstrview directory, const cstrview path)
+    {
+        vec<cstrview> from;
+        for (const cstrview component : string::range::split{directory, '/'})
+        {
+            if (component)
+            {
+                from.append(component);
+            }
+        }
+
+        vec<cstrview> to;
+        for (const cstrview component : string::range::split{path, '/'})
+        {
+            if (component)
+            {
+                to.append(component);
+            }
+        }
+
+        usize common = 0;
+        while (common < from.count() && common < to.count() &&
+               from.at(common, promise::within_bounds) == to.at(common, promise::within_bounds))
+        {
+            ++common;
+        }
+
+        str s;
+        for (usize i = common; i < from.count(); ++i)
+        {
+            s << "../";
+        }
+        for (usize i = common; i < to.count(); ++i)
+        {
+            if (i > common)
+            {
+                s << '/';
+            }
+            s << to.at(i, promise::within_bounds);
+        }
+        return s;
+    }
+
+    // Keys for the timing files: paths relative to the workspace (the directory with the compiler
+    // config file), so that the files can be shared between checkouts (e.g. CI workers).
+    class keys final
+    {
+      public:
+        // The workspace can be relative to the current directory (absolute).
+        explicit keys(const cstrview current_directory, const cstrview workspace)
+            : directory_{current_directory},
+              workspace_{absolute(current_directory, workspace)}
+        {
+        }
+
+        // Path relative to the current directory -> key.
+        [[nodiscard]] str key(const cstrview path) const
+        {
+            return relative(workspace_, absolute(directory_, path));
+        }
+
+        // Key -> path relative to the current directory.
+        [[nodiscard]] str path(const cstrview key) const
+        {
+            return relative(directory_, absolute(workspace_, key));
+        }
+
+      private:
+        str directory_;
+        str workspace_;
+    };
+
+    // Estimated wall time of running jobs that take `times` on `workers` parallel workers, longest
+    // first (LPT, each job goes to the least loaded worker).
+    [[nodiscard]] inline u64 makespan(vec<u64> times, const usize workers)
+    {
+        algo::sort(times.range(), [](const u64 a, const u64 b) { return a > b; });
+
+        vec<u64> loads{container::reserve, math::max(usize{1}, workers)};
+        for (usize i = 0; i < math::max(usize{1}, workers); ++i)
+        {
+            loads.append(0);
+        }
+
+        for (const u64 d : times)
+        {
+            usize least = 0;
+            for (usize i = 1; i < loads.count(); ++i)
+            {
+                if (loads.at(i, promise::within_bounds) < loads.at(least, promise::within_bounds))
+                {
+                    least = i;
+                }
+            }
+            loads.at(least, promise::within_bounds) += d;
+        }
+
+        u64 longest = 0;
+        for (const u64 load : loads)
+        {
+            longest = math::max(longest, load);
+        }
+        return longest;
+    }
+
+    // Durations per target (see `keys`), e.g. compile and link times per object file and
+    // executable, recorded by `snn timed` (see the generated makefiles) as appended lines. The last
+    // line for a target wins.
+    class durations final
+    {
+      public:
+        // Format (tab separated): <nanoseconds> <target>
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                const auto tab = line.find('\t');
+                if (!tab)
+                {
+                    return false;
+                }
+
+                const usize pos     = tab.value(promise::has_value);
+                const auto duration = number::parse(line.view(0, pos));
+                const cstrview path = line.view(pos + 1);
+                if (!duration || path.is_empty())
+                {
+                    return false;
+                }
+
+                targets_.insert_or_assign(path, duration.value(promise::has_value));
+                ++lines_;
+            }
+            return true;
+        }
+
+        [[nodiscard]] optional<u64> get(const cstrview target) const
+        {
+            if (const auto duration = targets_.get(target))
+            {
+                return duration.value();
+            }
+            return nullopt;
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return targets_.count();
+        }
+
+        [[nodiscard]] const map::sorted<str, u64>& targets() const noexcept
+        {
+            return targets_;
+        }
+
+        // True if most of the parsed lines are superseded by later lines.
+        [[nodiscard]] bool needs_compaction() const noexcept
+        {
+            constexpr usize slack = 1000; // Arbitrary.
+            return lines_ > targets_.count() * 2 + slack;
+        }
+
+        [[nodiscard]] bool is_modified() const noexcept
+        {
+            return modified_;
+        }
+
+        void add(const cstrview target, const u64 nanoseconds)
+        {
+            targets_.insert_or_assign(target, nanoseconds);
+            ++lines_;
+            modified_ = true;
+        }
+
+        // One line per target (sorted).
+        [[nodiscard]] strbuf serialize() const
+        {
+            strbuf out{container::reserve, targets_.count() * 80};
+            for (const auto& p : targets_)
+            {
+                out << as_num(p.second) << '\t' << p.first << '\n';
+            }
+            return out;
+        }
+
+      private:
+        map::sorted<str, u64> targets_;
+        usize lines_   = 0;
+        bool modified_ = false;
+    };
+
+    // True if a run took `percent` longer than usual (and at least 10 ms longer, shorter
+    // differences are mostly noise).
+    [[nodiscard]] constexpr bool is_slower(const u64 usual_ns, const u64 ns,
+                                           const u64 percent) noexcept
+    {
+        constexpr u64 noise_ns = 10'000'000; // Arbitrary.
+        return ns > usual_ns + noise_ns && ns * 100 > usual_ns * (100 + percent);
+    }
+
+    // Recorded test runs per executable (see `keys`): moving averages of the wall time, the CPU
+    // time and the peak RSS, so that a single slow run doesn't dominate.
+    class test_history final
+    {
+      public:
+        struct entry final
+        {
+            u64 wall_ns = 0;
+            u64 cpu_ns  = 0;
+            u64 max_rss = 0; // Bytes.
+            u64 runs    = 0;
+        };
+
+        // Format (tab separated): <wall-ns> <cpu-ns> <max-rss-bytes> <runs> <key>
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            vec<cstrview> fields;
+            for (const cstrview line : string::range::split{contents, '\n'})
+            {
+                if (line.is_empty())
+                {
+                    continue;
+                }
+
+                fields.clear();
+                for (const cstrview field : string::range::split{line, '\t'})
+                {
+                    fields.append(field);
+                }
+
+                if (fields.count() != 5 || fields.at(4, promise::within_bounds).is_empty())
+                {
+                    return false;
+                }
+
+                entry e;
+                u64* const values[] = {&e.wall_ns, &e.cpu_ns, &e.max_rss, &e.runs};
+                for (usize i = 0; i < 4; ++i)
+                {
+                    const auto n = number::parse(fields.at(i, promise::within_bounds));
+                    if (!n)
+                    {
+                        return false;
+                    }
+                    *values[i] = n.value(promise::has_value);
+                }
+
+                entries_.insert_or_assign(fields.at(4, promise::within_bounds), e);
+            }
+            return true;
+        }
+
+        [[nodiscard]] optional<entry> get(const cstrview key) const
+        {
+            if (const auto e = entries_.get(key))
+            {
+                return e.value();
+            }
+            return nullopt;
+        }
+
+        [[nodiscard]] usize count() const noexcept
+        {
+            return entries_.count();
+        }
+
+        [[nodiscard]] bool is_modified() const noexcept
+        {
+            return modified_;
+        }
+
+        // Add a run (`run.runs` is ignored).
+        void add(const cstrview key, const entry& run)
+        {
+            auto& e        = entries_.insert_inplace(key).value();
+            const u64 runs = e.runs;
+            if (runs == 0)
+            {
+                e = run;
+            }
+            else
+            {
+                e.wall_ns = average_(e.wall_ns, run.wall_ns);
+                e.cpu_ns  = average_(e.cpu_ns, run.cpu_ns);
+                e.max_rss = average_(e.max_rss, run.max_rss);
+            }
+            e.runs    = runs + 1;
+            modified_ = true;
+        }
+
+        [[nodiscard]] strbuf serialize() const
+        {
+            strbuf out{container::reserve, entries_.count() * 100};
+            for (const auto& p : entries_)
+            {
+                const entry& e = p.second;
+                out << as_num(e.wall_ns) << '\t' << as_num(e.cpu_ns) << '\t' << as_num(e.max_rss)
+                    << '\t' << as_num(e.runs) << '\t' << p.first << '\n';
+            }
+            return out;
+        }
+
+      private:
+        map::sorted<str, entry> entries_;
+        bool modified_ = false;
+
+        // Exponential moving average (new runs weigh 1/4).
+        static constexpr u64 average_(const u64 average, const u64 value) noexcept
+        {
+            if (value >= average)
+            {
+                return average + (value - average) / 4;
+            }
+            return average - (average - value) / 4;
+        }
+    };
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/timings.hh"
+
+#include "snn-core/unittest.hh"
+#include <initializer_list>
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            snn_require(app::timings::absolute("/a/b", "c.o") == "/a/b/c.o");
+            snn_require(app::timings::absolute("/a/b", "./c.o") == "/a/b/c.o");
+            snn_require(app::timings::absolute("/a/b", "../c/./d.o") == "/a/c/d.o");
+            snn_require(app::timings::absolute("/a/b", "../../../c.o") == "/c.o");
+            snn_require(app::timings::absolute("/a/b", "/x//y.o") == "/x/y.o");
+            snn_require(app::timings::absolute("/a/b/", "c/") == "/a/b/c");
+            snn_require(app::timings::absolute("/", "..") == "/");
+        }
+        {
+            snn_require(app::timings::relative("/a/b", "/a/b/c.cc") == "c.cc");
+            snn_require(app::timings::relative("/a/b", "/a/c/d.cc") == "../c/d.cc");
+            snn_require(app::timings::relative("/a/b", "/c.cc") == "../../c.cc");
+            snn_require(app::timings::relative("/", "/a/b.cc") == "a/b.cc");
+            snn_require(app::timings::relative("/a/b", "/a/bc/d.cc") == "../bc/d.cc");
+        }
+        {
+            const app::timings::keys k{"/p/ws/build-tool", ".."};
+            snn_require(k.key("snn.o") == "build-tool/snn.o");
+            snn_require(k.key("../snn-core/vec.test") == "snn-core/vec.test");
+            snn_require(k.key("/p/ws/a/b.o") == "a/b.o");
+            snn_require(k.path("build-tool/snn") == "snn");
+            snn_require(k.path("snn-core/vec.test") == "../snn-core/vec.test");
+        }
+        {
+            const auto makespan = [](const std::initializer_list<u64> durations,
+                                     const usize workers) {
+                vec<u64> v;
+                for (const u64 d : durations)
+                {
+                    v.append(d);
+                }
+                return app::timings::makespan(std::move(v), workers);
+            };
+
+            snn_require(makespan({}, 4) == 0);
+            snn_require(makespan({5, 3, 2}, 1) == 10);
+            snn_require(makespan({5, 3, 2}, 0) == 10);
+            snn_require(makespan({5, 3, 2}, 2) == 5);
+            snn_require(makespan({2, 3, 5}, 2) == 5);
+            snn_require(makespan({7, 1, 1, 1}, 8) == 7);
+            snn_require(makespan({3, 3, 2, 2, 2}, 2) == 7);
+        }
+        {
+            app::timings::durations t;
+            snn_require(t.parse("1000\ta/b.o\n"
+                                "2000\ta/c.o\n"
+                                "3000\ta/b.o\n"));
+            snn_require(t.count() == 2);
+            snn_require(t.get("a/b.o").value() == 3000);
+            snn_require(t.get("a/c.o").value() == 2000);
+            snn_require(!t.get("a/d.o"));
+            snn_require(!t.needs_compaction());
+            snn_require(!t.is_modified());
+
+            t.add("a/app", 500);
+            snn_require(t.is_modified());
+            snn_require(t.serialize() == "500\ta/app\n"
+                                         "3000\ta/b.o\n"
+                                         "2000\ta/c.o\n");
+        }
+        {
+            app::timings::durations t;
+            snn_require(t.parse(""));
+            snn_require(!t.parse("1000\n"));
+            snn_require(!t.parse("x\ta/b.o\n"));
+            snn_require(!t.parse("1000\t\n"));
+        }
+        {
+            static_assert(!app::timings::is_slower(100'000'000, 140'000'000, 50));
+            static_assert(app::timings::is_slower(100'000'000, 160'000'000, 50));
+            static_assert(!app::timings::is_slower(1'000'000, 5'000'000, 50)); // Noise.
+            static_assert(app::timings::is_slower(0, 20'000'000, 50));
+        }
+        {
+            app::timings::test_history h;
+            snn_require(h.parse("1000\t800\t4096\t3\tpair/core.test\n"));
+            snn_require(h.count() == 1);
+            snn_require(!h.is_modified());
+
+            const auto e = h.get("pair/core.test").value();
+            snn_require(e.wall_ns == 1000);
+            snn_require(e.cpu_ns == 800);
+            snn_require(e.max_rss == 4096);
+            snn_require(e.runs == 3);
+            snn_require(!h.get("pair/common.test"));
+
+            h.add("pair/core.test", {2000, 400, 4096, 99});
+            h.add("pair/common.test", {500, 500, 1024, 99});
+            snn_require(h.is_modified());
+            snn_require(h.serialize() == "500\t500\t1024\t1\tpair/common.test\n"
+                                         "1250\t700\t4096\t4\tpair/core.test\n");
+        }
+        {
+            app::timings::test_history h;
+            snn_require(h.parse(""));
+            snn_require(!h.parse("1000\t800\t4096\t3\n"));
+            snn_require(!h.parse("1000\t800\t4096\tx\ta.test\n"));
+            snn_require(!h.parse("1000\t800\t4096\t3\t\n"));
+        }
+    }
+}
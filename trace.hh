@@ -0,0 +1,308 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "snn-core/strcore.hh"
+#include "snn-core/vec.hh"
+#include "snn-core/algo/sort.hh"
+#include "snn-core/string/range/split.hh"
+#include "build-tool/clock.hh"
+#include "build-tool/json.hh"
+#include "build-tool/number.hh"
+
+namespace snn::app::trace
+{
+    // Timeline of a command in the Chrome trace event format (JSON), for chrome://tracing or
+    // https://ui.perfetto.dev. Spans of snn itself are on one thread (and can be nested), spans
+    // that run in parallel (e.g. compiles under `make -j`) are in a group, where each span is
+    // put on the first free lane (job slot) when formatted.
+
+    struct span final
+    {
+        str group; // Empty for spans of snn itself.
+        str category;
+        str name;
+        u64 start    = 0; // `clock::monotonic()`
+        u64 duration = 0; // Nanoseconds
+    };
+
+    // Line for a span recorded by another process (e.g. `snn timed` under make), see
+    // `recorder::parse()`. Format (tab separated): <start> <duration> <group> <category> <name>
+    [[nodiscard]] inline str line(const cstrview group, const cstrview category,
+                                  const cstrview name, const u64 start, const u64 duration)
+    {
+        str s;
+        s << as_num(start) << '\t' << as_num(duration) << '\t' << group << '\t' << category
+          << '\t' << name << '\n';
+        return s;
+    }
+
+    // Lane of each span (in order) if the spans are put on the first free lane, by start time.
+    [[nodiscard]] inline vec<usize> lanes(const vec<const span*>& spans)
+    {
+        vec<usize> order{container::reserve, spans.count()};
+        for (usize i = 0; i < spans.count(); ++i)
+        {
+            order.append(i);
+        }
+        algo::sort(order.range(), [&](const usize a, const usize b) {
+            const u64 start_a = spans.at(a, promise::within_bounds)->start;
+            const u64 start_b = spans.at(b, promise::within_bounds)->start;
+            return start_a < start_b || (start_a == start_b && a < b);
+        });
+
+        vec<usize> lane{container::reserve, spans.count()};
+        for (usize i = 0; i < spans.count(); ++i)
+        {
+            lane.append(0);
+        }
+
+        vec<u64> ends; // Per lane.
+        for (const usize i : order)
+        {
+            const span& s = *spans.at(i, promise::within_bounds);
+
+            usize free = ends.count();
+            for (usize l = 0; l < ends.count(); ++l)
+            {
+                if (ends.at(l, promise::within_bounds) <= s.start)
+                {
+                    free = l;
+                    break;
+                }
+            }
+
+            if (free == ends.count())
+            {
+                ends.append(0);
+            }
+            ends.at(free, promise::within_bounds) = s.start + s.duration;
+            lane.at(i, promise::within_bounds)    = free;
+        }
+        return lane;
+    }
+
+    class recorder final
+    {
+      public:
+        [[nodiscard]] bool is_enabled() const noexcept
+        {
+            return enabled_;
+        }
+
+        void enable() noexcept
+        {
+            enabled_ = true;
+        }
+
+        [[nodiscard]] const vec<span>& spans() const noexcept
+        {
+            return spans_;
+        }
+
+        // A span of snn itself, nested spans must be properly nested.
+        void add(const cstrview category, const cstrview name, const u64 start,
+                 const u64 duration)
+        {
+            add(cstrview{}, category, name, start, duration);
+        }
+
+        // A span in a group of parallel spans (e.g. "make" or "test").
+        void add(const cstrview group, const cstrview category, const cstrview name,
+                 const u64 start, const u64 duration)
+        {
+            if (enabled_)
+            {
+                spans_.append(span{str{group}, str{category}, str{name}, start, duration});
+            }
+        }
+
+        // Add spans recorded by other processes (see `line()`), false if a line is invalid.
+        [[nodiscard]] bool parse(const cstrview contents)
+        {
+            vec<cstrview> fields;
+            for (const cstrview l : string::range::split{contents, '\n'})
+            {
+                if (l.is_empty())
+                {
+                    continue;
+                }
+
+                fields.clear();
+                for (const cstrview field : string::range::split{l, '\t'})
+                {
+                    fields.append(field);
+                }
+
+                if (fields.count() != 5)
+                {
+                    return false;
+                }
+
+                const auto start    = number::parse(fields.at(0, promise::within_bounds));
+                const auto duration = number::parse(fields.at(1, promise::within_bounds));
+                if (!start || !duration || fields.at(4, promise::within_bounds).is_empty())
+                {
+                    return false;
+                }
+
+                add(fields.at(2, promise::within_bounds), fields.at(3, promise::within_bounds),
+                    fields.at(4, promise::within_bounds), start.value(promise::has_value),
+                    duration.value(promise::has_value));
+            }
+            return true;
+        }
+
+        // Complete events ("ph": "X") with times in microseconds from the first span. Thread 1 is
+        // snn itself, each lane of a group is a thread of its own ("make 1", "make 2", ...).
+        [[nodiscard]] strbuf json() const
+        {
+            strbuf out{container::reserve, 200 + spans_.count() * 160};
+            out << "{\"traceEvents\":[\n";
+            out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+                   "\"args\":{\"name\":\"snn\"}},\n";
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,"
+                   "\"args\":{\"name\":\"snn\"}}";
+
+            u64 origin = constant::limit<u64>::max;
+            for (const auto& s : spans_)
+            {
+                origin = math::min(origin, s.start);
+            }
+
+            // Threads: snn, then the lanes of each group (in order of appearance).
+            vec<usize> threads{container::reserve, spans_.count()};
+            for (usize i = 0; i < spans_.count(); ++i)
+            {
+                threads.append(1);
+            }
+
+            usize next_thread = 2;
+            vec<bool> done{container::reserve, spans_.count()};
+            for (const auto& s : spans_)
+            {
+                done.append(s.group.is_empty());
+            }
+
+            for (usize i = 0; i < spans_.count(); ++i)
+            {
+                if (done.at(i, promise::within_bounds))
+                {
+                    continue;
+                }
+
+                const str& group = spans_.at(i, promise::within_bounds).group;
+
+                vec<usize> indexes;
+                vec<const span*> members;
+                for (usize j = i; j < spans_.count(); ++j)
+                {
+                    const span& s = spans_.at(j, promise::within_bounds);
+                    if (!done.at(j, promise::within_bounds) && s.group == group)
+                    {
+                        done.at(j, promise::within_bounds) = true;
+                        indexes.append(j);
+                        members.append(&s);
+                    }
+                }
+
+                const auto lane  = lanes(members);
+                usize lane_count = 0;
+                for (usize k = 0; k < indexes.count(); ++k)
+                {
+                    const usize l = lane.at(k, promise::within_bounds);
+                    threads.at(indexes.at(k, promise::within_bounds), promise::within_bounds) =
+                        next_thread + l;
+                    lane_count = math::max(lane_count, l + 1);
+                }
+
+                for (usize l = 0; l < lane_count; ++l)
+                {
+                    str thread_name{group};
+                    thread_name << ' ' << as_num(l + 1);
+
+                    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                        << as_num(next_thread + l) << ",\"args\":{\"name\":";
+                    json::append_string(thread_name, out);
+                    out << "}}";
+                }
+                next_thread += lane_count;
+            }
+
+            for (usize i = 0; i < spans_.count(); ++i)
+            {
+                const span& s = spans_.at(i, promise::within_bounds);
+                out << ",\n{\"name\":";
+                json::append_string(s.name, out);
+                out << ",\"cat\":";
+                json::append_string(s.category, out);
+                out << ",\"ph\":\"X\",\"ts\":";
+                append_microseconds_(s.start - origin, out);
+                out << ",\"dur\":";
+                append_microseconds_(s.duration, out);
+                out << ",\"pid\":1,\"tid\":" << as_num(threads.at(i, promise::within_bounds))
+                    << '}';
+            }
+
+            out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+            return out;
+        }
+
+      private:
+        vec<span> spans_;
+        bool enabled_ = false;
+
+        static void append_microseconds_(const u64 ns, strbuf& out)
+        {
+            const u64 fraction = ns % 1000;
+            out << as_num(ns / 1000) << '.';
+            if (fraction < 100)
+            {
+                out << (fraction < 10 ? "00" : "0");
+            }
+            out << as_num(fraction);
+        }
+    };
+
+    // The recorder of this process (disabled unless `--trace` is used).
+    [[nodiscard]] inline recorder& global() noexcept
+    {
+        static recorder r;
+        return r;
+    }
+
+    // Add a span of snn itself (see `global()`) from construction to destruction. The name must
+    // outlive the scope.
+    class scope final
+    {
+      public:
+        explicit scope(const cstrview category, const cstrview name) noexcept
+            : category_{category},
+              name_{name},
+              start_{global().is_enabled() ? clock::monotonic() : 0}
+        {
+        }
+
+        ~scope()
+        {
+            if (start_ > 0)
+            {
+                global().add(category_, name_, start_, clock::monotonic() - start_);
+            }
+        }
+
+        // Non-copyable
+        scope(const scope&)            = delete;
+        scope& operator=(const scope&) = delete;
+
+        // Non-movable
+        scope(scope&&)            = delete;
+        scope& operator=(scope&&) = delete;
+
+      private:
+        cstrview category_;
+        cstrview name_;
+        u64 start_;
+    };
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2022 Mikael Simonsson <https://mikaelsimonsson.com>.
+// SPDX-License-Identifier: BSL-1.0
+
+#include "build-tool/trace.hh"
+
+#include "snn-core/unittest.hh"
+
+namespace snn
+{
+    void unittest()
+    {
+        {
+            snn_require(app::trace::line("make", "compile", "a/b.o", 1000, 2000) ==
+                        "1000\t2000\tmake\tcompile\ta/b.o\n");
+        }
+        {
+            vec<app::trace::span> spans;
+            spans.append(app::trace::span{str{"make"}, str{"compile"}, str{"a.o"}, 0, 100});
+            spans.append(app::trace::span{str{"make"}, str{"compile"}, str{"b.o"}, 10, 50});
+            spans.append(app::trace::span{str{"make"}, str{"compile"}, str{"c.o"}, 60, 100});
+            spans.append(app::trace::span{str{"make"}, str{"link"}, str{"app"}, 160, 10});
+
+            vec<const app::trace::span*> pointers;
+            for (const auto& s : spans)
+            {
+                pointers.append(&s);
+            }
+
+            const auto lanes = app::trace::lanes(pointers);
+            snn_require(lanes.count() == 4);
+            snn_require(lanes.at(0).value() == 0);
+            snn_require(lanes.at(1).value() == 1);
+            snn_require(lanes.at(2).value() == 1); // b.o is done at 60.
+            snn_require(lanes.at(3).value() == 0);
+        }
+        {
+            app::trace::recorder r;
+            r.add("scan", "a.cc", 1000, 10);
+            snn_require(r.spans().is_empty()); // Disabled.
+
+            r.enable();
+            r.add("scan", "a.cc", 1000, 2500);
+            snn_require(r.parse("2000\t1000000\tmake\tcompile\ta.o\n"
+                                "2500\t1000000\tmake\tcompile\tb.o\n"));
+            snn_require(r.spans().count() == 3);
+            snn_require(r.spans().at(2).value().group == "make");
+            snn_require(r.spans().at(2).value().name == "b.o");
+
+            const auto json = r.json();
+            snn_require(json.view().has_front("{\"traceEvents\":[\n"));
+            snn_require(json.view().has_back("\n],\"displayTimeUnit\":\"ms\"}\n"));
+            snn_require(json.view().contains("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                                             "\"tid\":3,\"args\":{\"name\":\"make 2\"}}"));
+            snn_require(json.view().contains("{\"name\":\"a.cc\",\"cat\":\"scan\",\"ph\":\"X\","
+                                             "\"ts\":0.000,\"dur\":2.500,\"pid\":1,\"tid\":1}"));
+            snn_require(json.view().contains("{\"name\":\"b.o\",\"cat\":\"compile\",\"ph\":\"X\","
+                                             "\"ts\":1.500,\"dur\":1000.000,\"pid\":1,"
+                                             "\"tid\":3}"));
+
+            snn_require(!r.parse("1\t2\tmake\tcompile\n"));
+            snn_require(!r.parse("x\t2\tmake\tcompile\ta.o\n"));
+            snn_require(!r.parse("1\t2\tmake\tcompile\t\n"));
+        }
+        {
+            snn_require(!app::trace::global().is_enabled());
+            const app::trace::scope s{"scan", "a.cc"};
+        }
+        snn_require(app::trace::global().spans().is_empty());
+    }
+}
@@ -82,6 +82,22 @@ namespace snn::app
             return false;
         }
 
+        [[nodiscard]] static constexpr bool is_git_revision(const transient<cstrview> s) noexcept
+        {
+            // Match: [A-Za-z0-9][A-Za-z0-9._/~^@-]* (e.g. "HEAD~1" or "origin/main").
+            if (s.get().size() <= 100) // Arbitrary
+            {
+                auto rng = s.get().range();
+                if (rng.has_front_if(chr::is_alphanumeric))
+                {
+                    rng.pop_front_while(fn::is_any_of{
+                        chr::is_alphanumeric, fn::in_array{'.', '_', '/', '~', '^', '@', '-'}});
+                    return rng.is_empty();
+                }
+            }
+            return false;
+        }
+
         [[nodiscard]] static constexpr bool is_library(const transient<cstrview> s) noexcept
         {
             if (s.get().size() <= 40) // Arbitrary
@@ -109,6 +125,34 @@ namespace snn::app
             return false;
         }
 
+        [[nodiscard]] static constexpr bool is_optimization(const transient<cstrview> s) noexcept
+        {
+            // Match: O[0-3sz]|no-sanitize|(march|mtune)=[A-Za-z0-9][A-Za-z0-9._-]{0,39}
+            if (s.get() == "no-sanitize")
+            {
+                return true;
+            }
+
+            auto rng = s.get().range();
+            if (rng.drop_front('O'))
+            {
+                return rng.count() == 1 &&
+                       rng.has_front_if(fn::in_array{'0', '1', '2', '3', 's', 'z'});
+            }
+
+            if (rng.drop_front("march=") || rng.drop_front("mtune="))
+            {
+                if (rng.count() <= 40 && rng.has_front_if(chr::is_alphanumeric))
+                {
+                    rng.pop_front_while(
+                        fn::is_any_of{chr::is_alphanumeric, fn::in_array{'.', '_', '-'}});
+                    return rng.is_empty();
+                }
+            }
+
+            return false;
+        }
+
         [[nodiscard]] static constexpr bool is_reserved_target(
             const transient<cstrview> dir, const transient<cstrview> base) noexcept
         {
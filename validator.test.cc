@@ -92,6 +92,20 @@ namespace snn
         static_assert(!app::validator::is_file_path("/../"));
         static_assert(!app::validator::is_file_path("../."));
 
+        static_assert(app::validator::is_git_revision("HEAD"));
+        static_assert(app::validator::is_git_revision("HEAD~1"));
+        static_assert(app::validator::is_git_revision("HEAD^^"));
+        static_assert(app::validator::is_git_revision("origin/main"));
+        static_assert(app::validator::is_git_revision("v1.2.3"));
+        static_assert(app::validator::is_git_revision("a1b2c3d"));
+        static_assert(!app::validator::is_git_revision("main@{1}"));
+        static_assert(!app::validator::is_git_revision(""));
+        static_assert(!app::validator::is_git_revision("-p"));
+        static_assert(!app::validator::is_git_revision("--output=x"));
+        static_assert(!app::validator::is_git_revision("HEAD;ls"));
+        static_assert(!app::validator::is_git_revision("a b"));
+        static_assert(!app::validator::is_git_revision("$(ls)"));
+
         static_assert(app::validator::is_library("a"));
         static_assert(app::validator::is_library("A"));
         static_assert(app::validator::is_library("A.b"));
@@ -126,6 +140,29 @@ namespace snn
         static_assert(!app::validator::is_library("åäö"));
         static_assert(!app::validator::is_library("abcdefghijABCDEFGHIJabcdefghijABCDEFGHIJx"));
 
+        static_assert(app::validator::is_optimization("O0"));
+        static_assert(app::validator::is_optimization("O3"));
+        static_assert(app::validator::is_optimization("Os"));
+        static_assert(app::validator::is_optimization("Oz"));
+        static_assert(app::validator::is_optimization("no-sanitize"));
+        static_assert(app::validator::is_optimization("march=x86-64-v3"));
+        static_assert(app::validator::is_optimization("march=native"));
+        static_assert(app::validator::is_optimization("mtune=znver4"));
+        static_assert(app::validator::is_optimization("march=armv8.2-a"));
+
+        static_assert(!app::validator::is_optimization(""));
+        static_assert(!app::validator::is_optimization("O"));
+        static_assert(!app::validator::is_optimization("O4"));
+        static_assert(!app::validator::is_optimization("O33"));
+        static_assert(!app::validator::is_optimization("Ofast"));
+        static_assert(!app::validator::is_optimization("march="));
+        static_assert(!app::validator::is_optimization("march=-x"));
+        static_assert(!app::validator::is_optimization("march=x y"));
+        static_assert(!app::validator::is_optimization("march=x;ls"));
+        static_assert(!app::validator::is_optimization("march=$(ls)"));
+        static_assert(!app::validator::is_optimization("ffast-math"));
+        static_assert(!app::validator::is_optimization("fsanitize=address"));
+
         static_assert(app::validator::is_macro("__FOO__"));
         static_assert(app::validator::is_macro("BAR9"));
         static_assert(app::validator::is_macro("NDEBUG"));